@@ -0,0 +1,44 @@
+/*
+Compares two benchmark result files written by any of the benchmarks' '--save' option.
+
+Usage:
+    benchmark_compare <baseline.csv> <current.csv> [tolerance_percent]
+
+Exits with 1 if any result got worse by more than the tolerance (10% by default).
+*/
+
+#include <charconv>
+#include <iostream>
+#include <string_view>
+
+#include "benchmark_results.hpp"
+
+int main(int arg_count, const char **args)
+{
+	if (arg_count < 3 || arg_count > 4)
+	{
+		std::cerr << "Usage: benchmark_compare <baseline.csv> <current.csv> [tolerance_percent]\n";
+		return 2;
+	}
+
+	double tolerance_percent = 10.0;
+	if (arg_count == 4)
+	{
+		std::string_view tolerance = args[3];
+		auto result = std::from_chars(tolerance.data(), tolerance.data() + tolerance.size(),
+			tolerance_percent);
+		if (result.ec != std::errc())
+		{
+			std::cerr << "[ERROR] Tolerance must be a number\n";
+			return 2;
+		}
+	}
+
+	std::vector<Benchmark_Result> baseline, current;
+	if (!read_benchmark_results(args[1], baseline) || !read_benchmark_results(args[2], current))
+	{
+		return 2;
+	}
+
+	return compare_benchmark_results(baseline, current, tolerance_percent, std::cout) ? 0 : 1;
+}
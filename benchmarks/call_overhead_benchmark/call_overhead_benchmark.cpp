@@ -0,0 +1,342 @@
+/*
+Measures what a generated wrapper costs per call, compared with calling the client function
+directly. The registry is generated at build time by command_generator and Function Finder, see
+CMakeLists.txt for the number of commands.
+
+The registry is generated with '--command-ids=Benchmark_Command_Id', so calls by name can be
+compared with calls by id, and with '--binary-entries', so parsing text arguments can be compared
+with reading binary ones.
+
+Every measurement loops over all commands in the registry, so the numbers include the cache and
+branch predictor effects of a realistically sized registry rather than one hot command.
+
+Usage:
+    call_overhead_benchmark [options]
+
+    --rounds=<N>            Number of passes over all commands per measurement.
+    --save=<path>           Save the results as a baseline CSV.
+    --compare=<path>        Compare the results against a baseline CSV. Exits with 1 on regressions.
+    --tolerance=<percent>   How much worse a result may get before it's a regression. Defaults to 10.
+*/
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <string_view>
+
+#include "function_finder/function_finder.hpp"
+#include "function_finder/allocation_tracking.hpp"
+#include "function_finder/binary_arguments.hpp"
+#include "benchmark_commands_out.hpp"
+#include "synthetic_corpus.hpp"
+#include "benchmark_results.hpp"
+
+// Defined in the generated direct calls file.
+extern void (*const DIRECT_CALLS[])();
+
+// Counts the allocations of every measured operation.
+FUNCTION_FINDER_ALLOCATION_HOOKS
+
+/// <summary>
+/// Result of one measurement.
+/// </summary>
+struct Measurement
+{
+	double nanoseconds_per_call = 0;
+	double allocations_per_call = 0;
+	double allocated_bytes_per_call = 0;
+};
+
+/// <summary>
+/// Written to by every measured operation so the compiler can't remove them.
+/// </summary>
+volatile size_t sink = 0;
+
+/// <summary>
+/// Runs operation(i) for every command index, rounds times.
+/// </summary>
+template <typename Operation>
+Measurement measure(size_t command_count, size_t rounds, Operation operation)
+{
+	// Warm up caches and lazily initialized statics.
+	for (size_t i = 0; i < command_count; i++)
+	{
+		operation(i);
+	}
+
+	Allocation_Counters allocations_before = get_thread_allocation_counters();
+	auto start = std::chrono::steady_clock::now();
+	for (size_t round = 0; round < rounds; round++)
+	{
+		for (size_t i = 0; i < command_count; i++)
+		{
+			operation(i);
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	Allocation_Counters allocations = get_thread_allocation_counters() - allocations_before;
+
+	double calls = (double)(command_count * rounds);
+	Measurement measurement;
+	measurement.nanoseconds_per_call =
+		std::chrono::duration<double, std::nano>(end - start).count() / calls;
+	measurement.allocations_per_call = (double)allocations.allocations / calls;
+	measurement.allocated_bytes_per_call = (double)allocations.bytes / calls;
+	return measurement;
+}
+
+/// <summary>
+/// Splits a command line into arguments the same way a console would.
+/// </summary>
+void tokenize(std::string_view line, std::vector<std::string> &out_args)
+{
+	line = skip_whitespace(line);
+	while (!line.empty())
+	{
+		std::string word;
+		size_t length = get_string(line, word);
+		if (!length)
+		{
+			break;
+		}
+		out_args.push_back(std::move(word));
+		line = skip_whitespace(advance(line, length));
+	}
+}
+
+/// <summary>
+/// Encodes a benchmark argument for the binary entry points, with the same value as its text.
+/// </summary>
+void write_binary_benchmark_argument(std::string &out, Value_Type type)
+{
+	std::string text = benchmark_argument_string(type);
+	int int_value = 0;
+	float float_value = 0;
+	double double_value = 0;
+	bool bool_value = false;
+	switch (type)
+	{
+	case Value_Type::INTEGER:
+		get_int(text, int_value);
+		write_binary_value(out, int_value);
+		break;
+	case Value_Type::FLOAT:
+		get_float(text, float_value);
+		write_binary_value(out, float_value);
+		break;
+	case Value_Type::DOUBLE:
+		get_double(text, double_value);
+		write_binary_value(out, double_value);
+		break;
+	case Value_Type::BOOLEAN:
+		get_bool(text, bool_value);
+		write_binary_value(out, bool_value);
+		break;
+	default:
+		write_binary_value(out, std::string_view(text));
+		break;
+	}
+}
+
+template <typename T>
+bool parse_number(std::string_view source, T &out_value)
+{
+	auto result = std::from_chars(source.data(), source.data() + source.size(), out_value);
+	return result.ec == std::errc() && result.ptr == source.data() + source.size();
+}
+
+int main(int arg_count, const char **args)
+{
+	size_t rounds = 0;
+	std::string save_path, compare_path;
+	double tolerance_percent = 10.0;
+
+	for (int i = 1; i < arg_count; i++)
+	{
+		std::string_view arg = args[i];
+		bool success = true;
+		if (arg.starts_with("--rounds="))
+		{
+			success = parse_number(arg.substr(sizeof("--rounds=") - 1), rounds);
+		}
+		else if (arg.starts_with("--save="))
+		{
+			save_path = arg.substr(sizeof("--save=") - 1);
+		}
+		else if (arg.starts_with("--compare="))
+		{
+			compare_path = arg.substr(sizeof("--compare=") - 1);
+		}
+		else if (arg.starts_with("--tolerance="))
+		{
+			success = parse_number(arg.substr(sizeof("--tolerance=") - 1), tolerance_percent);
+		}
+		else
+		{
+			success = false;
+		}
+
+		if (!success)
+		{
+			std::cerr << std::format("[ERROR] Invalid argument '{}'. See the top of "
+				"call_overhead_benchmark.cpp for usage.\n", arg);
+			return 1;
+		}
+	}
+
+	Function_Map commands;
+	init_benchmark_commands(commands);
+	size_t command_count = commands.size();
+
+	// Aim for about a million calls per measurement unless told otherwise.
+	if (rounds == 0)
+	{
+		rounds = std::max<size_t>(1, 1000000 / std::max<size_t>(command_count, 1));
+	}
+
+	// Prepare the inputs up front so only the measured operation is timed. Commands are named
+	// "command_<index>", matching the order of DIRECT_CALLS.
+	std::vector<std::string> names(command_count);
+	std::vector<Function_Wrapper> wrappers(command_count);
+	std::vector<std::vector<std::string>> arguments(command_count);
+	std::vector<Binary_Function_Wrapper> binary_wrappers(command_count);
+	std::vector<std::string> binary_arguments(command_count);
+	std::vector<std::string> lines(command_count);
+	std::vector<Benchmark_Command_Id> ids(command_count);
+	for (size_t i = 0; i < command_count; i++)
+	{
+		names[i] = std::format("command_{}", i);
+		const Function_Decl &decl = commands.at(names[i]);
+		wrappers[i] = decl.function;
+		binary_wrappers[i] = decl.binary_function;
+		if (!find_command_id(names[i], ids[i]))
+		{
+			std::cerr << std::format("[ERROR] '{}' has no command id\n", names[i]);
+			return 1;
+		}
+
+		lines[i] = names[i];
+		for (const auto &argument : decl.arguments)
+		{
+			arguments[i].push_back(benchmark_argument_string(argument.type));
+			lines[i] += " " + arguments[i].back();
+			write_binary_benchmark_argument(binary_arguments[i], argument.type);
+		}
+	}
+
+	// Confirm the generated registry actually accepts the arguments before timing it.
+	for (size_t i = 0; i < command_count; i++)
+	{
+		Call_Result result = wrappers[i](arguments[i], false);
+		Call_Result binary_result = binary_wrappers[i](binary_arguments[i], false);
+		if (result.status != Call_Result_Status::SUCCESS || binary_result.status != Call_Result_Status::SUCCESS)
+		{
+			std::cerr << std::format("[ERROR] '{}' rejected its arguments: {}\n", names[i],
+				result.error_message + binary_result.error_message);
+			return 1;
+		}
+	}
+
+	std::vector<std::pair<const char *, Measurement>> measurements;
+
+	measurements.emplace_back("direct", measure(command_count, rounds, [&](size_t i)
+		{
+			DIRECT_CALLS[i]();
+		}));
+
+	measurements.emplace_back("lookup", measure(command_count, rounds, [&](size_t i)
+		{
+			sink = sink + (commands.find(names[i]) != commands.end());
+		}));
+
+	measurements.emplace_back("tokenize", measure(command_count, rounds, [&](size_t i)
+		{
+			std::vector<std::string> tokens;
+			tokenize(lines[i], tokens);
+			sink = sink + tokens.size();
+		}));
+
+	measurements.emplace_back("validate", measure(command_count, rounds, [&](size_t i)
+		{
+			sink = sink + (size_t)wrappers[i](arguments[i], false).status;
+		}));
+
+	measurements.emplace_back("call", measure(command_count, rounds, [&](size_t i)
+		{
+			sink = sink + (size_t)wrappers[i](arguments[i], true).status;
+		}));
+
+	// What a console does for every line: split it, find the command, call it.
+	measurements.emplace_back("end_to_end", measure(command_count, rounds, [&](size_t i)
+		{
+			std::vector<std::string> tokens;
+			tokenize(lines[i], tokens);
+			auto found = commands.find(tokens[0]);
+			tokens.erase(tokens.begin());
+			sink = sink + (size_t)found->second.function(tokens, true).status;
+		}));
+
+	// Calling by name, which hashes the name for every call, against calling by a resolved id.
+	measurements.emplace_back("lookup_call", measure(command_count, rounds, [&](size_t i)
+		{
+			sink = sink + (size_t)commands.find(names[i])->second.function(arguments[i], true).status;
+		}));
+
+	measurements.emplace_back("id_call", measure(command_count, rounds, [&](size_t i)
+		{
+			sink = sink + (size_t)call_command(ids[i], arguments[i], true).status;
+		}));
+
+	// What an RPC caller with typed values pays: read binary arguments and encode the result.
+	std::string binary_result;
+	measurements.emplace_back("binary_call", measure(command_count, rounds, [&](size_t i)
+		{
+			Call_Result result = binary_wrappers[i](binary_arguments[i], true);
+			binary_result.clear();
+			write_binary_result(binary_result, result);
+			sink = sink + binary_result.size();
+		}));
+
+	std::string case_name = std::format("{}_commands", command_count);
+	std::vector<Benchmark_Result> results;
+	std::cout << std::format("{} commands, {} rounds\n", command_count, rounds);
+	std::cout << std::format("{:<14}{:>12}{:>16}{:>16}\n", "operation", "ns/call", "allocs/call",
+		"bytes/call");
+	for (const auto &[name, measurement] : measurements)
+	{
+		std::cout << std::format("{:<14}{:>12.1f}{:>16.2f}{:>16.1f}\n", name,
+			measurement.nanoseconds_per_call, measurement.allocations_per_call,
+			measurement.allocated_bytes_per_call);
+		results.push_back({ case_name, std::format("{}_ns", name), measurement.nanoseconds_per_call, true });
+		results.push_back({ case_name, std::format("{}_allocs", name), measurement.allocations_per_call, true });
+		results.push_back({ case_name, std::format("{}_bytes", name), measurement.allocated_bytes_per_call, true });
+	}
+
+	double overhead = measurements[4].second.nanoseconds_per_call - measurements[0].second.nanoseconds_per_call;
+	std::cout << std::format("Wrapper overhead over a direct call: {:.1f} ns/call\n", overhead);
+	results.push_back({ case_name, "wrapper_overhead_ns", overhead, true });
+
+	if (!save_path.empty() && !write_benchmark_results(save_path, results))
+	{
+		return 1;
+	}
+
+	if (!compare_path.empty())
+	{
+		std::vector<Benchmark_Result> baseline;
+		if (!read_benchmark_results(compare_path, baseline))
+		{
+			return 1;
+		}
+
+		std::cout << '\n';
+		if (!compare_benchmark_results(baseline, results, tolerance_percent, std::cout))
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,75 @@
+/*
+Writes a synthetic command registry for the runtime benchmarks. Run as part of the build, the
+commands file is then scanned by Function Finder like any client code.
+
+Usage:
+    command_generator <commands.cpp> <direct_calls.cpp> <command_count> [max_arguments] [seed]
+*/
+
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+#include "synthetic_corpus.hpp"
+
+bool write_file(const std::filesystem::path &path, const std::string &content)
+{
+	if (path.has_parent_path())
+	{
+		std::filesystem::create_directories(path.parent_path());
+	}
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << std::format("[ERROR] Could not create '{}'\n", path.generic_string());
+		return false;
+	}
+	file << content;
+	return true;
+}
+
+template <typename T>
+bool parse_number(std::string_view source, T &out_value)
+{
+	auto result = std::from_chars(source.data(), source.data() + source.size(), out_value);
+	return result.ec == std::errc() && result.ptr == source.data() + source.size();
+}
+
+int main(int arg_count, const char **args)
+{
+	if (arg_count < 4 || arg_count > 6)
+	{
+		std::cerr << "Usage: command_generator <commands.cpp> <direct_calls.cpp> <command_count> "
+			"[max_arguments] [seed]\n";
+		return 1;
+	}
+
+	Corpus_Settings settings;
+	size_t command_count = 0;
+	bool success = parse_number(std::string_view(args[3]), command_count);
+	if (arg_count > 4)
+	{
+		success = success && parse_number(std::string_view(args[4]), settings.max_arguments);
+	}
+	if (arg_count > 5)
+	{
+		success = success && parse_number(std::string_view(args[5]), settings.seed);
+	}
+	if (!success)
+	{
+		std::cerr << "[ERROR] command_count, max_arguments and seed must be numbers\n";
+		return 1;
+	}
+
+	std::string commands_source, direct_calls_source;
+	generate_command_registry(settings, command_count, commands_source, direct_calls_source);
+
+	if (!write_file(args[1], commands_source) || !write_file(args[2], direct_calls_source))
+	{
+		return 1;
+	}
+	return 0;
+}
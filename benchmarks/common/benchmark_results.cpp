@@ -0,0 +1,121 @@
+#include "benchmark_results.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+bool write_benchmark_results(const std::filesystem::path &path,
+	const std::vector<Benchmark_Result> &results)
+{
+	if (path.has_parent_path())
+	{
+		std::filesystem::create_directories(path.parent_path());
+	}
+
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		std::cerr << std::format("[ERROR] Could not create results file '{}'\n", path.generic_string());
+		return false;
+	}
+
+	file << "case,metric,value,lower_is_better\n";
+	for (const auto &result : results)
+	{
+		file << std::format("{},{},{},{}\n", result.case_name, result.metric, result.value,
+			result.lower_is_better ? 1 : 0);
+	}
+	return true;
+}
+
+bool read_benchmark_results(const std::filesystem::path &path,
+	std::vector<Benchmark_Result> &out_results)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		std::cerr << std::format("[ERROR] Could not open results file '{}'\n", path.generic_string());
+		return false;
+	}
+
+	std::string line;
+	bool is_header = true;
+	while (std::getline(file, line))
+	{
+		if (is_header || line.empty())
+		{
+			is_header = false;
+			continue;
+		}
+
+		// Split into the four columns.
+		std::string_view columns[4];
+		std::string_view rest = line;
+		for (size_t i = 0; i < 4; i++)
+		{
+			auto comma = rest.find(',');
+			columns[i] = rest.substr(0, comma);
+			rest = comma == std::string_view::npos ? std::string_view() : rest.substr(comma + 1);
+		}
+
+		Benchmark_Result result;
+		result.case_name = columns[0];
+		result.metric = columns[1];
+		auto parsed = std::from_chars(columns[2].data(), columns[2].data() + columns[2].size(),
+			result.value);
+		if (parsed.ec != std::errc())
+		{
+			std::cerr << std::format("[ERROR] Malformed line in '{}': {}\n", path.generic_string(), line);
+			return false;
+		}
+		result.lower_is_better = columns[3] != "0";
+		out_results.push_back(result);
+	}
+	return true;
+}
+
+bool compare_benchmark_results(const std::vector<Benchmark_Result> &baseline,
+	const std::vector<Benchmark_Result> &current, double tolerance_percent, std::ostream &out)
+{
+	bool no_regressions = true;
+
+	out << std::format("{:<24}{:<20}{:>14}{:>14}{:>10}\n", "case", "metric", "baseline",
+		"current", "change");
+	for (const auto &result : current)
+	{
+		auto base = std::find_if(baseline.begin(), baseline.end(), [&](const Benchmark_Result &b)
+			{ return b.case_name == result.case_name && b.metric == result.metric; });
+		if (base == baseline.end())
+		{
+			out << std::format("{:<24}{:<20}{:>14}{:>14.3f}{:>10}\n", result.case_name,
+				result.metric, "-", result.value, "new");
+			continue;
+		}
+
+		double change = base->value != 0 ? (result.value - base->value) / base->value * 100.0 : 0.0;
+		double worsening = result.lower_is_better ? change : -change;
+		bool regressed = worsening > tolerance_percent;
+		no_regressions = no_regressions && !regressed;
+
+		out << std::format("{:<24}{:<20}{:>14.3f}{:>14.3f}{:>+9.1f}%{}\n", result.case_name,
+			result.metric, base->value, result.value, change, regressed ? "  REGRESSION" : "");
+	}
+
+	if (!no_regressions)
+	{
+		out << std::format("Some results regressed by more than {}%\n", tolerance_percent);
+	}
+	return no_regressions;
+}
+
+void print_benchmark_results(const std::vector<Benchmark_Result> &results, std::ostream &out)
+{
+	out << std::format("{:<24}{:<20}{:>14}\n", "case", "metric", "value");
+	for (const auto &result : results)
+	{
+		out << std::format("{:<24}{:<20}{:>14.3f}\n", result.case_name, result.metric, result.value);
+	}
+}
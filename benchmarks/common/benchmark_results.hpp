@@ -0,0 +1,60 @@
+/*
+Storing and comparing benchmark results. Results are kept as simple CSV files so baselines can be
+checked in, diffed, and opened in a spreadsheet.
+*/
+#pragma once
+
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// A single measured number.
+/// </summary>
+struct Benchmark_Result
+{
+	/// <summary>
+	/// The benchmark case the number belongs to, like "large" or "100_commands".
+	/// </summary>
+	std::string case_name;
+
+	/// <summary>
+	/// What was measured, including the unit, like "import_ms" or "mb_per_s".
+	/// </summary>
+	std::string metric;
+
+	double value = 0;
+
+	/// <summary>
+	/// Whether a lower value is an improvement. True for times and sizes, false for throughput.
+	/// </summary>
+	bool lower_is_better = true;
+};
+
+/// <summary>
+/// Writes results as CSV with the columns case, metric, value, lower_is_better.
+/// </summary>
+/// <returns>True if the file could be written.</returns>
+bool write_benchmark_results(const std::filesystem::path &path,
+	const std::vector<Benchmark_Result> &results);
+
+/// <summary>
+/// Reads results written by \ref write_benchmark_results.
+/// </summary>
+/// <returns>True if the file could be read and parsed.</returns>
+bool read_benchmark_results(const std::filesystem::path &path,
+	std::vector<Benchmark_Result> &out_results);
+
+/// <summary>
+/// Prints a table comparing current results against a baseline. A result counts as a regression
+/// if it got worse by more than tolerance_percent.
+/// </summary>
+/// <returns>True if there were no regressions.</returns>
+bool compare_benchmark_results(const std::vector<Benchmark_Result> &baseline,
+	const std::vector<Benchmark_Result> &current, double tolerance_percent, std::ostream &out);
+
+/// <summary>
+/// Prints results as an aligned table.
+/// </summary>
+void print_benchmark_results(const std::vector<Benchmark_Result> &results, std::ostream &out);
@@ -0,0 +1,325 @@
+#include "synthetic_corpus.hpp"
+
+#include <format>
+#include <fstream>
+#include <iostream>
+
+/// <summary>
+/// The argument and return types the importer understands.
+/// </summary>
+const Value_Type ARGUMENT_TYPES[] = {
+	Value_Type::INTEGER, Value_Type::FLOAT, Value_Type::DOUBLE, Value_Type::BOOLEAN,
+	Value_Type::STRING };
+
+const Value_Type RETURN_TYPES[] = {
+	Value_Type::VOID, Value_Type::INTEGER, Value_Type::FLOAT, Value_Type::DOUBLE,
+	Value_Type::BOOLEAN, Value_Type::STRING };
+
+/// <summary>
+/// Words notes are made of. The content doesn't matter, only the length.
+/// </summary>
+const char *NOTE_WORDS[] = {
+	"sets", "the", "value", "of", "a", "console", "variable", "and", "prints", "result",
+	"reloads", "current", "level", "from", "disk", "toggles", "debug", "overlay", "for", "entity" };
+
+std::string random_note(std::mt19937 &rng, size_t min_words, size_t max_words)
+{
+	std::uniform_int_distribution<size_t> word_count(min_words, max_words);
+	std::uniform_int_distribution<size_t> word(0, std::size(NOTE_WORDS) - 1);
+
+	std::string note;
+	size_t count = word_count(rng);
+	for (size_t i = 0; i < count; i++)
+	{
+		if (i)
+		{
+			note += ' ';
+		}
+		note += NOTE_WORDS[word(rng)];
+	}
+	return note;
+}
+
+std::string default_value_string(Value_Type type)
+{
+	switch (type)
+	{
+	case Value_Type::INTEGER:
+		return "7";
+	case Value_Type::FLOAT:
+		return "1.5f";
+	case Value_Type::DOUBLE:
+		return "2.25";
+	case Value_Type::BOOLEAN:
+		return "true";
+	case Value_Type::STRING:
+		return "\"default\"";
+	default:
+		return "";
+	}
+}
+
+Comment_Style pick_comment_style(std::mt19937 &rng, Comment_Style style)
+{
+	if (style != Comment_Style::MIXED)
+	{
+		return style;
+	}
+
+	std::uniform_int_distribution<int> pick(0, 2);
+	return (Comment_Style)pick(rng);
+}
+
+Synthetic_Function make_synthetic_function(std::mt19937 &rng, const Corpus_Settings &settings,
+	const std::string &name)
+{
+	std::uniform_int_distribution<size_t> argument_type(0, std::size(ARGUMENT_TYPES) - 1);
+	std::uniform_int_distribution<size_t> return_type(0, std::size(RETURN_TYPES) - 1);
+	std::uniform_int_distribution<size_t> argument_count(0, settings.max_arguments);
+
+	Synthetic_Function function;
+	function.name = name;
+	function.return_type = RETURN_TYPES[return_type(rng)];
+
+	size_t count = argument_count(rng);
+	for (size_t i = 0; i < count; i++)
+	{
+		function.argument_types.push_back(ARGUMENT_TYPES[argument_type(rng)]);
+	}
+
+	if (count > 0)
+	{
+		std::uniform_int_distribution<size_t> default_count(0, count);
+		function.num_default_arguments = default_count(rng) / 2;
+	}
+
+	return function;
+}
+
+void write_synthetic_function(std::mt19937 &rng, const Corpus_Settings &settings,
+	const Synthetic_Function &function, bool is_command, std::string &out_source)
+{
+	Comment_Style style = pick_comment_style(rng, settings.comment_style);
+
+	if (is_command)
+	{
+		out_source += settings.search_term;
+		switch (style)
+		{
+		case Comment_Style::LINE:
+			out_source += std::format(" // {}\n", random_note(rng, 3, 12));
+			break;
+		case Comment_Style::BLOCK:
+			out_source += std::format(" /* {}\n    {} */\n", random_note(rng, 3, 12),
+				random_note(rng, 3, 12));
+			break;
+		default:
+			out_source += '\n';
+		}
+	}
+	else
+	{
+		// Regular code that mentions the search term, but not at the start of a line.
+		out_source += std::format("// Not a {} since it's not at the start of the line.\n",
+			settings.search_term);
+	}
+
+	out_source += std::format("{} {}(", value_type_to_cpp_type(function.return_type), function.name);
+	size_t first_default = function.argument_types.size() - function.num_default_arguments;
+	for (size_t i = 0; i < function.argument_types.size(); i++)
+	{
+		Value_Type type = function.argument_types[i];
+		out_source += std::format("{}{} a{}", i ? ", " : "", value_type_to_cpp_type(type), i);
+		if (i >= first_default)
+		{
+			out_source += " = " + default_value_string(type);
+		}
+		if (style == Comment_Style::BLOCK)
+		{
+			out_source += std::format(" /* {} */", random_note(rng, 1, 5));
+		}
+	}
+	out_source += ")\n{\n\tdouble accumulator = 0;\n";
+
+	for (size_t i = 0; i < function.argument_types.size(); i++)
+	{
+		switch (function.argument_types[i])
+		{
+		case Value_Type::BOOLEAN:
+			out_source += std::format("\taccumulator += a{} ? 1 : 0;\n", i);
+			break;
+		case Value_Type::STRING:
+			out_source += std::format("\taccumulator += (double)a{}.size();\n", i);
+			break;
+		default:
+			out_source += std::format("\taccumulator += a{};\n", i);
+		}
+	}
+
+	switch (function.return_type)
+	{
+	case Value_Type::VOID:
+		out_source += "\t(void)accumulator;\n";
+		break;
+	case Value_Type::INTEGER:
+		out_source += "\treturn (int)accumulator;\n";
+		break;
+	case Value_Type::FLOAT:
+		out_source += "\treturn (float)accumulator;\n";
+		break;
+	case Value_Type::DOUBLE:
+		out_source += "\treturn accumulator;\n";
+		break;
+	case Value_Type::BOOLEAN:
+		out_source += "\treturn accumulator > 0;\n";
+		break;
+	case Value_Type::STRING:
+		out_source += "\treturn std::to_string(accumulator);\n";
+		break;
+	default:
+		break;
+	}
+	out_source += "}\n\n";
+}
+
+bool generate_corpus(const std::filesystem::path &root, const Corpus_Settings &settings,
+	Corpus_Info &out_info)
+{
+	std::mt19937 rng(settings.seed);
+	std::bernoulli_distribution is_command(settings.command_density);
+
+	std::error_code error;
+	std::filesystem::remove_all(root, error);
+	std::filesystem::create_directories(root);
+
+	out_info = {};
+	size_t function_index = 0;
+	for (size_t file_index = 0; file_index < settings.file_count; file_index++)
+	{
+		auto directory = root / std::format("dir_{}", file_index / std::max<size_t>(settings.files_per_directory, 1));
+		std::filesystem::create_directories(directory);
+		auto path = directory / std::format("file_{}.cpp", file_index);
+
+		std::string source = "#include <string>\n\n";
+		if (settings.comment_style != Comment_Style::NONE)
+		{
+			source += "/*\n    Synthetic benchmark source. Regular comments and code are mixed with\n"
+				"    the marked functions so the scanner has something to skip.\n*/\n\n";
+		}
+		source += std::format("#define {}\n\n", settings.search_term);
+
+		while (source.size() < settings.file_size)
+		{
+			auto function = make_synthetic_function(rng,
+				settings, std::format("function_{}", function_index++));
+			bool command = is_command(rng);
+			write_synthetic_function(rng, settings, function, command, source);
+			out_info.commands += command ? 1 : 0;
+		}
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file.is_open())
+		{
+			std::cerr << std::format("[ERROR] Could not create '{}'\n", path.generic_string());
+			return false;
+		}
+		file << source;
+
+		out_info.files++;
+		out_info.bytes += source.size();
+	}
+
+	return true;
+}
+
+std::string benchmark_argument_string(Value_Type type)
+{
+	switch (type)
+	{
+	case Value_Type::INTEGER:
+		return "42";
+	case Value_Type::FLOAT:
+		return "1.5f";
+	case Value_Type::DOUBLE:
+		return "2.25";
+	case Value_Type::BOOLEAN:
+		return "true";
+	case Value_Type::STRING:
+		return "hello";
+	default:
+		return "";
+	}
+}
+
+/// <summary>
+/// The C++ expression matching \ref benchmark_argument_string.
+/// </summary>
+std::string benchmark_argument_expression(Value_Type type)
+{
+	if (type == Value_Type::STRING)
+	{
+		return std::format("std::string(\"{}\")", benchmark_argument_string(type));
+	}
+	return benchmark_argument_string(type);
+}
+
+void generate_command_registry(const Corpus_Settings &settings, size_t command_count,
+	std::string &out_commands_source, std::string &out_direct_calls_source)
+{
+	std::mt19937 rng(settings.seed);
+
+	out_commands_source = "#include <string>\n\n";
+	out_commands_source += std::format("#define {}\n\n", settings.search_term);
+
+	std::string declarations;
+	std::string calls;
+	for (size_t i = 0; i < command_count; i++)
+	{
+		auto function = make_synthetic_function(rng, settings, std::format("command_{}", i));
+		write_synthetic_function(rng, settings, function, true, out_commands_source);
+
+		declarations += std::format("{} {}(", value_type_to_cpp_type(function.return_type),
+			function.name);
+		calls += std::format("\t[]() {{ {}(", function.name);
+		for (size_t j = 0; j < function.argument_types.size(); j++)
+		{
+			Value_Type type = function.argument_types[j];
+			declarations += std::format("{}{}", j ? ", " : "", value_type_to_cpp_type(type));
+			calls += std::format("{}{}", j ? ", " : "", benchmark_argument_expression(type));
+		}
+		declarations += ");\n";
+		calls += "); },\n";
+	}
+
+	out_direct_calls_source = "#include <string>\n\n";
+	out_direct_calls_source += declarations;
+	out_direct_calls_source += "\nextern void (*const DIRECT_CALLS[])();\n";
+	out_direct_calls_source += "void (*const DIRECT_CALLS[])() = {\n";
+	out_direct_calls_source += calls;
+	out_direct_calls_source += "};\n";
+}
+
+bool parse_comment_style(std::string_view name, Comment_Style &out_style)
+{
+	if (name == "none")
+	{
+		out_style = Comment_Style::NONE;
+	}
+	else if (name == "line")
+	{
+		out_style = Comment_Style::LINE;
+	}
+	else if (name == "block")
+	{
+		out_style = Comment_Style::BLOCK;
+	}
+	else if (name == "mixed")
+	{
+		out_style = Comment_Style::MIXED;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
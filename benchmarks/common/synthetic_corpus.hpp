@@ -0,0 +1,166 @@
+/*
+Generates synthetic C++ sources for the benchmarks. The generated functions are valid C++ with
+bodies, so the same generator is used both for import benchmarks (where only parsing matters) and
+for runtime benchmarks (where the generated commands are compiled and called).
+*/
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "function_finder/function_finder.hpp"
+
+/// <summary>
+/// How the notes of generated commands and their arguments are written.
+/// </summary>
+enum class Comment_Style
+{
+	/// <summary>
+	/// No notes at all.
+	/// </summary>
+	NONE,
+
+	/// <summary>
+	/// Single line '//' notes after the search term.
+	/// </summary>
+	LINE,
+
+	/// <summary>
+	/// Multi-line block notes after the search term, and block notes after arguments.
+	/// </summary>
+	BLOCK,
+
+	/// <summary>
+	/// A random pick of the above per function.
+	/// </summary>
+	MIXED
+};
+
+/// <summary>
+/// Describes the shape of a synthetic source tree.
+/// </summary>
+struct Corpus_Settings
+{
+	/// <summary>
+	/// The term placed in front of the functions that should be found.
+	/// </summary>
+	std::string search_term = "BENCHMARK_COMMAND";
+
+	/// <summary>
+	/// Number of source files to generate.
+	/// </summary>
+	size_t file_count = 100;
+
+	/// <summary>
+	/// Approximate size of each file in bytes. Files are filled with functions until they reach it.
+	/// </summary>
+	size_t file_size = 16 * 1024;
+
+	/// <summary>
+	/// Fraction of the generated functions that are marked with the search term, in [0, 1].
+	/// </summary>
+	double command_density = 0.25;
+
+	/// <summary>
+	/// How notes are written.
+	/// </summary>
+	Comment_Style comment_style = Comment_Style::MIXED;
+
+	/// <summary>
+	/// Maximum number of arguments per function. The actual count is uniformly picked from
+	/// [0, max_arguments].
+	/// </summary>
+	size_t max_arguments = 4;
+
+	/// <summary>
+	/// Number of files per sub-directory, to exercise the directory walk.
+	/// </summary>
+	size_t files_per_directory = 32;
+
+	/// <summary>
+	/// Seed for the random generator. The same settings and seed always give the same tree.
+	/// </summary>
+	uint32_t seed = 1234;
+};
+
+/// <summary>
+/// What was actually generated.
+/// </summary>
+struct Corpus_Info
+{
+	size_t files = 0;
+	size_t bytes = 0;
+
+	/// <summary>
+	/// Number of functions marked with the search term. This is what the importer should find.
+	/// </summary>
+	size_t commands = 0;
+};
+
+/// <summary>
+/// The shape of a single generated function.
+/// </summary>
+struct Synthetic_Function
+{
+	std::string name;
+	Value_Type return_type = Value_Type::VOID;
+	std::vector<Value_Type> argument_types;
+
+	/// <summary>
+	/// Number of trailing arguments that get default values.
+	/// </summary>
+	size_t num_default_arguments = 0;
+};
+
+/// <summary>
+/// Writes a synthetic source tree into a directory. The directory is emptied first.
+/// </summary>
+/// <param name="root">Directory to generate into.</param>
+/// <param name="settings">Shape of the tree.</param>
+/// <param name="out_info">What was generated.</param>
+/// <returns>True if all files could be written.</returns>
+bool generate_corpus(const std::filesystem::path &root, const Corpus_Settings &settings,
+	Corpus_Info &out_info);
+
+/// <summary>
+/// Picks a random function shape using the argument limits in the settings.
+/// </summary>
+Synthetic_Function make_synthetic_function(std::mt19937 &rng, const Corpus_Settings &settings,
+	const std::string &name);
+
+/// <summary>
+/// Appends the C++ source of a function to out_source. The function is prefixed with the search
+/// term if is_command is true, and has a body that uses all arguments and returns a value.
+/// </summary>
+void write_synthetic_function(std::mt19937 &rng, const Corpus_Settings &settings,
+	const Synthetic_Function &function, bool is_command, std::string &out_source);
+
+/// <summary>
+/// Generates the sources of a registry of commands for the runtime benchmarks. Every generated
+/// function is a command, named "command_<index>".
+/// </summary>
+/// <param name="settings">Shape of the commands. Only search_term, comment_style, max_arguments
+/// and seed are used.</param>
+/// <param name="command_count">Number of commands to generate.</param>
+/// <param name="out_commands_source">The command definitions, to be scanned by Function Finder.
+/// </param>
+/// <param name="out_direct_calls_source">A separate translation unit defining DIRECT_CALLS, an
+/// array with one function per command that calls it directly with the values from
+/// \ref benchmark_argument_string. Kept separate so the compiler can't inline the commands into
+/// it, which the generated wrappers can't either.</param>
+void generate_command_registry(const Corpus_Settings &settings, size_t command_count,
+	std::string &out_commands_source, std::string &out_direct_calls_source);
+
+/// <summary>
+/// The value the benchmarks pass for an argument of the given type, as a string. Matches the
+/// values used in the generated DIRECT_CALLS.
+/// </summary>
+std::string benchmark_argument_string(Value_Type type);
+
+/// <summary>
+/// Parses a comment style name: "none", "line", "block" or "mixed".
+/// </summary>
+bool parse_comment_style(std::string_view name, Comment_Style &out_style);
@@ -0,0 +1,359 @@
+/*
+Measures what a generated registry costs to build. For every registry size and output mode, a
+synthetic registry is generated, Function Finder is run on it, and a translation unit including the
+generated header is compiled. Compile time, header size, object size and object size per wrapper are
+reported. The size per wrapper is relative to an empty registry in the same mode, so the code of the
+runtime headers doesn't count.
+
+The compiler, its flags and the Function Finder executable are baked in by CMake and can be
+overridden on the command line.
+
+Usage:
+    compile_benchmark [options]
+
+    --sizes=<N,N,...>       Registry sizes. Defaults to 100,1000,10000.
+    --modes=<name,...>      Output modes to compile, see OUTPUT_MODES. Defaults to all.
+    --iterations=<N>        Number of timed compiles per case. Defaults to 1.
+    --compiler=<path>       C++ compiler to use.
+    --generator=<path>      Function Finder executable to use.
+    --work-dir=<path>       Where registries and objects are generated.
+    --save=<path>           Save the results as a baseline CSV.
+    --compare=<path>        Compare the results against a baseline CSV. Exits with 1 on regressions.
+    --tolerance=<percent>   How much worse a result may get before it's a regression. Defaults to 10.
+*/
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+#include "synthetic_corpus.hpp"
+#include "benchmark_results.hpp"
+
+/// <summary>
+/// A set of generator options that changes what the generated header looks like.
+/// </summary>
+struct Output_Mode
+{
+	const char *name;
+	const char *options;
+};
+
+/// <summary>
+/// All output modes of the generator.
+/// </summary>
+const Output_Mode OUTPUT_MODES[] = {
+	{ "default", "" },
+	{ "instrumented", "--instrument" },
+	{ "template", "--wrappers=template" },
+	{ "table", "--wrappers=table" },
+	{ "inline_errors", "--inline-errors" },
+	{ "typed_entries", "--typed-entries" },
+	{ "binary_entries", "--binary-entries" },
+};
+
+/// <summary>
+/// Command line settings of the benchmark.
+/// </summary>
+struct Benchmark_Settings
+{
+	std::vector<size_t> sizes = { 100, 1000, 10000 };
+	std::vector<Output_Mode> modes{ std::begin(OUTPUT_MODES), std::end(OUTPUT_MODES) };
+	size_t iterations = 1;
+	std::string compiler = BENCHMARK_CXX_COMPILER;
+	std::string generator = BENCHMARK_GENERATOR;
+	std::filesystem::path work_dir = std::filesystem::temp_directory_path() / "function_finder_compile_benchmark";
+	std::filesystem::path save_path;
+	std::filesystem::path compare_path;
+	double tolerance_percent = 10.0;
+};
+
+/// <summary>
+/// Result of building one registry.
+/// </summary>
+struct Build_Info
+{
+	double compile_seconds = 0;
+	size_t header_bytes = 0;
+	size_t object_bytes = 0;
+};
+
+template <typename T>
+bool parse_number(std::string_view source, T &out_value)
+{
+	auto result = std::from_chars(source.data(), source.data() + source.size(), out_value);
+	return result.ec == std::errc() && result.ptr == source.data() + source.size();
+}
+
+/// <summary>
+/// Calls on_item for every comma separated item in list.
+/// </summary>
+template <typename On_Item>
+bool for_each_list_item(std::string_view list, On_Item on_item)
+{
+	while (!list.empty())
+	{
+		auto comma = list.find(',');
+		if (!on_item(list.substr(0, comma)))
+		{
+			return false;
+		}
+		list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+	}
+	return true;
+}
+
+bool parse_benchmark_settings(int arg_count, const char **args, Benchmark_Settings &out_settings)
+{
+	for (int i = 1; i < arg_count; i++)
+	{
+		std::string_view arg = args[i];
+		auto equals = arg.find('=');
+		std::string_view name = arg.substr(0, equals);
+		std::string_view value = equals == std::string_view::npos ? "" : arg.substr(equals + 1);
+
+		bool success = true;
+		if (name == "--sizes")
+		{
+			out_settings.sizes.clear();
+			success = for_each_list_item(value, [&](std::string_view item)
+				{
+					out_settings.sizes.push_back(0);
+					return parse_number(item, out_settings.sizes.back());
+				});
+		}
+		else if (name == "--modes")
+		{
+			out_settings.modes.clear();
+			success = for_each_list_item(value, [&](std::string_view item)
+				{
+					auto mode = std::find_if(std::begin(OUTPUT_MODES), std::end(OUTPUT_MODES),
+						[&](const Output_Mode &m) { return item == m.name; });
+					if (mode == std::end(OUTPUT_MODES))
+					{
+						return false;
+					}
+					out_settings.modes.push_back(*mode);
+					return true;
+				});
+		}
+		else if (name == "--iterations")
+		{
+			success = parse_number(value, out_settings.iterations) && out_settings.iterations > 0;
+		}
+		else if (name == "--compiler")
+		{
+			out_settings.compiler = value;
+		}
+		else if (name == "--generator")
+		{
+			out_settings.generator = value;
+		}
+		else if (name == "--work-dir")
+		{
+			out_settings.work_dir = value;
+		}
+		else if (name == "--save")
+		{
+			out_settings.save_path = value;
+		}
+		else if (name == "--compare")
+		{
+			out_settings.compare_path = value;
+		}
+		else if (name == "--tolerance")
+		{
+			success = parse_number(value, out_settings.tolerance_percent);
+		}
+		else
+		{
+			success = false;
+		}
+
+		if (!success)
+		{
+			std::cerr << std::format("[ERROR] Invalid argument '{}'. See the top of "
+				"compile_benchmark.cpp for usage.\n", arg);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool write_file(const std::filesystem::path &path, const std::string &content)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << std::format("[ERROR] Could not create '{}'\n", path.generic_string());
+		return false;
+	}
+	file << content;
+	return true;
+}
+
+/// <summary>
+/// Runs a shell command, with its output going to log_path.
+/// </summary>
+bool run_command(std::string command, const std::filesystem::path &log_path)
+{
+	command += std::format(" > \"{}\" 2>&1", log_path.string());
+#ifdef _WIN32
+	// cmd.exe strips the first and last quote of the whole line.
+	command = "\"" + command + "\"";
+#endif
+	if (std::system(command.c_str()) != 0)
+	{
+		std::cerr << std::format("[ERROR] Command failed, see '{}':\n{}\n", log_path.generic_string(), command);
+		return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// The compiler command line that compiles source into object.
+/// </summary>
+std::string compile_command(const Benchmark_Settings &settings, const std::filesystem::path &source,
+	const std::filesystem::path &object)
+{
+#ifdef BENCHMARK_COMPILER_IS_MSVC
+	return std::format("\"{}\" /nologo /std:c++20 /EHsc /O2 /I\"{}\" /I\"{}\" /c \"{}\" /Fo\"{}\"",
+		settings.compiler, BENCHMARK_INCLUDE_DIR, source.parent_path().string(), source.string(),
+		object.string());
+#else
+	return std::format("\"{}\" -std=c++20 -O2 -I\"{}\" -I\"{}\" -c \"{}\" -o \"{}\"",
+		settings.compiler, BENCHMARK_INCLUDE_DIR, source.parent_path().string(), source.string(),
+		object.string());
+#endif
+}
+
+/// <summary>
+/// Generates a registry of command_count commands, exports it in the given mode and compiles a
+/// translation unit using it.
+/// </summary>
+bool build_registry(const Benchmark_Settings &settings, const Output_Mode &mode, size_t command_count,
+	Build_Info &out_info)
+{
+	auto dir = settings.work_dir / std::format("{}_{}", mode.name, command_count);
+	std::error_code error;
+	std::filesystem::remove_all(dir, error);
+	std::filesystem::create_directories(dir);
+
+	Corpus_Settings corpus;
+	std::string commands_source, direct_calls_source;
+	generate_command_registry(corpus, command_count, commands_source, direct_calls_source);
+
+	auto commands_path = dir / "commands.cpp";
+	auto header_path = dir / "commands_out.hpp";
+	auto consumer_path = dir / "consumer.cpp";
+	auto object_path = dir / "consumer.o";
+
+	// The consumer is what a client compiles: the generated header and a call to the init function.
+	std::string consumer_source = "#include \"commands_out.hpp\"\n\n"
+		"int main()\n{\n\tFunction_Map commands;\n\tinit_benchmark_commands(commands);\n"
+		"\treturn (int)commands.size();\n}\n";
+
+	if (!write_file(commands_path, commands_source) || !write_file(consumer_path, consumer_source))
+	{
+		return false;
+	}
+
+	std::string generate = std::format("\"{}\" \"{}\" \"{}\" {} init_benchmark_commands "
+		"_benchmark_wrapper_ --quiet {}", settings.generator, commands_path.string(), header_path.string(),
+		corpus.search_term, mode.options);
+	if (!run_command(generate, dir / "generate.log"))
+	{
+		return false;
+	}
+
+	std::vector<double> times;
+	for (size_t i = 0; i < settings.iterations; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		if (!run_command(compile_command(settings, consumer_path, object_path), dir / "compile.log"))
+		{
+			return false;
+		}
+		auto end = std::chrono::steady_clock::now();
+		times.push_back(std::chrono::duration<double>(end - start).count());
+	}
+
+	std::sort(times.begin(), times.end());
+	out_info.compile_seconds = times[times.size() / 2];
+	out_info.header_bytes = std::filesystem::file_size(header_path);
+	out_info.object_bytes = std::filesystem::file_size(object_path);
+	return true;
+}
+
+int main(int arg_count, const char **args)
+{
+	Benchmark_Settings settings;
+	if (!parse_benchmark_settings(arg_count, args, settings))
+	{
+		return 1;
+	}
+
+	std::vector<Benchmark_Result> results;
+	for (const auto &mode : settings.modes)
+	{
+		// What the mode costs without any commands, subtracted to get the size per wrapper.
+		Build_Info empty;
+		if (!build_registry(settings, mode, 0, empty))
+		{
+			return 1;
+		}
+
+		for (size_t size : settings.sizes)
+		{
+			Build_Info info;
+			if (!build_registry(settings, mode, size, info))
+			{
+				return 1;
+			}
+
+			double bytes_per_wrapper = size && info.object_bytes > empty.object_bytes ?
+				(double)(info.object_bytes - empty.object_bytes) / (double)size : 0.0;
+
+			std::string case_name = std::format("{}_{}", mode.name, size);
+			auto add = [&](const char *metric, double value)
+				{ results.push_back({ case_name, metric, value, true }); };
+			add("compile_s", info.compile_seconds);
+			add("header_kb", (double)info.header_bytes / 1024.0);
+			add("object_kb", (double)info.object_bytes / 1024.0);
+			add("bytes_per_wrapper", bytes_per_wrapper);
+
+			std::cout << std::format("{}: compiled in {:.2f} s, header {} KB, object {} KB, "
+				"{:.0f} bytes per wrapper\n", case_name, info.compile_seconds, info.header_bytes / 1024,
+				info.object_bytes / 1024, bytes_per_wrapper);
+		}
+	}
+
+	std::cout << '\n';
+	print_benchmark_results(results, std::cout);
+
+	if (!settings.save_path.empty() && !write_benchmark_results(settings.save_path, results))
+	{
+		return 1;
+	}
+
+	if (!settings.compare_path.empty())
+	{
+		std::vector<Benchmark_Result> baseline;
+		if (!read_benchmark_results(settings.compare_path, baseline))
+		{
+			return 1;
+		}
+
+		std::cout << '\n';
+		if (!compare_benchmark_results(baseline, results, settings.tolerance_percent, std::cout))
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,334 @@
+/*
+Stress test for the runtime parts that many threads use at once: the lock-free Command_Queue and
+the command journal. Build it with a sanitizer, see CMakeLists.txt, to check them for data races
+and memory errors:
+
+    cmake -B build -DFUNCTION-FINDER_BUILD_BENCHMARKS=ON -DFUNCTION-FINDER_STRESS_SANITIZER=thread
+    cmake --build build --target Concurrency_Stress
+    concurrency_stress --producers=4 --commands=80000
+
+Queue: every producer thread submits its commands numbered in order, while the main thread drains
+the queue. Checks that every command ran exactly once, in its producer's order, and that every
+completion callback was called.
+
+Journal: every producer thread records its calls numbered in order, while the main thread flushes
+the journal. The producers run for a number of rounds, on new threads each round, so buffers of
+threads that exited get reused. Checks that every call loads back exactly once, in its producer's
+order, and that no more buffers were created than threads ran at once.
+
+Exits with 1 if any check fails.
+
+Usage:
+    concurrency_stress [options]
+
+    --producers=<N>         Number of producer threads. Defaults to 4.
+    --commands=<N>          Commands submitted or recorded per producer. Defaults to 80000.
+    --rounds=<N>            Number of journal rounds. Defaults to 2.
+    --journal=<path>        Where the journal is written. Defaults to the temp directory.
+    --queue-only            Only stress the queue.
+    --journal-only          Only stress the journal.
+*/
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "function_finder/function_finder.hpp"
+#include "function_finder/command_journal.hpp"
+#include "function_finder/command_queue.hpp"
+
+/// <summary>
+/// Command line settings of the stress test.
+/// </summary>
+struct Stress_Settings
+{
+	size_t producers = 4;
+	size_t commands = 80000;
+	size_t rounds = 2;
+	std::filesystem::path journal_path = std::filesystem::temp_directory_path() / "function_finder_stress.ffj";
+	bool run_queue = true;
+	bool run_journal = true;
+};
+
+/// <summary>
+/// Checks that every producer's numbered commands arrive exactly once and in order. Only used by
+/// one thread at a time.
+/// </summary>
+struct Sequence_Checker
+{
+	std::vector<size_t> next_sequences;
+	size_t received = 0;
+	size_t errors = 0;
+
+	explicit Sequence_Checker(size_t producers)
+		: next_sequences(producers, 0)
+	{
+	}
+
+	void receive(size_t producer, size_t sequence)
+	{
+		received++;
+		if (producer >= next_sequences.size() || sequence != next_sequences[producer])
+		{
+			// Only report the first few, one broken ordering usually breaks many.
+			if (errors++ < 10)
+			{
+				std::cerr << std::format("[ERROR] Got command {} of producer {}, expected command {}\n",
+					sequence, producer, producer < next_sequences.size() ? next_sequences[producer] : 0);
+			}
+			return;
+		}
+		next_sequences[producer]++;
+	}
+
+	/// <summary>
+	/// Whether every producer's commands all arrived, in order.
+	/// </summary>
+	bool is_complete(size_t commands_per_producer) const
+	{
+		for (size_t next : next_sequences)
+		{
+			if (next != commands_per_producer)
+			{
+				return false;
+			}
+		}
+		return errors == 0 && received == next_sequences.size() * commands_per_producer;
+	}
+};
+
+template <typename T>
+bool parse_number(std::string_view source, T &out_value)
+{
+	auto result = std::from_chars(source.data(), source.data() + source.size(), out_value);
+	return result.ec == std::errc() && result.ptr == source.data() + source.size();
+}
+
+/// <summary>
+/// The queue's checker. Only touched by its command, which only runs on the draining thread.
+/// </summary>
+Sequence_Checker *queue_checker = nullptr;
+
+/// <summary>
+/// A hand-written wrapper for 'sequenced <producer> <sequence>', like a generated one would be.
+/// </summary>
+Call_Result sequenced_wrapper(std::vector<std::string> &args, bool call_client_function)
+{
+	Call_Result result{};
+	size_t producer, sequence;
+	if (args.size() != 2 || !parse_number(args[0], producer) || !parse_number(args[1], sequence))
+	{
+		result.status = Call_Result_Status::ARGUMENT_PARSING_ERROR;
+		result.error_message = "Expected a producer and a sequence number";
+		result.error_helper_value = (int)args.size();
+		return result;
+	}
+	if (call_client_function)
+	{
+		queue_checker->receive(producer, sequence);
+	}
+	result.status = Call_Result_Status::SUCCESS;
+	return result;
+}
+
+bool stress_queue(const Stress_Settings &settings, const Function_Map &commands)
+{
+	Sequence_Checker checker(settings.producers);
+	queue_checker = &checker;
+
+	Command_Queue queue(commands);
+	std::atomic<size_t> failed_submits = 0;
+	size_t completions = 0;
+	size_t expected = settings.producers * settings.commands;
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::jthread> producers;
+	for (size_t producer = 0; producer < settings.producers; producer++)
+	{
+		producers.emplace_back([&, producer]
+		{
+			for (size_t sequence = 0; sequence < settings.commands; sequence++)
+			{
+				// Callbacks run on the draining thread, so they can count without synchronizing.
+				bool submitted = queue.submit("sequenced",
+					{ std::to_string(producer), std::to_string(sequence) },
+					[&completions](Call_Result &result)
+					{
+						if (result.status == Call_Result_Status::SUCCESS)
+						{
+							completions++;
+						}
+					});
+				if (!submitted)
+				{
+					failed_submits.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		});
+	}
+
+	// Drain while the producers are submitting, so the consumer races them on a nearly empty
+	// queue, and after they finished until everything ran.
+	size_t drained = 0;
+	while (drained + failed_submits.load(std::memory_order_relaxed) < expected)
+	{
+		size_t count = queue.drain(std::chrono::microseconds(100));
+		drained += count;
+		if (count == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+	producers.clear();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	queue_checker = nullptr;
+
+	bool success = failed_submits == 0 && completions == expected && checker.is_complete(settings.commands);
+	std::cout << std::format("Queue: {} producers, {} commands in {:.3f} s ({:.0f} per second), {} ran, "
+		"{} completed{}\n", settings.producers, expected, seconds, (double)expected / seconds,
+		checker.received, completions, success ? "" : ", FAILED");
+	return success;
+}
+
+bool stress_journal(const Stress_Settings &settings, const Function_Map &commands)
+{
+	std::string path = settings.journal_path.string();
+	uint32_t command_id = register_journal_command("sequenced");
+	if (!start_command_journal(path))
+	{
+		return false;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t round = 0; round < settings.rounds; round++)
+	{
+		std::atomic<size_t> finished = 0;
+		std::vector<std::jthread> producers;
+		for (size_t producer = 0; producer < settings.producers; producer++)
+		{
+			producers.emplace_back([&, producer]
+			{
+				// Numbered across rounds, so the loaded calls can be checked like one long stream.
+				size_t first = round * settings.commands;
+				for (size_t sequence = first; sequence < first + settings.commands; sequence++)
+				{
+					record_journal_call(command_id, (int)producer, (int)sequence);
+				}
+				finished.fetch_add(1, std::memory_order_release);
+			});
+		}
+
+		// Flush while the producers are recording, like a program saving its journal regularly.
+		while (finished.load(std::memory_order_acquire) < settings.producers)
+		{
+			flush_command_journal();
+			std::this_thread::yield();
+		}
+	}
+	size_t buffers;
+	{
+		auto &registry = get_command_journal_registry();
+		std::lock_guard lock(registry.mutex);
+		buffers = registry.thread_buffers.size();
+	}
+	uint64_t bytes = stop_command_journal();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<Journal_Call> calls;
+	Journal_Replay_Stats stats;
+	if (!load_command_journal(path, commands, calls, stats))
+	{
+		return false;
+	}
+
+	Sequence_Checker checker(settings.producers);
+	for (const Journal_Call &call : calls)
+	{
+		size_t producer, sequence;
+		if (call.args.size() != 2 || !parse_number(call.args[0], producer) ||
+			!parse_number(call.args[1], sequence))
+		{
+			std::cerr << "[ERROR] Loaded a call with broken arguments\n";
+			return false;
+		}
+		checker.receive(producer, sequence);
+	}
+
+	// Producers of one round have exited before the next round starts, so their buffers are reused.
+	bool success = checker.is_complete(settings.rounds * settings.commands) &&
+		stats.skipped_calls == 0 && buffers <= settings.producers;
+	size_t expected = settings.rounds * settings.producers * settings.commands;
+	std::cout << std::format("Journal: {} producers, {} calls in {:.3f} s ({:.0f} per second), {} bytes, "
+		"{} loaded, {} thread buffers{}\n", settings.producers, expected, seconds, (double)expected / seconds,
+		bytes, calls.size(), buffers, success ? "" : ", FAILED");
+	return success;
+}
+
+int main(int arg_count, const char **args)
+{
+	Stress_Settings settings;
+	for (int i = 1; i < arg_count; i++)
+	{
+		std::string_view arg = args[i];
+		bool success = true;
+		if (arg.starts_with("--producers="))
+		{
+			success = parse_number(arg.substr(sizeof("--producers=") - 1), settings.producers) &&
+				settings.producers > 0;
+		}
+		else if (arg.starts_with("--commands="))
+		{
+			success = parse_number(arg.substr(sizeof("--commands=") - 1), settings.commands);
+		}
+		else if (arg.starts_with("--rounds="))
+		{
+			success = parse_number(arg.substr(sizeof("--rounds=") - 1), settings.rounds);
+		}
+		else if (arg.starts_with("--journal="))
+		{
+			settings.journal_path = arg.substr(sizeof("--journal=") - 1);
+		}
+		else if (arg == "--queue-only")
+		{
+			settings.run_journal = false;
+		}
+		else if (arg == "--journal-only")
+		{
+			settings.run_queue = false;
+		}
+		else
+		{
+			success = false;
+		}
+
+		if (!success)
+		{
+			std::cerr << std::format("[ERROR] Invalid argument '{}'. See the top of "
+				"concurrency_stress.cpp for usage.\n", arg);
+			return 1;
+		}
+	}
+
+	Function_Map commands;
+	Function_Decl &sequenced = commands["sequenced"];
+	sequenced.name = "sequenced";
+	sequenced.note = "Checks that commands arrive once and in order.";
+	sequenced.function = sequenced_wrapper;
+
+	bool success = true;
+	if (settings.run_queue)
+	{
+		success = stress_queue(settings, commands) && success;
+	}
+	if (settings.run_journal)
+	{
+		success = stress_journal(settings, commands) && success;
+	}
+	return success ? 0 : 1;
+}
@@ -0,0 +1,323 @@
+/*
+Measures the throughput of the import and export pipeline on synthetic source trees.
+
+Runs a set of predefined cases unless a corpus shape is given on the command line. Every case is
+generated into the work directory, then imported and exported in-process a number of times. The
+median of each phase is reported.
+
+Usage:
+    importer_benchmark [options]
+
+    --files=<N>             Number of files in a custom case.
+    --file-size=<bytes>     Approximate size of each file in a custom case.
+    --density=<0..1>        Fraction of generated functions marked as commands.
+    --comments=<style>      none, line, block or mixed.
+    --max-args=<N>          Maximum number of arguments per command.
+    --seed=<N>              Seed for the corpus generator.
+    --iterations=<N>        Number of timed runs per case. Defaults to 5.
+    --work-dir=<path>       Where corpora and outputs are generated.
+    --save=<path>           Save the results as a baseline CSV.
+    --compare=<path>        Compare the results against a baseline CSV. Exits with 1 on regressions.
+    --tolerance=<percent>   How much worse a result may get before it's a regression. Defaults to 10.
+*/
+
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <iostream>
+#include <string_view>
+
+#include "function_finder_internal.hpp"
+#include "synthetic_corpus.hpp"
+#include "benchmark_results.hpp"
+
+// Makes the allocation counts of the import and export phases available in Run_Stats.
+FUNCTION_FINDER_ALLOCATION_HOOKS
+
+/// <summary>
+/// A named corpus shape.
+/// </summary>
+struct Benchmark_Case
+{
+	std::string name;
+	Corpus_Settings corpus;
+};
+
+/// <summary>
+/// Command line settings of the benchmark.
+/// </summary>
+struct Benchmark_Settings
+{
+	std::vector<Benchmark_Case> cases;
+	size_t iterations = 5;
+	std::filesystem::path work_dir = std::filesystem::temp_directory_path() / "function_finder_benchmark";
+	std::filesystem::path save_path;
+	std::filesystem::path compare_path;
+	double tolerance_percent = 10.0;
+};
+
+std::vector<Benchmark_Case> default_cases()
+{
+	std::vector<Benchmark_Case> cases;
+
+	Benchmark_Case small{ "small", {} };
+	small.corpus.file_count = 50;
+	small.corpus.file_size = 8 * 1024;
+	cases.push_back(small);
+
+	Benchmark_Case medium{ "medium", {} };
+	medium.corpus.file_count = 500;
+	medium.corpus.file_size = 16 * 1024;
+	cases.push_back(medium);
+
+	Benchmark_Case large{ "large", {} };
+	large.corpus.file_count = 2000;
+	large.corpus.file_size = 32 * 1024;
+	cases.push_back(large);
+
+	// Many commands with many arguments and notes. Stresses get_arguments and the exporter.
+	Benchmark_Case dense{ "dense", {} };
+	dense.corpus.file_count = 200;
+	dense.corpus.file_size = 16 * 1024;
+	dense.corpus.command_density = 1.0;
+	dense.corpus.max_arguments = 8;
+	dense.corpus.comment_style = Comment_Style::BLOCK;
+	cases.push_back(dense);
+
+	// Few commands in large files. Stresses scanning.
+	Benchmark_Case sparse{ "sparse", {} };
+	sparse.corpus.file_count = 200;
+	sparse.corpus.file_size = 64 * 1024;
+	sparse.corpus.command_density = 0.02;
+	cases.push_back(sparse);
+
+	return cases;
+}
+
+template <typename T>
+bool parse_number(std::string_view source, T &out_value)
+{
+	auto result = std::from_chars(source.data(), source.data() + source.size(), out_value);
+	return result.ec == std::errc() && result.ptr == source.data() + source.size();
+}
+
+bool parse_benchmark_settings(int arg_count, const char **args, Benchmark_Settings &out_settings)
+{
+	Benchmark_Case custom{ "custom", {} };
+	bool has_custom_case = false;
+
+	for (int i = 1; i < arg_count; i++)
+	{
+		std::string_view arg = args[i];
+		auto equals = arg.find('=');
+		std::string_view name = arg.substr(0, equals);
+		std::string_view value = equals == std::string_view::npos ? "" : arg.substr(equals + 1);
+
+		bool success = true;
+		if (name == "--files")
+		{
+			success = parse_number(value, custom.corpus.file_count);
+			has_custom_case = true;
+		}
+		else if (name == "--file-size")
+		{
+			success = parse_number(value, custom.corpus.file_size);
+			has_custom_case = true;
+		}
+		else if (name == "--density")
+		{
+			success = parse_number(value, custom.corpus.command_density);
+			has_custom_case = true;
+		}
+		else if (name == "--comments")
+		{
+			success = parse_comment_style(value, custom.corpus.comment_style);
+			has_custom_case = true;
+		}
+		else if (name == "--max-args")
+		{
+			success = parse_number(value, custom.corpus.max_arguments);
+			has_custom_case = true;
+		}
+		else if (name == "--seed")
+		{
+			success = parse_number(value, custom.corpus.seed);
+			has_custom_case = true;
+		}
+		else if (name == "--iterations")
+		{
+			success = parse_number(value, out_settings.iterations) && out_settings.iterations > 0;
+		}
+		else if (name == "--work-dir")
+		{
+			out_settings.work_dir = value;
+		}
+		else if (name == "--save")
+		{
+			out_settings.save_path = value;
+		}
+		else if (name == "--compare")
+		{
+			out_settings.compare_path = value;
+		}
+		else if (name == "--tolerance")
+		{
+			success = parse_number(value, out_settings.tolerance_percent);
+		}
+		else
+		{
+			success = false;
+		}
+
+		if (!success)
+		{
+			std::cerr << std::format("[ERROR] Invalid argument '{}'. See the top of "
+				"importer_benchmark.cpp for usage.\n", arg);
+			return false;
+		}
+	}
+
+	if (has_custom_case)
+	{
+		out_settings.cases.push_back(custom);
+	}
+	else
+	{
+		out_settings.cases = default_cases();
+	}
+	return true;
+}
+
+double median_milliseconds(std::vector<std::chrono::nanoseconds> durations)
+{
+	std::sort(durations.begin(), durations.end());
+	return std::chrono::duration<double, std::milli>(durations[durations.size() / 2]).count();
+}
+
+bool run_case(const Benchmark_Case &benchmark_case, const Benchmark_Settings &benchmark_settings,
+	std::vector<Benchmark_Result> &inout_results)
+{
+	auto corpus_dir = benchmark_settings.work_dir / benchmark_case.name;
+
+	Corpus_Info info;
+	if (!generate_corpus(corpus_dir, benchmark_case.corpus, info))
+	{
+		return false;
+	}
+
+	Settings settings;
+	settings.source = corpus_dir;
+	settings.destination = benchmark_settings.work_dir / (benchmark_case.name + "_out.hpp");
+	settings.search_term = benchmark_case.corpus.search_term;
+	settings.init_function_name = "init_benchmark_commands";
+	settings.wrapper_function_prefix = "_benchmark_wrapper_";
+	settings.quiet = true;
+
+	std::vector<std::chrono::nanoseconds> import_times, scan_times, parse_times, export_times,
+		write_times, total_times;
+	Run_Stats last_stats;
+
+	for (size_t i = 0; i < benchmark_settings.iterations; i++)
+	{
+		Import_Arena arena;
+		std::vector<Parsed_Function> functions;
+		Run_Stats stats;
+
+		auto start = std::chrono::steady_clock::now();
+		bool success = import_functions(settings, arena, functions, stats);
+		auto import_end = std::chrono::steady_clock::now();
+		success = success && export_functions(settings, functions, stats);
+		auto end = std::chrono::steady_clock::now();
+
+		if (!success)
+		{
+			std::cerr << std::format("[ERROR] Case '{}' failed to import or export\n", benchmark_case.name);
+			return false;
+		}
+
+		if (functions.size() != info.commands)
+		{
+			std::cerr << std::format("[WARNING] Case '{}' generated {} commands but {} were found\n",
+				benchmark_case.name, info.commands, functions.size());
+		}
+
+		import_times.push_back(import_end - start);
+		scan_times.push_back(stats.scan);
+		parse_times.push_back(stats.parse);
+		export_times.push_back(stats.export_code);
+		write_times.push_back(stats.write);
+		total_times.push_back(end - start);
+		last_stats = stats;
+	}
+
+	double import_ms = median_milliseconds(import_times);
+	double total_ms = median_milliseconds(total_times);
+	double megabytes = (double)info.bytes / (1024.0 * 1024.0);
+	double megabytes_per_second = import_ms > 0 ? megabytes / (import_ms / 1000.0) : 0;
+	auto add = [&](const char *metric, double value, bool lower_is_better)
+		{ inout_results.push_back({ benchmark_case.name, metric, value, lower_is_better }); };
+
+	add("files", (double)info.files, true);
+	add("bytes", (double)info.bytes, true);
+	add("functions", (double)info.commands, true);
+	add("import_ms", import_ms, true);
+	add("scan_ms", median_milliseconds(scan_times), true);
+	add("parse_ms", median_milliseconds(parse_times), true);
+	add("export_ms", median_milliseconds(export_times), true);
+	add("write_ms", median_milliseconds(write_times), true);
+	add("total_ms", total_ms, true);
+	add("import_mb_per_s", megabytes_per_second, false);
+	add("import_allocs", (double)last_stats.import_allocations.allocations, true);
+	add("import_alloc_bytes", (double)last_stats.import_allocations.bytes, true);
+	add("export_allocs", (double)last_stats.export_allocations.allocations, true);
+	add("export_alloc_bytes", (double)last_stats.export_allocations.bytes, true);
+	add("functions_per_s", import_ms > 0 ? (double)info.commands / (import_ms / 1000.0) : 0, false);
+
+	std::cout << std::format("{}: {} files, {:.2f} MB, {} commands. Import {:.3f} ms ({:.1f} MB/s), "
+		"total {:.3f} ms\n", benchmark_case.name, info.files, megabytes, info.commands, import_ms,
+		megabytes_per_second, total_ms);
+	return true;
+}
+
+int main(int arg_count, const char **args)
+{
+	Benchmark_Settings settings;
+	if (!parse_benchmark_settings(arg_count, args, settings))
+	{
+		return 1;
+	}
+
+	std::vector<Benchmark_Result> results;
+	for (const auto &benchmark_case : settings.cases)
+	{
+		if (!run_case(benchmark_case, settings, results))
+		{
+			return 1;
+		}
+	}
+
+	std::cout << '\n';
+	print_benchmark_results(results, std::cout);
+
+	if (!settings.save_path.empty() && !write_benchmark_results(settings.save_path, results))
+	{
+		return 1;
+	}
+
+	if (!settings.compare_path.empty())
+	{
+		std::vector<Benchmark_Result> baseline;
+		if (!read_benchmark_results(settings.compare_path, baseline))
+		{
+			return 1;
+		}
+
+		std::cout << '\n';
+		if (!compare_benchmark_results(baseline, results, settings.tolerance_percent, std::cout))
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
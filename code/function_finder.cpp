@@ -6,110 +6,65 @@ Copyright Daniel 2023
 #include "function_finder_internal.hpp"
 #include <cassert>
 
-/// <summary>
-/// These are the possible exit codes and their meanings.
-/// </summary>
-struct Return_Codes
+bool import_functions(const Settings &settings, Import_Arena &arena,
+	std::vector<Parsed_Function> &inout_functions, Run_Stats &inout_stats)
 {
-	enum Enum
-	{
-		// No errors reported
-		SUCCESS = 0,
-		// Incorrect arguments.
-		ERROR_INSUFFICIENT_ARGUMENTS = 1,
-	};
-};
-
-int main(int arg_count, const char **args)
-{
-	// Parse arguments
-	if (arg_count < 2)
-	{
-		std::cerr << "[ERROR] Insufficient arguments. See '--help' for usage guide.\n";
-        return Return_Codes::ERROR_INSUFFICIENT_ARGUMENTS;
-	}
-
-	std::string_view arg_1 = args[1];
-
-
-	if (arg_1 == "--help")
-	{
-		print_help();
-	}
-	else if (arg_1 == "--extensions")
-	{
-		print_extensions();
-	}
-	else if (arg_1 == "--example")
-	{
-		print_example();
-	}
-	else if (arg_count != 6)
+	// Print a helpful message to stdout
+	if (!settings.quiet)
 	{
-		std::cerr << "[ERROR] Needs a input path, output path, search_term, "
-			"init_function name, and wrapper function prefix as arguments. Terminating.\n";
-	
-		return Return_Codes::ERROR_INSUFFICIENT_ARGUMENTS;
-	}
-	else
-	{	
-		// Save settings
-		Settings settings;
-		settings.source = arg_1;
-		settings.destination = args[2];
-		settings.search_term = args[3];
-		settings.init_function_name = args[4];
-		settings.wrapper_function_prefix = args[5];
-
-		std::vector<Function_Decl> functions;
-		import_functions(settings, functions);
-
-		export_functions(settings, functions);
-
+		std::cout << std::format("Scanning for functions in '{}' and exporting into '{}'\n",
+			settings.source.generic_string(), settings.destination.generic_string());
 	}
 
-	return Return_Codes::SUCCESS;
-}
-
-bool import_functions(const Settings &settings, std::vector<Function_Decl> &inout_functions)
-{
-	// Print a helpful message to stdout
-	std::cout << std::format("Scanning for functions in '{}' and exporting into '{}'\n",
-		settings.source.generic_string(), settings.destination.generic_string());
+	Scoped_Allocation_Counter allocations(inout_stats.import_allocations);
+	bool success = false;
+	auto start = std::chrono::steady_clock::now();
+	auto time_in_files = inout_stats.read + inout_stats.scan + inout_stats.parse;
 
 	if (std::filesystem::is_regular_file(settings.source))
 	{
-		return import_file(settings.source, inout_functions, settings);
+		success = import_file(settings.source, arena, inout_functions, settings, inout_stats);
 	}
 	else if (std::filesystem::is_directory(settings.source))
 	{
 		// It's a directory
-		return import_directory(settings.source, inout_functions, settings);
+		success = import_directory(settings.source, arena, inout_functions, settings, inout_stats);
+	}
+	else
+	{
+		std::cerr << "[ERROR] Source is neither a file nor directory... What did you feed me?\n";
+		return false;
 	}
 
-	std::cerr << "[ERROR] Source is neither a file nor directory... What did you feed me?\n";
-	return false;
+	// Whatever wasn't spent inside files was spent walking the directory tree.
+	time_in_files = inout_stats.read + inout_stats.scan + inout_stats.parse - time_in_files;
+	inout_stats.directory_walk += std::chrono::steady_clock::now() - start - time_in_files;
+
+	return success;
 }
 
 
-bool import_directory(const std::filesystem::path &path,
-	std::vector<Function_Decl> &inout_functions,
-	const Settings &settings)
+bool import_directory(const std::filesystem::path &path, Import_Arena &arena,
+	std::vector<Parsed_Function> &inout_functions,
+	const Settings &settings, Run_Stats &inout_stats)
 {
 	for (const auto &ele : std::filesystem::directory_iterator(path))
 	{
 		// Check whether it's a matching file, or a directory.
 		if (ele.is_regular_file() && file_matches_extension(ele.path()))
 		{
-			std::cout << std::format("  - {}\n", ele.path().generic_string());
-			if (!import_file(ele.path(), inout_functions, settings))
+			if (!settings.quiet)
+			{
+				std::cout << std::format("  - {}\n", ele.path().generic_string());
+			}
+			if (!import_file(ele.path(), arena, inout_functions, settings, inout_stats))
 			{
 				return false;
 			}
 		}
 		else if (ele.is_directory())
 		{
-			if (!import_directory(ele.path(), inout_functions, settings))
+			if (!import_directory(ele.path(), arena, inout_functions, settings, inout_stats))
 			{
 				return false;
 			}
@@ -132,30 +87,50 @@ bool matches_search_term(std::string_view source, const Settings &settings)
 }
 
 
-bool import_file(const std::filesystem::path &path, std::vector<Function_Decl> &inout_functions,
-	const Settings &settings)
+bool import_file(const std::filesystem::path &path, Import_Arena &arena,
+	std::vector<Parsed_Function> &inout_functions, const Settings &settings, Run_Stats &inout_stats)
 {
-	std::string content_str = read_file_to_string(path);
+	auto start = std::chrono::steady_clock::now();
+	auto parse_time_before = inout_stats.parse;
+
+	std::string content_str;
+	{
+		Scoped_Timer timer(inout_stats.read);
+		content_str = read_file_to_string(path);
+	}
+	auto read_end = std::chrono::steady_clock::now();
 	std::string_view content_view = content_str;
 
+	File_Stats file_stats;
+	file_stats.path = path;
+	file_stats.bytes = content_str.size();
+
+	// Shared by all functions in the file.
+	std::string_view file = arena.intern(path.generic_string());
+
 	// Loop over every line in the file, checking to see if it starts with the search term.
 	for (size_t line = 1; true; line++)
 	{
 		if (matches_search_term(content_view, settings))
 		{
-			Function_Decl func;
+			Parsed_Function func;
 			func.line = line + 1;
-			func.file = path.generic_string();
+			func.file = file;
 
 			auto func_view = skip_whitespace(content_view);
 
-			bool success = import_function(func_view, &func, settings);
+			bool success;
+			{
+				Scoped_Timer timer(inout_stats.parse);
+				success = import_function(func_view, arena, &func, settings);
+			}
 			if (!success)
 			{
 				return false;
 			}
 
 			inout_functions.push_back(func);
+			file_stats.functions++;
 		}
 
 		// Check for end of file.
@@ -167,27 +142,39 @@ bool import_file(const std::filesystem::path &path, std::vector<Function_Decl> &
 		content_view = content_view.substr(next_line_end + 1);
 	}
 
+	// Scanning is whatever time after reading wasn't spent parsing.
+	auto end = std::chrono::steady_clock::now();
+	inout_stats.scan += end - read_end - (inout_stats.parse - parse_time_before);
+
+	file_stats.duration = end - start;
+	inout_stats.files_scanned++;
+	inout_stats.bytes_scanned += file_stats.bytes;
+	inout_stats.functions_found += file_stats.functions;
+	inout_stats.files.push_back(file_stats);
+
 	return true;
 }
 
-bool import_function(std::string_view source, Function_Decl *out_function, const Settings &setting)
+bool import_function(std::string_view source, Import_Arena &arena, Parsed_Function *out_function,
+	const Settings &setting)
 {
 	// Skip the search term
 	auto current = advance(source, setting.search_term.size());
 	current = skip_whitespace(current);
 
 	// Check for note
-	std::string note;
+	std::string_view note;
 	current = skip_whitespace(current);
 	auto comment_size = get_comment(current, note);
 	if(comment_size)
 	{
-		out_function->note = note;
+		out_function->note = store_note(arena, note);
 		current = advance(current, comment_size);
 	}
 
 
 	// Skip any other tags by waiting until we get either "inline" or some return type.
+	auto declaration = skip_whitespace(current);
 	bool found_function = false;
 	while(true)
 	{
@@ -199,7 +186,7 @@ bool import_function(std::string_view source, Function_Decl *out_function, const
 			break;
 		}
 
-		// ... or if it's a supported type we support.
+		// ... or if it's a supported type we support...
 		Value_Type type;
 		size_t type_length = get_type(current, type);
 		if(type_length && type != Value_Type::UNKNOWN)
@@ -207,19 +194,35 @@ bool import_function(std::string_view source, Function_Decl *out_function, const
 			break;
 		}
 
+		// ... or if it's the task type of an asynchronous function.
+		if(get_task_type(current, setting, type))
+		{
+			break;
+		}
+
 		// If we get here there's another tag term or something else we don't support!
 		// Using get_symbol is not exactly right, since this would also support colons which is wrong.
-		std::string tag;
+		std::string_view tag;
 		auto tag_size = get_symbol(current, tag);
-		if(tag_size)
+		if(!tag_size)
 		{
-			current = advance(current, tag_size);
-			std::string other_tag_comment;
-			auto comment_size = get_comment(current, other_tag_comment);
-			if(comment_size)
-			{
-				current = advance(current, comment_size);
-			}
+			// Not a tag either, like the '<int>' of an unsupported 'Task<int>'.
+			std::cerr << std::format("[ERROR] Unsupported return type in '{}'. Coroutines are only "
+				"supported with '--task-type'\n", declaration.substr(0, declaration.find('(')));
+			return false;
+		}
+
+		if(!setting.memoize_tag.empty() && tag == setting.memoize_tag)
+		{
+			out_function->is_memoized = true;
+		}
+
+		current = skip_whitespace(advance(current, tag_size));
+		std::string_view other_tag_comment;
+		auto comment_size = get_comment(current, other_tag_comment);
+		if(comment_size)
+		{
+			current = advance(current, comment_size);
 		}
 	}
 
@@ -231,39 +234,84 @@ bool import_function(std::string_view source, Function_Decl *out_function, const
 		current = advance(current, sizeof("inline"));
 	}
 
-	size_t final_length = get_type(current, out_function->return_type);
+	size_t final_length = get_task_type(current, setting, out_function->return_type);
+	out_function->is_async = final_length != 0;
+	if (out_function->is_async && out_function->return_type == Value_Type::UNKNOWN)
+	{
+		std::cerr << std::format("[ERROR] Unsupported task result type in '{}'. Tasks can produce "
+			"void, int, float, double, bool or std::string\n", current.substr(0, current.find('(')));
+		return false;
+	}
+	if (!out_function->is_async)
+	{
+		final_length = get_type(current, out_function->return_type);
+	}
+	if (is_array_type(out_function->return_type))
+	{
+		std::cerr << std::format("[ERROR] Lists are only supported as argument types, not as the "
+			"return type of '{}'\n", current.substr(0, current.find('(')));
+		return false;
+	}
+	out_function->return_cpp_type = arena.intern(current.substr(0, final_length));
 	current = advance(current, final_length);
 	current = skip_whitespace(current);
 
-	size_t length = get_symbol(current, out_function->name);
+	std::string_view name;
+	size_t length = get_symbol(current, name);
 	if (!length)
 	{
 		std::cerr << "[ERROR] Failed to get function name '" << current << "'\n";
 		return false;
 	}
+	out_function->name = arena.copy(name);
 
 	out_function->create_predeclaration = out_function->name.find(":") == std::string::npos;
 
 	final_length += length;
 	current = advance(current, length);
 
-	bool success = get_arguments(current, out_function->arguments);
+	bool success = get_arguments(current, arena, out_function->arguments);
 	if (!success)
 	{
 		std::cerr << "[ERROR] Failed to get arguments for function '" << out_function->name << "'\n";
 		return false;
 	}
 
-	out_function->num_optional_args = (int)std::count_if(out_function->arguments.begin(), out_function->arguments.end(), [](Argument &arg)
+	out_function->num_optional_args = (int)std::count_if(out_function->arguments.begin(), out_function->arguments.end(), [](const Parsed_Argument &arg)
 		{ return arg.has_default_value; });
-	out_function->num_required_args = out_function->arguments.size() - out_function->num_optional_args;
+	out_function->num_required_args = (int)out_function->arguments.size() - out_function->num_optional_args;
 
 	return true;
 }
 
 
-bool export_functions(const Settings &settings, const std::vector<Function_Decl> &functions)
+bool export_functions(const Settings &settings, const std::vector<Parsed_Function> &functions,
+	Run_Stats &inout_stats)
 {
+	Scoped_Allocation_Counter allocations(inout_stats.export_allocations);
+
+	// Generate the whole file in memory first, so generating and writing can be timed separately.
+	std::string output;
+	{
+		Scoped_Timer timer(inout_stats.export_code);
+		Cpp_File_Writer w(output);
+
+		export_header(w, settings);
+		export_pre_declarations(w, functions, settings);
+		export_wrapper_functions(w, functions, settings, inout_stats.export_allocations);
+		if (!settings.command_id_type.empty())
+		{
+			export_command_ids(w, functions, settings);
+		}
+		export_initialization_function(w, functions, settings, inout_stats.export_allocations);
+		if (settings.shared_library)
+		{
+			export_registration_function(w, settings);
+		}
+	}
+
+	Scoped_Timer timer(inout_stats.write);
+
 	// Create file and needed folders to get there.
 	std::filesystem::create_directories(settings.destination.parent_path());
 	std::ofstream file(settings.destination);
@@ -274,20 +322,14 @@ bool export_functions(const Settings &settings, const std::vector<Function_Decl>
 		return false;
 	}
 
-	Cpp_File_Writer w(file);
-
-	export_header(w, settings);
-	export_pre_declarations(w, functions);
-	export_wrapper_functions(w, functions, settings);
-	export_initialization_function(w, functions, settings);
-
+	file.write(output.data(), (std::streamsize)output.size());
 	file.close();
 	return true;
 }
 
 // Returns the size of the comment. If it returns 0 then there is no comment.
 // Does not skip whitespace, do it yourself!
-size_t get_comment(std::string_view source, std::string &out_result)
+size_t get_comment(std::string_view source, std::string_view &out_result)
 {
 	auto current = source;
 
@@ -326,7 +368,7 @@ size_t get_comment(std::string_view source, std::string &out_result)
 		}
 		
 		
-		out_result = std::string(current.begin(), current.begin() + comment_end);
+		out_result = current.substr(0, comment_end);
 		current = advance(current, end + 1);
 	}
 	else
@@ -349,10 +391,7 @@ size_t get_comment(std::string_view source, std::string &out_result)
 			comment_end--;
 		}
 		
-		out_result = std::string(current.begin(), current.begin() + comment_end);
-
-		// Sanitize.
-		out_result = std::regex_replace(out_result, std::regex("\n"), "\\n");
+		out_result = current.substr(0, comment_end);
 		current = advance(current, end + 2);
 	}
 
@@ -361,13 +400,40 @@ size_t get_comment(std::string_view source, std::string &out_result)
 
 }
 
+std::string_view store_note(Import_Arena &arena, std::string_view comment)
+{
+	// Newlines are written as "\n" so the note fits in a string literal.
+	size_t newlines = std::count(comment.begin(), comment.end(), '\n');
+	if (newlines == 0)
+	{
+		return arena.copy(comment);
+	}
+
+	size_t size = comment.size() + newlines;
+	char *destination = arena.allocate<char>(size);
+	char *cursor = destination;
+	for (char c : comment)
+	{
+		if (c == '\n')
+		{
+			*cursor++ = '\\';
+			*cursor++ = 'n';
+		}
+		else
+		{
+			*cursor++ = c;
+		}
+	}
+	return { destination, size };
+}
+
 size_t get_type(std::string_view source, Value_Type &out_type)
 {
 	size_t result = 0;
 	
 	auto current = skip_whitespace(source);
 
-	std::string str;
+	std::string_view str;
 	size_t length = get_symbol(source, str);
 	if (!length)
 	{
@@ -404,12 +470,96 @@ size_t get_type(std::string_view source, Value_Type &out_type)
 	{
 		type = Value_Type::VOID;
 	}
+	else if (str == "std::vector" || str == "std::span")
+	{
+		// Lists of numbers, like 'std::vector<float>' or 'std::span<const int>'.
+		result += get_array_element_type(source, type);
+	}
 
 	out_type = type;
 
 	return result;
 }
 
+size_t get_array_element_type(std::string_view source, Value_Type &out_type)
+{
+	out_type = Value_Type::UNKNOWN;
+
+	auto current = skip_whitespace(source);
+	if (!current.starts_with('<'))
+	{
+		return 0;
+	}
+	current = skip_whitespace(advance(current, (size_t)1));
+
+	// Spans of const elements are fine, the wrapper owns the storage.
+	if (current.starts_with("const") && current.size() > 5 && std::isspace(current[5]))
+	{
+		current = skip_whitespace(advance(current, (size_t)5));
+	}
+
+	std::string_view element;
+	size_t element_length = get_symbol(current, element);
+	current = skip_whitespace(advance(current, element_length));
+	if (!element_length || !current.starts_with('>'))
+	{
+		return 0;
+	}
+	current = advance(current, (size_t)1);
+
+	if (element == "int")
+	{
+		out_type = Value_Type::INTEGER_ARRAY;
+	}
+	else if (element == "float")
+	{
+		out_type = Value_Type::FLOAT_ARRAY;
+	}
+	else if (element == "double")
+	{
+		out_type = Value_Type::DOUBLE_ARRAY;
+	}
+
+	return source.size() - current.size();
+}
+
+size_t get_task_type(std::string_view source, const Settings &settings, Value_Type &out_type)
+{
+	out_type = Value_Type::UNKNOWN;
+	if (settings.task_type.empty())
+	{
+		return 0;
+	}
+
+	std::string_view name;
+	size_t name_length = get_symbol(source, name);
+	if (!name_length || name != settings.task_type)
+	{
+		return 0;
+	}
+
+	// A task without template arguments doesn't produce a value.
+	auto current = skip_whitespace(advance(source, name_length));
+	if (!current.starts_with('<'))
+	{
+		out_type = Value_Type::VOID;
+		return name_length;
+	}
+	current = skip_whitespace(advance(current, (size_t)1));
+
+	Value_Type type;
+	size_t type_length = get_type(current, type);
+	current = skip_whitespace(advance(current, type_length));
+	if (!type_length || !current.starts_with('>'))
+	{
+		return 0;
+	}
+	current = advance(current, (size_t)1);
+
+	out_type = is_array_type(type) ? Value_Type::UNKNOWN : type;
+	return source.size() - current.size();
+}
+
 size_t parse_type(std::string_view source, Value_Type type, Value &out_result)
 {
 	size_t length = 0;
@@ -434,7 +584,7 @@ size_t parse_type(std::string_view source, Value_Type type, Value &out_result)
 		length = get_quoted_string(source, result);
 		if (length)
 		{
-			strncpy(out_result.data.string_value, result.c_str(), result.length());
+			set_string_value(out_result, result);
 		}
 		break;
 		}
@@ -443,31 +593,39 @@ size_t parse_type(std::string_view source, Value_Type type, Value &out_result)
 	return length;
 }
 
-size_t get_argument(std::string_view source, Argument &out_arg)
+size_t get_argument(std::string_view source, Import_Arena &arena, Parsed_Argument &out_arg)
 {
 	auto current = skip_whitespace(source);
 
-	// Get the type
+	// Get the type. The spelling is kept as written, since lists can be declared as either
+	// std::vector or std::span.
 	Value_Type type;
 	auto type_length = get_type(current, type);
+	out_arg.cpp_type = arena.intern(current.substr(0, type_length));
 	current = advance(current, type_length);
 
 	// Get the argument name
 	current = skip_whitespace(current);
-	std::string name;
+	std::string_view name;
 	size_t name_length = get_symbol(current, name);
 	if (!name_length)
 	{
 		std::cout << std::format("[ERROR] Failed to get argument name at position '{}'\n", current);
 		return 0;
 	}
-	out_arg.name = name;
+	out_arg.name = arena.copy(name);
 	out_arg.type = type;
 
 	current = advance(current, name_length);
 	current = skip_whitespace(current);
 
 	// Check for default value
+	if (current.size() > 0 && current[0] == '=' && is_array_type(type))
+	{
+		std::cerr << std::format("[ERROR] Default values aren't supported for list argument '{}'\n",
+			name);
+		return 0;
+	}
 	if (current.size() > 0 && current[0] == '=')
 	{
 		out_arg.has_default_value = true;
@@ -487,14 +645,14 @@ size_t get_argument(std::string_view source, Argument &out_arg)
 	//std::cout << name << " after skipping whitespace: " << current << '(' << source.size() - current.size() << " of " << source.size() << ')' <<   std::endl;
 	
 	// Check for note.
-	std::string note;
+	std::string_view note;
 	size_t comment_length = get_comment(current, note);
 	//std::cout << "after getting comment: " << current << '(' << source.size() - current.size() << " of " << source.size() << ')' <<   std::endl;
 	if(comment_length)
 	{
 		//std::cout << "There is a comment: '" << note << "'\n";
 		current = advance(current, comment_length);
-		out_arg.note = note;
+		out_arg.note = store_note(arena, note);
 	}
 
 	//std::cout << "after comment_length check: " << current << '(' << source.size() - current.size() << " of " << source.size() << ')' <<   std::endl;
@@ -502,8 +660,14 @@ size_t get_argument(std::string_view source, Argument &out_arg)
 	return source.size();
 }
 
-bool get_arguments(std::string_view source, std::vector<Argument> &out_args)
+bool get_arguments(std::string_view source, Import_Arena &arena,
+	std::span<const Parsed_Argument> &out_args)
 {
+	// Collected here first, since the count isn't known up front, then copied into the arena in
+	// one piece. Reused across calls, so it stops allocating once it has grown to the longest list.
+	thread_local std::vector<Parsed_Argument> args;
+	args.clear();
+
 	source = skip_whitespace(source);
 
 	if (source[0] != '(')
@@ -578,15 +742,15 @@ bool get_arguments(std::string_view source, std::vector<Argument> &out_args)
 		{
 			auto arg_source = source.substr(0, length - 1);
 
-			Argument arg{};
-			bool success = get_argument(arg_source, arg);
+			Parsed_Argument arg{};
+			bool success = get_argument(arg_source, arena, arg);
 
 			if (!success)
 			{
 				return false;
 			}
 
-			out_args.push_back(arg);
+			args.push_back(arg);
 		}
 
 		if (found_end_parenthesis)
@@ -596,6 +760,9 @@ bool get_arguments(std::string_view source, std::vector<Argument> &out_args)
 		source = advance(source, length);
 	}
 
+	Parsed_Argument *stored_args = arena.allocate<Parsed_Argument>(args.size());
+	std::uninitialized_copy(args.begin(), args.end(), stored_args);
+	out_args = { stored_args, args.size() };
 	return true;
 }
 
@@ -608,24 +775,110 @@ void export_header(Cpp_File_Writer &w, const Settings &settings)
 {
 	w << "// The contents of this file are auto-generated.";
 	std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-	w << std::format("// This file was generated {}", std::ctime(&now));
+	w.format("// This file was generated {}", std::ctime(&now));
 	w << "// Generation options:";
-	w << std::format("//   Input path: {}", settings.source.generic_string());
-	w << std::format("//   Output path: {}", settings.destination.generic_string());
-	w << std::format("//   Search pattern: {}", settings.search_term);
-	w << std::format("//   Initialization function name: {}", settings.init_function_name);
-	w << "#pragma once";
+	w.format("//   Input path: {}", settings.source.generic_string());
+	w.format("//   Output path: {}", settings.destination.generic_string());
+	w.format("//   Search pattern: {}", settings.search_term);
+	w.format("//   Initialization function name: {}", settings.init_function_name);
+	w.format("//   Instrumented: {}", settings.instrument ? "yes" : "no");
+	if (!settings.task_type.empty())
+	{
+		w.format("//   Task type: {}", settings.task_type);
+	}
+	if (settings.wrapper_style == Wrapper_Style::TEMPLATE)
+	{
+		w << "//   Wrappers: template";
+	}
+	else if (settings.wrapper_style == Wrapper_Style::TABLE)
+	{
+		w << "//   Wrappers: table";
+	}
+	if (settings.inline_errors)
+	{
+		w << "//   Errors: inline";
+	}
+	if (!settings.memoize_tag.empty())
+	{
+		w.format("//   Memoize tag: {}", settings.memoize_tag);
+	}
+	if (settings.typed_entries)
+	{
+		w << "//   Typed entries: yes";
+	}
+	if (settings.journal)
+	{
+		w << "//   Journal: yes";
+	}
+	if (settings.binary_entries)
+	{
+		w << "//   Binary entries: yes";
+	}
+	if (settings.shared_library)
+	{
+		w << "//   Shared library: yes";
+	}
+	if (!settings.module_name.empty())
+	{
+		// Everything up to the module declaration is the global module fragment, which may only
+		// contain preprocessor directives.
+		w.format("//   Module: {} (experimental)", settings.module_name);
+		w << "module;";
+	}
+	else
+	{
+		w << "#pragma once";
+	}
 	w.skip_line();
 
 	// Includes
 	w << "// Includes:";
 	w << "#include <unordered_map>";
+	w << "#include <span>";
 	w << "#include <string>";
+	w << "#include <vector>";
 	w << R"(#include "function_finder/function_finder.hpp")";
+	if (settings.instrument)
+	{
+		w << R"(#include "function_finder/instrumentation.hpp")";
+	}
+	if (!settings.task_type.empty())
+	{
+		w << R"(#include "function_finder/command_task.hpp")";
+	}
+	if (settings.wrapper_style == Wrapper_Style::TEMPLATE)
+	{
+		w << R"(#include "function_finder/template_wrappers.hpp")";
+	}
+	if (!settings.memoize_tag.empty())
+	{
+		w << R"(#include "function_finder/memoization.hpp")";
+	}
+	if (settings.journal)
+	{
+		w << R"(#include "function_finder/command_journal.hpp")";
+	}
+	if (settings.binary_entries)
+	{
+		w << R"(#include "function_finder/binary_arguments.hpp")";
+	}
+	for (const auto &include : settings.module_includes)
+	{
+		w.format("#include \"{}\"", include);
+	}
 	w.skip_line();
+
+	// Re-export the runtime, so consumers only need to import the registry.
+	if (!settings.module_name.empty())
+	{
+		w.format("export module {};", settings.module_name);
+		w << "export import function_finder;";
+		w.skip_line();
+	}
 }
 
-void export_pre_declarations(Cpp_File_Writer &w, const std::vector<Function_Decl> &functions)
+void export_pre_declarations(Cpp_File_Writer &w, const std::vector<Parsed_Function> &functions,
+	const Settings &settings)
 {
 	// Write a section header to make it easier to navigate the output file.
 	w << "//////////////////////////////";
@@ -634,18 +887,38 @@ void export_pre_declarations(Cpp_File_Writer &w, const std::vector<Function_Decl
 
 	w << "// Pre-declarations of client-functions";
 	w.skip_line();
+
+	// Client headers included into a module declare the commands. Declaring them again in the
+	// module would conflict with those declarations on some compilers.
+	bool is_module = !settings.module_name.empty();
+	if (is_module && !settings.module_includes.empty())
+	{
+		w << "// Declared by the included client headers.";
+		w.skip_line();
+		return;
+	}
+
+	// In a module the client functions have to be attached to the global module, like the
+	// definitions in the client's source files.
+	if (is_module)
+	{
+		w << "extern \"C++\"";
+		w << "{";
+		w.skip_line();
+	}
+
 	for (const auto &f : functions)
 	{
 		if(!f.create_predeclaration)
 			continue;
 
-		w << std::format("// From \"{}\" L{}", f.file, f.line);
+		w.format("// From \"{}\" L{}", f.file, f.line);
 		w.enable_line_continuation_mode();
-		w << value_type_to_cpp_type(f.return_type) << " " << f.name << "(";
+		w << f.return_cpp_type << " " << f.name << "(";
 		for (int i = 0; i < f.arguments.size(); i++)
 		{
-			const Argument &arg = f.arguments[i];
-			w << value_type_to_cpp_type(arg.type) << " " << arg.name;
+			const Parsed_Argument &arg = f.arguments[i];
+			w << arg.cpp_type << " " << arg.name;
 
 			// NOTE: We intentionally leave out the default value here. Since the compiler will 
 			// complain if we define it twice. Default arguments are handled in the generated
@@ -659,10 +932,16 @@ void export_pre_declarations(Cpp_File_Writer &w, const std::vector<Function_Decl
 		w.disable_line_continuation_mode();
 		w.skip_line();
 	}
+
+	if (is_module)
+	{
+		w << "}";
+		w.skip_line();
+	}
 }
 
-void export_wrapper_functions(Cpp_File_Writer &w, const std::vector<Function_Decl> &functions, 
-	const Settings &settings)
+void export_wrapper_functions(Cpp_File_Writer &w, const std::vector<Parsed_Function> &functions, 
+	const Settings &settings, Allocation_Counters &inout_allocations)
 {
 	// Write a section header to make it easier to navigate the output file.
 	w << "//////////////////////////////";
@@ -671,39 +950,124 @@ void export_wrapper_functions(Cpp_File_Writer &w, const std::vector<Function_Dec
 	w.skip_line();
 
 	// Write the wrapper functions
-	for (auto &function : functions)
+	export_in_parallel(w, functions, settings, export_wrapper, inout_allocations);
+}
+
+void export_wrapper(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings)
+{
+	// Compact wrappers don't support instrumentation, journaling, coroutines or memoization, and
+	// table wrappers don't support lists.
+	bool compact = !settings.instrument && !settings.journal && !f.is_async && !f.is_memoized;
+	bool has_lists = std::any_of(f.arguments.begin(), f.arguments.end(),
+		[](const Parsed_Argument &arg) { return is_array_type(arg.type); });
+
+	if (compact && settings.wrapper_style == Wrapper_Style::TEMPLATE)
+	{
+		export_template_wrapper(w, f, settings);
+	}
+	else if (compact && !has_lists && settings.wrapper_style == Wrapper_Style::TABLE)
+	{
+		export_table_wrapper(w, f, settings);
+	}
+	else
+	{
+		export_wrapper_function(w, f, settings);
+	}
+
+	if (has_typed_entry(f, settings))
+	{
+		export_piped_wrapper(w, f, settings);
+	}
+
+	if (has_binary_entry(f, settings))
+	{
+		export_binary_wrapper(w, f, settings);
+	}
+}
+
+void export_template_wrapper(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings)
+{
+	auto function_name = to_identifier(f.name);
+
+	// The signature is the command name and argument names, for error messages.
+	std::string signature(f.name);
+	std::string defaults;
+	for (const auto &arg : f.arguments)
 	{
-		export_wrapper_function(w, function, settings);
+		signature += " ";
+		signature += arg.name;
+		if (arg.has_default_value)
+		{
+			// Strings can't be template arguments as is.
+			defaults += arg.type == Value_Type::STRING ?
+				std::format(", Fixed_String({})", to_cpp_literal(arg.default_value)) :
+				std::format(", {}", to_cpp_literal(arg.default_value));
+		}
 	}
+
+	w.format("inline constexpr Function_Wrapper {}{} = &template_wrapper<\"{}\", &{}{}>;",
+		settings.wrapper_function_prefix, function_name, signature, f.name, defaults);
 }
 
-void export_wrapper_function(Cpp_File_Writer &w, const Function_Decl &f, const Settings &settings)
+void export_wrapper_function(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings)
 {
-	// Convert colons to underscores. Colons appear from namespaces or static functions.
-	auto function_name = std::regex_replace(f.name, std::regex(":"), "_");
+	auto function_name = to_identifier(f.name);
+
+	if (f.is_memoized)
+	{
+		export_memo_cache(w, f, settings);
+	}
 
 	// Write the function definition
-	w << std::format("// Generated based on function \"{}\" from file \"{}\" L{}",
+	w.format("// Generated based on function \"{}\" from file \"{}\" L{}",
 		f.name, f.file, f.line);
-	w << std::format("inline Call_Result {}{}(std::vector<std::string> &args, bool call_client_function)",
-		settings.wrapper_function_prefix, function_name);
+	if (f.is_async)
+	{
+		// A coroutine: it runs until the client function first suspends, then returns the task.
+		w.format("inline Call_Task {}{}_async(std::vector<std::string> args, bool call_client_function)",
+			settings.wrapper_function_prefix, function_name);
+	}
+	else
+	{
+		w.format("inline Call_Result {}{}(std::vector<std::string> &args, bool call_client_function)",
+			settings.wrapper_function_prefix, function_name);
+	}
 	w << "{";
 	w.indent();
 	w << "Call_Result call_result;";
+	if (settings.instrument)
+	{
+		// The id is registered the first time the wrapper runs. The scope object records the call
+		// when the wrapper returns, regardless of which return statement it leaves through.
+		w.format("static const size_t command_id = register_call_stats_command(\"{}\");",
+			f.name);
+		w << "Instrumented_Call instrumented_call(command_id, call_result, call_client_function);";
+	}
 	w.skip_line();
 
 	// Write the check to confirm that all needed arguments are provided
 	if (f.num_required_args > 0)
 	{
 		w << "// Check that all required arguments are provided.";
-		w << std::format("if(args.size() < {})", f.num_required_args);
-		w << "{";
-		w.indent();
-		w << std::format("call_result.error_message = std::format(\"Not enough arguments for '{}'. Needed {}, but got {{}}\", args.size());",
-			f.name, f.num_required_args);
-		w << "call_result.status = Call_Result_Status::NOT_ENOUGH_ARGUMENTS_ERROR;";
-		w << "call_result.error_helper_value = args.size();";
-		w << "return call_result;";
+		if (settings.inline_errors)
+		{
+			w.format("if(args.size() < {})", f.num_required_args);
+			w << "{";
+			w.indent();
+			w.format("call_result.error_message = std::format(\"Not enough arguments for '{}'. Needed {}, but got {{}}\", args.size());",
+				f.name, f.num_required_args);
+			w << "call_result.status = Call_Result_Status::NOT_ENOUGH_ARGUMENTS_ERROR;";
+			w << "call_result.error_helper_value = args.size();";
+		}
+		else
+		{
+			w.format("if(args.size() < {}) [[unlikely]]", f.num_required_args);
+			w << "{";
+			w.indent();
+			w.format("set_not_enough_arguments_error(call_result, \"{}\", {}, args.size());",
+				f.name, f.num_required_args);
+		}
+		w << return_statement(f);
 
 		w.unindent();
 		w << "}";
@@ -719,74 +1083,339 @@ void export_wrapper_function(Cpp_File_Writer &w, const Function_Decl &f, const S
 	}
 
 	// Write the argument handler for each argument
-	for (int i = 0; i < f.arguments.size(); i++)
+	for (size_t i = 0; i < f.arguments.size(); i++)
 	{
-		export_argument_handler(w, i, f.arguments[i]);
+		export_argument_handler(w, f, i, settings);
 	}
 
-	export_consumer_function_value_handler(w, f);
+	export_consumer_function_value_handler(w, f, settings);
 
 	w.skip_line();
 
-	w << "return call_result;";
+	w << return_statement(f);
 
 	w.unindent();
 	w << "}";
 	w.skip_line();
-}
-
-void export_argument_handler(Cpp_File_Writer &w, size_t i, const Argument &arg)
-{
-	// Create variable
-	w << std::format("// {} argument {}: '{} {}'", arg.has_default_value ? "Optional" : "Required",
-		i, value_type_to_cpp_type(arg.type), arg.name);
 
-	if (arg.has_default_value)
+	// Asynchronous commands also get a regular wrapper, so consumers that don't support them can
+	// still call them.
+	if (f.is_async)
 	{
-		w << std::format("{} arg_{} = {};", value_type_to_cpp_type(arg.type), arg.name,
-			to_string(arg.default_value));
-
-		// Check if replacement variable has been provided
-		w << std::format("if(args.size() > {})", i);
+		w.format("// Blocking wrapper for \"{}\". Prefer {}{}_async, this one waits for the command to finish.",
+			f.name, settings.wrapper_function_prefix, function_name);
+		w.format("inline Call_Result {}{}(std::vector<std::string> &args, bool call_client_function)",
+			settings.wrapper_function_prefix, function_name);
 		w << "{";
 		w.indent();
-
-		// If it's a string, then we don't need parsing.
-		if (arg.type == Value_Type::STRING)
-		{
+		w.format("return {}{}_async(args, call_client_function).wait();",
+			settings.wrapper_function_prefix, function_name);
+		w.unindent();
+		w << "}";
+		w.skip_line();
+	}
+}
+
+void export_piped_wrapper(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings)
+{
+	auto function_name = to_identifier(f.name);
+	const Parsed_Argument &piped_arg = f.arguments[0];
+
+	w.format("// Typed entry point for \"{}\", taking argument '{}' from another command's result.",
+		f.name, piped_arg.name);
+	// Unnamed when the piped argument is the only one, so it doesn't warn as unused.
+	w.format("inline Call_Result {}{}_piped(Call_Result &input, std::vector<std::string> &{}, bool call_client_function)",
+		settings.wrapper_function_prefix, function_name, f.arguments.size() > 1 ? "args" : "");
+	w << "{";
+	w.indent();
+	w << "Call_Result call_result;";
+	if (settings.instrument)
+	{
+		w.format("static const size_t command_id = register_call_stats_command(\"{}\");",
+			f.name);
+		w << "Instrumented_Call instrumented_call(command_id, call_result, call_client_function);";
+	}
+	w.skip_line();
+
+	// The piped argument counts as provided.
+	if (f.num_required_args > 1)
+	{
+		w << "// Check that all required arguments are provided.";
+		w.format("if(args.size() < {}) [[unlikely]]", f.num_required_args - 1);
+		w << "{";
+		w.indent();
+		w.format("set_not_enough_arguments_error(call_result, \"{}\", {}, args.size() + 1);",
+			f.name, f.num_required_args);
+		w << return_statement(f);
+		w.unindent();
+		w << "}";
+		w.skip_line();
+	}
+
+	w.format("// Piped argument 0: '{} {}'", value_type_to_cpp_type(piped_arg.type), piped_arg.name);
+	w.format("{} arg_{};", value_type_to_cpp_type(piped_arg.type), piped_arg.name);
+	w.format("if(!get_piped_value(input, arg_{})) [[unlikely]]", piped_arg.name);
+	w << "{";
+	w.indent();
+	w.format("set_piped_value_error(call_result, \"{}\", {}, input.value.type);", piped_arg.name,
+		to_string(piped_arg.type));
+	w << return_statement(f);
+	w.unindent();
+	w << "}";
+	w.skip_line();
+
+	if (f.arguments.size() > 1)
+	{
+		w << "// Reused success flag used for value parsing";
+		w << "int success = false;";
+		w.skip_line();
+	}
+
+	for (size_t i = 1; i < f.arguments.size(); i++)
+	{
+		export_argument_handler(w, f, i, settings, 1);
+	}
+
+	export_consumer_function_value_handler(w, f, settings);
+
+	w.skip_line();
+
+	w << return_statement(f);
+
+	w.unindent();
+	w << "}";
+	w.skip_line();
+}
+
+void export_binary_wrapper(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings)
+{
+	auto function_name = to_identifier(f.name);
+
+	w.format("// Binary entry point for \"{}\", reading the arguments from a binary buffer.", f.name);
+	w.format("inline Call_Result {}{}_binary(std::string_view arguments, bool call_client_function)",
+		settings.wrapper_function_prefix, function_name);
+	w << "{";
+	w.indent();
+	w << "Call_Result call_result;";
+	if (settings.instrument)
+	{
+		w.format("static const size_t command_id = register_call_stats_command(\"{}\");",
+			f.name);
+		w << "Instrumented_Call instrumented_call(command_id, call_result, call_client_function);";
+	}
+	w.skip_line();
+
+	for (size_t i = 0; i < f.arguments.size(); i++)
+	{
+		const Parsed_Argument &arg = f.arguments[i];
+		w.format("// {} argument {}: '{} {}'", arg.has_default_value ? "Optional" : "Required",
+			i, value_type_to_cpp_type(arg.type), arg.name);
+
+		// Values are read straight into the arguments, nothing is parsed.
+		if (arg.has_default_value)
+		{
+			w.format("{} arg_{} = {};", value_type_to_cpp_type(arg.type), arg.name,
+				to_cpp_literal(arg.default_value));
+			w.format("if(!arguments.empty() && !read_binary_argument(arguments, arg_{})) [[unlikely]]",
+				arg.name);
+		}
+		else
+		{
+			w.format("{} arg_{};", value_type_to_cpp_type(arg.type), arg.name);
+			w << "if(arguments.empty()) [[unlikely]]";
+			w << "{";
+			w.indent();
+			w.format("set_not_enough_arguments_error(call_result, \"{}\", {}, {});", f.name,
+				f.num_required_args, i);
+			w << return_statement(f);
+			w.unindent();
+			w << "}";
+			w.format("if(!read_binary_argument(arguments, arg_{})) [[unlikely]]", arg.name);
+		}
+		w << "{";
+		w.indent();
+		w.format("set_binary_argument_error(call_result, {}, \"{}\", {}, arguments);", i, arg.name,
+			to_string(arg.type));
+		w << return_statement(f);
+		w.unindent();
+		w << "}";
+		w.skip_line();
+	}
+
+	// Leftover bytes mean the caller encoded something else than this command takes.
+	w << "if(!arguments.empty()) [[unlikely]]";
+	w << "{";
+	w.indent();
+	w.format("set_extra_binary_arguments_error(call_result, \"{}\", {}, arguments);", f.name,
+		f.arguments.size());
+	w << return_statement(f);
+	w.unindent();
+	w << "}";
+	w.skip_line();
+
+	export_consumer_function_value_handler(w, f, settings);
+
+	w.skip_line();
+
+	w << return_statement(f);
+
+	w.unindent();
+	w << "}";
+	w.skip_line();
+}
+
+void export_table_wrapper(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings)
+{
+	auto function_name = to_identifier(f.name);
+	auto wrapper_name = settings.wrapper_function_prefix + function_name;
+
+	w.format("// Generated based on function \"{}\" from file \"{}\" L{}",
+		f.name, f.file, f.line);
+
+	// The descriptor tables
+	std::string arguments_table = "nullptr";
+	if (!f.arguments.empty())
+	{
+		arguments_table = wrapper_name + "_arguments";
+		w.format("inline constexpr Argument_Descriptor {}[] = {{", arguments_table);
+		w.indent();
+		for (const auto &arg : f.arguments)
+		{
+			if (arg.has_default_value)
+			{
+				w.format("{{ \"{}\", {}, {} }},", arg.name, to_string(arg.type),
+					to_cpp_literal(arg.default_value));
+			}
+			else
+			{
+				w.format("{{ \"{}\", {} }},", arg.name, to_string(arg.type));
+			}
+		}
+		w.unindent();
+		w << "};";
+	}
+	w.format("inline constexpr Command_Descriptor {}_command = {{ \"{}\", {}, {}, {}, {} }};",
+		wrapper_name, f.name, arguments_table, f.arguments.size(), f.num_required_args,
+		to_string(f.return_type));
+
+	// The thunk, which only converts the parsed values and calls the client function.
+	w.format("inline Call_Result {}(std::vector<std::string> &args, bool call_client_function)",
+		wrapper_name);
+	w << "{";
+	w.indent();
+	w << "Call_Result call_result;";
+	w.format("Argument_Value values[{}];", std::max<size_t>(f.arguments.size(), 1));
+	w.format("if (!parse_table_arguments({}_command, args, values, call_result) || !call_client_function)",
+		wrapper_name);
+	w.indent();
+	w << "return call_result;";
+	w.unindent();
+
+	std::string call = std::format("{}(", f.name);
+	for (size_t i = 0; i < f.arguments.size(); i++)
+	{
+		const Parsed_Argument &arg = f.arguments[i];
+		if (arg.type == Value_Type::STRING)
+		{
+			call += std::format("std::string(values[{}].string_value)", i);
+		}
+		else
+		{
+			call += std::format("values[{}].{}_value", i, value_type_to_readable_string(arg.type));
+		}
+		call += i + 1 < f.arguments.size() ? ", " : "";
+	}
+	call += ")";
+
+	if (f.return_type == Value_Type::VOID)
+	{
+		w.format("{};", call);
+	}
+	else if (f.return_type == Value_Type::STRING)
+	{
+		w.format("call_result.string_value = {};", call);
+		w << "set_string_value(call_result.value, call_result.string_value);";
+	}
+	else
+	{
+		w.format("call_result.value.data.{}_value = {};",
+			value_type_to_readable_string(f.return_type), call);
+	}
+	w << "return call_result;";
+	w.unindent();
+	w << "}";
+	w.skip_line();
+}
+
+void export_argument_handler(Cpp_File_Writer &w, const Parsed_Function &f, size_t i,
+	const Settings &settings, size_t num_piped_args)
+{
+	const Parsed_Argument &arg = f.arguments[i];
+
+	// Piped arguments aren't in args, so the others move up.
+	size_t arg_index = i - num_piped_args;
+
+	// Create variable
+	w.format("// {} argument {}: '{} {}'", arg.has_default_value ? "Optional" : "Required",
+		i, value_type_to_cpp_type(arg.type), arg.name);
+
+	if (arg.has_default_value)
+	{
+		w.format("{} arg_{} = {};", value_type_to_cpp_type(arg.type), arg.name,
+			to_cpp_literal(arg.default_value));
+
+		// Check if replacement variable has been provided
+		w.format("if(args.size() > {})", arg_index);
+		w << "{";
+		w.indent();
+
+		// If it's a string, then we don't need parsing.
+		if (arg.type == Value_Type::STRING)
+		{
 			w << "success = true;";
-			w << std::format("arg_{} = args[{}];", arg.name, i);
+			w.format("arg_{} = args[{}];", arg.name, arg_index);
 		}
 		else
 		{
-			w << std::format("success = get_{}(args[{}], arg_{});",
-				value_type_to_readable_string(arg.type), i, arg.name);
+			w.format("success = get_{}(args[{}], arg_{});",
+				value_type_to_readable_string(arg.type), arg_index, arg.name);
 		}
 	}
 	else
 	{
-		w << std::format("{} arg_{};", value_type_to_cpp_type(arg.type), arg.name);
+		w.format("{} arg_{};", value_type_to_cpp_type(arg.type), arg.name);
 		if (arg.type == Value_Type::STRING)
 		{
 			w << "success = true;";
-			w << std::format("arg_{} = args[{}];", arg.name, i);
+			w.format("arg_{} = args[{}];", arg.name, arg_index);
 		}
 		else
 		{
-			w << std::format("success = get_{}(args[{}], arg_{});", 
-				value_type_to_readable_string(arg.type), i, arg.name);
+			w.format("success = get_{}(args[{}], arg_{});", 
+				value_type_to_readable_string(arg.type), arg_index, arg.name);
 		}
 	}
 
-	w << "if(!success)";
-	w << "{";
-	w.indent();
-
-	w << std::format("call_result.error_message = std::format(\"Failed to parse argument {0} '{1}'. Attempted to parse a {2}, but "
-		"got string '{{}}'\", args[{0}]);", i, arg.name, value_type_to_cpp_type(arg.type));
-	w << "call_result.status = Call_Result_Status::ARGUMENT_PARSING_ERROR;";
-	w << std::format("call_result.error_helper_value = {};", i);
-	w << "return call_result;";
+	if (settings.inline_errors)
+	{
+		w << "if(!success)";
+		w << "{";
+		w.indent();
+		w.format("call_result.error_message = std::format(\"Failed to parse argument {0} '{1}'. Attempted to parse a {2}, but "
+			"got string '{{}}'\", args[{3}]);", i, arg.name, value_type_to_cpp_type(arg.type), arg_index);
+		w << "call_result.status = Call_Result_Status::ARGUMENT_PARSING_ERROR;";
+		w.format("call_result.error_helper_value = {};", i);
+	}
+	else
+	{
+		// The error is formatted out of line, keeping the wrapper's hot path short.
+		w << "if(!success) [[unlikely]]";
+		w << "{";
+		w.indent();
+		w.format("set_argument_parsing_error(call_result, {}, \"{}\", {}, args[{}]);", i, arg.name,
+			to_string(arg.type), arg_index);
+	}
+	w << return_statement(f);
 
 	w.unindent();
 	w << "}";
@@ -800,34 +1429,102 @@ void export_argument_handler(Cpp_File_Writer &w, size_t i, const Argument &arg)
 }
 
 
-void export_consumer_function_value_handler(Cpp_File_Writer &w, const Function_Decl &f)
+void export_consumer_function_value_handler(Cpp_File_Writer &w, const Parsed_Function &f,
+	const Settings &settings)
 {
-	w << std::format("call_result.value.type = {};", to_string(f.return_type));
+	w.format("call_result.value.type = {};", to_string(f.return_type));
 	w << "call_result.status = Call_Result_Status::SUCCESS;";
 	w << "if(!call_client_function)";
 	w.indent();
-	w << "return call_result;";
+	w << return_statement(f);
 	w.unindent();
+
+	if (settings.instrument)
+	{
+		w << "instrumented_call.mark_arguments_parsed();";
+	}
+
+	if (settings.journal)
+	{
+		// Recorded before the memo lookup, so cached calls are replayed too.
+		std::string journal_args;
+		for (const auto &arg : f.arguments)
+		{
+			journal_args += ", arg_";
+			journal_args += arg.name;
+		}
+		w.format("static const uint32_t journal_id = register_journal_command(\"{}\");", f.name);
+		w.format("record_journal_call(journal_id{});", journal_args);
+	}
+
+	if (f.is_memoized)
+	{
+		export_memo_lookup(w, f, settings);
+	}
 	
 	if (f.return_type == Value_Type::VOID)
 	{
-		w << std::format("{};", function_call_string(f));
+		w.format("{};", function_call_string(f));
 	}
 	else if (f.return_type == Value_Type::STRING)
 	{
-		w << std::format("std::string result = {};", function_call_string(f));
-		w << "strncpy(call_result.value.data.string_value, result.data(), "
-			"sizeof(call_result.value.data.string_value));";
+		// The result is moved into the call result rather than copied, so large results are
+		// cheap. The fixed size value only gets a truncated copy.
+		w.format("call_result.string_value = {};", function_call_string(f));
+		w << "set_string_value(call_result.value, call_result.string_value);";
 	}
 	else
 	{
-		w << std::format("call_result.value.data.{}_value = {};", 
+		w.format("call_result.value.data.{}_value = {};", 
 			value_type_to_readable_string(f.return_type), function_call_string(f));
 	}
+
+	if (f.is_memoized)
+	{
+		w << "memo_cache.insert(std::move(memo_key), call_result);";
+	}
+}
+
+void export_memo_cache(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings)
+{
+	auto key_type = memo_key_type(f);
+	w.format("// Cached results of \"{}\", shared by its wrappers.", f.name);
+	w.format("inline Memo_Cache<{}> &{}{}_memo_cache()", key_type, settings.wrapper_function_prefix,
+		to_identifier(f.name));
+	w << "{";
+	w.indent();
+	w.format("static Memo_Cache<{}> cache(\"{}\", {});", key_type, f.name, settings.memoize_capacity);
+	w << "return cache;";
+	w.unindent();
+	w << "}";
+	w.skip_line();
+}
+
+void export_memo_lookup(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings)
+{
+	// The key copies the parsed arguments, since lists are moved into the client function.
+	std::string key_values = "{";
+	for (size_t i = 0; i < f.arguments.size(); i++)
+	{
+		key_values += " arg_";
+		key_values += f.arguments[i].name;
+		key_values += i + 1 < f.arguments.size() ? "," : " ";
+	}
+	key_values += "}";
+
+	w << "// Memoized: calls with the same arguments return the cached result.";
+	w.format("auto &memo_cache = {}{}_memo_cache();", settings.wrapper_function_prefix,
+		to_identifier(f.name));
+	w.format("{} memo_key{};", memo_key_type(f), key_values);
+	w << "if(memo_cache.find(memo_key, call_result))";
+	w.indent();
+	w << return_statement(f);
+	w.unindent();
 }
 
 void export_initialization_function(Cpp_File_Writer &w, 
-	const std::vector<Function_Decl> &functions, const Settings &settings)
+	const std::vector<Parsed_Function> &functions, const Settings &settings,
+	Allocation_Counters &inout_allocations)
 {
 	// Write the initialization function
 	w << "//////////////////////////////";
@@ -835,70 +1532,300 @@ void export_initialization_function(Cpp_File_Writer &w,
 	w << "//////////////////////////////";
 	w.skip_line();
 
-	w << std::format("void {}(Function_Map &out_functions)", settings.init_function_name);
+	// Runs once at startup, and is by far the largest function for big registries.
+	w.format("{}FUNCTION_FINDER_COLD void {}(Function_Map &out_functions)",
+		settings.module_name.empty() ? "" : "export ", settings.init_function_name);
 	w << "{";
 	w.indent();
 
+	export_in_parallel(w, functions, settings, export_initialization_entry, inout_allocations);
+
+	w.unindent();
+	w << "}";
+	w.skip_line();
+}
+
+void export_registration_function(Cpp_File_Writer &w, const Settings &settings)
+{
+	w << "//////////////////////////////";
+	w << "//       REGISTRATION       //";
+	w << "//////////////////////////////";
+	w.skip_line();
+
+	// Looked up by name with dlsym or GetProcAddress, so it can't be mangled. Refuses hosts built
+	// against a different layout of the registry types, which would crash instead.
+	w << "// Entry point for loading the commands from a shared library, see \"function_finder/hot_reload.hpp\".";
+	w << "extern \"C\" FUNCTION_FINDER_EXPORT bool function_finder_register_commands(Function_Map &out_functions, uint64_t registry_abi)";
+	w << "{";
+	w.indent();
+	w << "if (registry_abi != command_registry_abi())";
+	w << "{";
+	w.indent();
+	w << "return false;";
+	w.unindent();
+	w << "}";
+	w.format("{}(out_functions);", settings.init_function_name);
+	w << "return true;";
+	w.unindent();
+	w << "}";
+	w.skip_line();
+}
+
+void export_command_ids(Cpp_File_Writer &w, const std::vector<Parsed_Function> &functions,
+	const Settings &settings)
+{
+	// Write a section header to make it easier to navigate the output file.
+	w << "//////////////////////////////";
+	w << "//       COMMAND IDS        //";
+	w << "//////////////////////////////";
+	w.skip_line();
+
+	const std::string &id_type = settings.command_id_type;
+	w << "// Ids of all commands, to call them with call_command rather than by name.";
+	w.format("{}enum class {} : uint32_t", settings.module_name.empty() ? "" : "export ", id_type);
+	w << "{";
+	w.indent();
 	for (const auto &f : functions)
 	{
-		// Convert colons to underscores. Colons appear from namespaces or static functions.
-		auto function_name = std::regex_replace(f.name, std::regex(":"), "_");
+		w.format("{},", to_identifier(f.name));
+	}
+	w.unindent();
+	w << "};";
+	w.skip_line();
 
-		w << std::format("out_functions[\"{0}\"] = "
-			"Function_Decl(\"{0}\", {4}{5}, {1}, {2}, {3},",
-			f.name, to_string(f.return_type), f.num_required_args, f.num_optional_args, 
-			settings.wrapper_function_prefix, function_name);
-		w.indent();
-		w << std::format("\"{}\", (size_t){},", f.file, f.line);
-		w << "// Arguments";
-		w << "{";
-		w.indent();
-		for (size_t i = 0; i < f.arguments.size(); i++)
-		{
-			const auto &arg = f.arguments[i];
-			bool last_iter = i == f.arguments.size() - 1;
+	w << "template <>";
+	w.format("struct Command_Table<{}>", id_type);
+	w << "{";
+	w.indent();
+	w.format("static constexpr size_t count = {};", functions.size());
+	w << "static constexpr std::array<Command_Info, count> commands = {{";
+	w.indent();
+	for (const auto &f : functions)
+	{
+		auto function_name = to_identifier(f.name);
+		std::string async_function = f.is_async ?
+			std::format("{}{}_async", settings.wrapper_function_prefix, function_name) : "nullptr";
+		w.format("{{ \"{}\", {}{}, {}, {}, {}, {} }},", f.name, settings.wrapper_function_prefix,
+			function_name, async_function, to_string(f.return_type), f.num_required_args,
+			f.num_optional_args);
+	}
+	w.unindent();
+	w << "}};";
 
-			if (arg.has_default_value)
-			{
-				w << std::format("Argument(\"{}\", {}, \"{}\", {}){}",
-					arg.name, to_string(arg.type), arg.note, to_string(arg.default_value), 
-					last_iter ? "" : ",");
-			}
-			else
-			{
-				w << std::format("Argument(\"{}\", {}, \"{}\"){}",
-					arg.name, to_string(arg.type), arg.note, last_iter ? "" : ",");
-			}
-		}
-		w.unindent();
-		w << "},";
-		w << std::format("\"{}\"", f.note);
-		w.unindent();
-		w << ");";
-		w.skip_line();
+	// For find_command_id's binary search.
+	std::vector<const Parsed_Function *> sorted_functions;
+	for (const auto &f : functions)
+	{
+		sorted_functions.push_back(&f);
 	}
+	std::sort(sorted_functions.begin(), sorted_functions.end(),
+		[](const Parsed_Function *a, const Parsed_Function *b) { return a->name < b->name; });
 
+	w.format("static constexpr std::array<{}, count> sorted_ids = {{{{", id_type);
+	w.indent();
+	for (const Parsed_Function *f : sorted_functions)
+	{
+		w.format("{}::{},", id_type, to_identifier(f->name));
+	}
 	w.unindent();
-	w << "}";
+	w << "}};";
+	w.unindent();
+	w << "};";
 	w.skip_line();
 }
 
-std::string function_call_string(const Function_Decl &func)
+void export_initialization_entry(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings)
 {
-	std::stringstream ss;
-	ss << func.name << "(";
-	for (int i = 0; i < func.arguments.size(); i++)
+	auto function_name = to_identifier(f.name);
+
+	w.format("out_functions[\"{0}\"] = "
+		"Function_Decl(\"{0}\", {4}{5}, {1}, {2}, {3},",
+		f.name, to_string(f.return_type), f.num_required_args, f.num_optional_args, 
+		settings.wrapper_function_prefix, function_name);
+	w.indent();
+	w.format("\"{}\", (size_t){},", f.file, f.line);
+	w << "// Arguments";
+	w << "{";
+	w.indent();
+	for (size_t i = 0; i < f.arguments.size(); i++)
 	{
-		const Argument &arg = func.arguments[i];
-		ss << "arg_" << arg.name;
+		const auto &arg = f.arguments[i];
+		bool last_iter = i == f.arguments.size() - 1;
+
+		if (arg.has_default_value)
+		{
+			w.format("Argument(\"{}\", {}, \"{}\", {}){}",
+				arg.name, to_string(arg.type), arg.note, to_cpp_literal(arg.default_value), 
+				last_iter ? "" : ",");
+		}
+		else
+		{
+			w.format("Argument(\"{}\", {}, \"{}\"){}",
+				arg.name, to_string(arg.type), arg.note, last_iter ? "" : ",");
+		}
+	}
+	w.unindent();
+	w << "},";
+	w.format("\"{}\"", f.note);
+	w.unindent();
+	w << ");";
+	if (f.is_async)
+	{
+		w.format("out_functions[\"{}\"].async_function = {}{}_async;", f.name,
+			settings.wrapper_function_prefix, function_name);
+	}
+	if (has_typed_entry(f, settings))
+	{
+		w.format("out_functions[\"{}\"].piped_function = {}{}_piped;", f.name,
+			settings.wrapper_function_prefix, function_name);
+	}
+	if (has_binary_entry(f, settings))
+	{
+		w.format("out_functions[\"{}\"].binary_function = {}{}_binary;", f.name,
+			settings.wrapper_function_prefix, function_name);
+	}
+	w.skip_line();
+}
+
+std::string function_call_string(const Parsed_Function &func)
+{
+	std::string call;
+	if (func.is_async)
+	{
+		call += "co_await ";
+	}
+	call += func.name;
+	call += '(';
+	for (size_t i = 0; i < func.arguments.size(); i++)
+	{
+		const Parsed_Argument &arg = func.arguments[i];
+
+		// Lists are parsed into a std::vector, which can be moved into a std::vector argument.
+		// A std::span argument just views it.
+		if (is_array_type(arg.type) && arg.cpp_type.starts_with("std::vector"))
+		{
+			std::format_to(std::back_inserter(call), "std::move(arg_{})", arg.name);
+		}
+		else
+		{
+			std::format_to(std::back_inserter(call), "arg_{}", arg.name);
+		}
 
 		if (i < func.arguments.size() - 1)
 		{
-			ss << ", ";
+			call += ", ";
 		}
 	}
-	ss << ")";
-	return ss.str();
+	call += ')';
+	return call;
+}
+
+std::string to_identifier(std::string_view name)
+{
+	// Colons appear from namespaces or static functions.
+	std::string identifier(name);
+	std::replace(identifier.begin(), identifier.end(), ':', '_');
+	return identifier;
+}
+
+std::string to_cpp_literal(const Value &value)
+{
+	if (value.type != Value_Type::FLOAT && value.type != Value_Type::DOUBLE)
+	{
+		return to_string(value);
+	}
+
+	std::string literal = value.type == Value_Type::FLOAT ?
+		std::format("{}", value.data.float_value) : std::format("{}", value.data.double_value);
+	if (literal.find_first_of(".e") == std::string::npos)
+	{
+		literal += ".0";
+	}
+	if (value.type == Value_Type::FLOAT)
+	{
+		literal += 'f';
+	}
+	return literal;
+}
+
+size_t get_export_jobs(const Settings &settings, size_t num_functions)
+{
+	size_t jobs = settings.jobs ? settings.jobs : std::max(1u, std::thread::hardware_concurrency());
+
+	// Starting a thread costs about as much as rendering a few dozen wrappers.
+	return std::clamp<size_t>(num_functions / EXPORT_FUNCTIONS_PER_JOB, 1, jobs);
+}
+
+void export_in_parallel(Cpp_File_Writer &w, const std::vector<Parsed_Function> &functions,
+	const Settings &settings, Function_Exporter export_function, Allocation_Counters &inout_allocations)
+{
+	size_t jobs = get_export_jobs(settings, functions.size());
+	std::vector<std::string> blocks(functions.size());
+	std::vector<Allocation_Counters> worker_allocations(jobs);
+	std::atomic<size_t> next_function = 0;
+
+	auto render = [&]()
+		{
+			for (size_t i = next_function++; i < functions.size(); i = next_function++)
+			{
+				Cpp_File_Writer block_writer(blocks[i], w.get_indent());
+				export_function(block_writer, functions[i], settings);
+			}
+		};
+
+	{
+		// The calling thread renders too. Its allocations are already counted by the caller.
+		std::vector<std::jthread> workers;
+		for (size_t i = 1; i < jobs; i++)
+		{
+			workers.emplace_back([&, i]()
+				{
+					Scoped_Allocation_Counter allocations(worker_allocations[i]);
+					render();
+				});
+		}
+		render();
+	}
+
+	for (const auto &allocations : worker_allocations)
+	{
+		inout_allocations += allocations;
+	}
+	for (const auto &block : blocks)
+	{
+		w.append(block);
+	}
+}
+
+std::string memo_key_type(const Parsed_Function &f)
+{
+	std::string key_type = "std::tuple<";
+	for (size_t i = 0; i < f.arguments.size(); i++)
+	{
+		key_type += value_type_to_cpp_type(f.arguments[i].type);
+		key_type += i + 1 < f.arguments.size() ? ", " : "";
+	}
+	key_type += ">";
+	return key_type;
+}
+
+bool has_typed_entry(const Parsed_Function &f, const Settings &settings)
+{
+	// Coroutines can't be called without awaiting them, and results are never lists.
+	return settings.typed_entries && !f.is_async && !f.arguments.empty() &&
+		!is_array_type(f.arguments[0].type);
+}
+
+bool has_binary_entry(const Parsed_Function &f, const Settings &settings)
+{
+	// Coroutines can't be called without awaiting them, same as for typed entries.
+	return settings.binary_entries && !f.is_async;
+}
+
+std::string_view return_statement(const Parsed_Function &func)
+{
+	// co_return doesn't get copy elision, so the result is moved.
+	return func.is_async ? "co_return std::move(call_result);" : "return call_result;";
 }
 
 
@@ -915,7 +1842,7 @@ It scans your file/directory for function prefixed by your search-term and outpu
 See the "docs" folder for more details on exact function.
 
 Usage:
-    'function_finder.exe <input_path> <output_path> <search_term> <init_function_name> <wrapper_function_prefix>'
+    'function_finder.exe <input_path> <output_path> <search_term> <init_function_name> <wrapper_function_prefix> [options]'
         Run the tool.
 
         input_path:
@@ -932,6 +1859,73 @@ Usage:
         wrapper_function_prefix:
             What prefix to add to the auto-generated wrapper functions.
 
+    Options:
+        --instrument
+            Make the wrappers record per-command call counts, parse failures, and latency histograms. Include
+            "function_finder/instrumentation.hpp" and call 'collect_call_stats()' to read them. The most recent
+            calls of every thread are also kept as a timeline that 'write_chrome_trace()' dumps as a Chrome/Perfetto
+            trace. Without this option the wrappers contain no instrumentation code at all.
+        --stats, --stats=text, --stats=json
+            Print how long each phase of the run took (directory walk, read, scan, parse, export, write), how many
+            files and bytes were scanned, the scanning throughput, the number of functions found, and the slowest files.
+        --stats-top=<N>
+            How many of the slowest files to list in the stats report. Defaults to 10.
+        --stats-file=<path>
+            Write the stats report to a file rather than stdout. Useful with '--stats=json'.
+        --command-ids=<name>
+            Also generate 'enum class <name>' with an id per command, and a 'Command_Table<name>' listing the
+            commands in id order. 'call_command(<name>::add, args)' then calls a command with an array access
+            instead of a map lookup, and misspelled names fail to compile. Resolve names read at runtime once
+            with 'find_command_id'.
+        --memoize-tag=<tag>
+            Cache the results of commands that also have <tag>, like 'CONSOLE_COMMAND MEMOIZED int f(int x)'.
+            Calling such a command again with the same arguments returns the cached result without calling the
+            client function, so only tag functions whose result depends on nothing but their arguments. See
+            "function_finder/memoization.hpp" for the hit and miss counters and 'invalidate_memoized_results()'.
+            Memoized commands always get full wrappers.
+        --memoize-capacity=<N>
+            How many results each memoized command keeps, dropping the least recently used. Defaults to 128.
+        --typed-entries
+            Also generate a typed entry point per command, stored in 'Function_Decl::piped_function', which takes
+            the first argument from another command's 'Call_Result' as is and parses the others from text. Lets
+            "function_finder/pipeline.hpp" run pipelines like 'add 1 2 | multiply' without converting results to
+            text and parsing them again. Asynchronous commands and commands taking a list first don't get one.
+        --journal
+            Make the wrappers record every call, with its parsed argument values, while a journal started with
+            'start_command_journal(<path>)' is open. 'replay_command_journal(<path>, commands, stats)' runs a
+            journal's calls again as fast as possible and reports the throughput. See
+            "function_finder/command_journal.hpp". Journaled commands always get full wrappers.
+        --binary-entries
+            Also generate a binary entry point per command, stored in 'Function_Decl::binary_function', which reads
+            the arguments from a compact binary buffer straight into the client function's parameters. Lets RPC
+            callers that already have typed values skip formatting and parsing text. See
+            "function_finder/binary_arguments.hpp" for the format. Asynchronous commands don't get one.
+        --shared-library
+            Also generate an exported 'function_finder_register_commands' function, which calls the initialization
+            function. Build the output into a shared library, and 'Command_Library' from
+            "function_finder/hot_reload.hpp" loads it at runtime and reloads it whenever it's rebuilt, without
+            restarting the host program.
+        --jobs=<N>
+            Number of threads rendering the wrappers. Defaults to the number of hardware threads. The output is
+            the same for any number of threads.
+        --quiet
+            Don't print the list of scanned files.
+        --wrappers=full, --wrappers=template, --wrappers=table
+            How to generate the wrappers. 'full', the default, writes out a parser per command. 'template' writes
+            one line per command instantiating 'template_wrapper' from "function_finder/template_wrappers.hpp",
+            which makes the output much smaller and shares parsing code between commands with the same argument
+            types. 'table' writes a constant argument table and a small wrapper per command, and all commands
+            share one argument parser, 'parse_table_arguments'. Instrumented, journaled and asynchronous commands
+            always get full wrappers, and so do commands taking lists in 'table' mode.
+        --inline-errors
+            Format error messages inside each full wrapper, instead of calling the shared out-of-line error
+            helpers in "function_finder/function_finder.hpp". Makes the wrappers bigger, only useful to compare.
+        --task-type=<name>
+            Accept coroutines returning '<name><T>' as commands, like 'Task<int>' for '--task-type=Task'. Their
+            wrappers don't wait for the coroutine to finish, they return a 'Call_Task' which completes with the
+            call result, and are stored in 'Function_Decl::async_function'. Use '--task-type=Command_Task' for the
+            task type in "function_finder/command_task.hpp", or the name of your own awaitable task type.
+
     'function_finder.exe --help'
         This help message on how to use Function Finder
 
@@ -941,6 +1935,26 @@ Usage:
     'function_finder.exe --example'
         Get a full example use case of this tool
 
+    'function_finder.exe --experimental'
+        List the options that are still experimental.
+
+)";
+}
+
+void print_experimental()
+{
+	std::cout << R"(
+These options work like the others, but no compiler has built their output yet, so expect it to need fixes.
+
+        --module=<name>
+            Write the registry as a C++20 module interface unit named <name>, rather than a header. Consumers
+            'import <name>;', which also imports the runtime module 'function_finder' built from
+            "function_finder/function_finder.cppm", instead of parsing the generated code and the runtime headers
+            in every translation unit. Give the output file a module interface extension, like '.cppm' or '.ixx'.
+        --module-include=<header>
+            Include a client header in the module generated with '--module'. Needed for commands in namespaces
+            or classes, and for custom task types, which the module can't declare itself. The included headers
+            then have to declare all commands, the module doesn't declare any itself. Can be given multiple times.
 )";
 }
 
@@ -1043,10 +2057,287 @@ bool some_command(int i, float f, double d, std::string s = "default_values_are_
 )";
 }
 
+bool print_stats(const Settings &settings, const Run_Stats &stats)
+{
+	auto to_milliseconds = [](std::chrono::nanoseconds duration)
+		{ return std::chrono::duration<double, std::milli>(duration).count(); };
+
+	auto import_time = stats.directory_walk + stats.read + stats.scan + stats.parse;
+	auto total_time = import_time + stats.export_code + stats.write;
+	double import_seconds = std::chrono::duration<double>(import_time).count();
+	double bytes_per_second = import_seconds > 0 ? (double)stats.bytes_scanned / import_seconds : 0;
+
+	// Slowest files first.
+	std::vector<File_Stats> slowest = stats.files;
+	std::sort(slowest.begin(), slowest.end(), [](const File_Stats &a, const File_Stats &b)
+		{ return a.duration > b.duration; });
+	slowest.resize(std::min(slowest.size(), settings.stats_slowest_files));
+
+	const std::pair<const char *, std::chrono::nanoseconds> phases[] = {
+		{ "directory_walk", stats.directory_walk },
+		{ "read", stats.read },
+		{ "scan", stats.scan },
+		{ "parse", stats.parse },
+		{ "export", stats.export_code },
+		{ "write", stats.write },
+	};
+
+	std::stringstream report;
+	if (settings.stats_format == Stats_Format::JSON)
+	{
+		report << "{\n  \"phases_ms\": {";
+		for (size_t i = 0; i < std::size(phases); i++)
+		{
+			report << std::format("{}\"{}\": {:.3f}", i ? ", " : "", phases[i].first,
+				to_milliseconds(phases[i].second));
+		}
+		report << "},\n";
+		report << std::format("  \"total_ms\": {:.3f},\n", to_milliseconds(total_time));
+		report << std::format("  \"files_scanned\": {},\n", stats.files_scanned);
+		report << std::format("  \"bytes_scanned\": {},\n", stats.bytes_scanned);
+		report << std::format("  \"bytes_per_second\": {:.0f},\n", bytes_per_second);
+		report << std::format("  \"functions_found\": {},\n", stats.functions_found);
+		if (ALLOCATION_TRACKING_ENABLED)
+		{
+			report << std::format("  \"allocations\": {{\"import\": {{\"count\": {}, \"bytes\": {}}}, "
+				"\"export\": {{\"count\": {}, \"bytes\": {}}}}},\n", stats.import_allocations.allocations,
+				stats.import_allocations.bytes, stats.export_allocations.allocations,
+				stats.export_allocations.bytes);
+		}
+		report << "  \"slowest_files\": [";
+		for (size_t i = 0; i < slowest.size(); i++)
+		{
+			report << std::format("{}\n    {{\"path\": \"{}\", \"bytes\": {}, \"functions\": {}, "
+				"\"ms\": {:.3f}}}", i ? "," : "", escape_json_string(slowest[i].path.generic_string()),
+				slowest[i].bytes, slowest[i].functions, to_milliseconds(slowest[i].duration));
+		}
+		report << (slowest.empty() ? "]\n" : "\n  ]\n");
+		report << "}\n";
+	}
+	else
+	{
+		report << "Function Finder stats:\n";
+		for (const auto &[name, duration] : phases)
+		{
+			report << std::format("  {:<16}{:>10.3f} ms\n", name, to_milliseconds(duration));
+		}
+		report << std::format("  {:<16}{:>10.3f} ms\n", "total", to_milliseconds(total_time));
+		report << std::format("  Files scanned:   {}\n", stats.files_scanned);
+		report << std::format("  Bytes scanned:   {} ({:.2f} MB/s)\n", stats.bytes_scanned,
+			bytes_per_second / (1024.0 * 1024.0));
+		report << std::format("  Functions found: {}\n", stats.functions_found);
+		if (ALLOCATION_TRACKING_ENABLED)
+		{
+			report << std::format("  Allocations:     import {} ({} B), export {} ({} B)\n",
+				stats.import_allocations.allocations, stats.import_allocations.bytes,
+				stats.export_allocations.allocations, stats.export_allocations.bytes);
+		}
+		if (!slowest.empty())
+		{
+			report << "  Slowest files:\n";
+			for (const auto &file : slowest)
+			{
+				report << std::format("  {:>10.3f} ms {:>10} B {:>5} functions  {}\n",
+					to_milliseconds(file.duration), file.bytes, file.functions,
+					file.path.generic_string());
+			}
+		}
+	}
+
+	if (settings.stats_file.empty())
+	{
+		std::cout << report.rdbuf();
+		return true;
+	}
+
+	std::ofstream file(settings.stats_file);
+	if (!file.is_open())
+	{
+		std::cerr << std::format("[ERROR] Could not create stats file '{}'\n",
+			settings.stats_file.generic_string());
+		return false;
+	}
+	file << report.rdbuf();
+	return true;
+}
+
 /**************************************
  *             Utilities              *
  **************************************/
 
+bool parse_option(std::string_view option, Settings &inout_settings)
+{
+	if (option == "--instrument")
+	{
+		inout_settings.instrument = true;
+		return true;
+	}
+
+	if (option == "--inline-errors")
+	{
+		inout_settings.inline_errors = true;
+		return true;
+	}
+
+	if (option == "--quiet")
+	{
+		inout_settings.quiet = true;
+		return true;
+	}
+
+	if (option == "--stats" || option == "--stats=text")
+	{
+		inout_settings.stats_format = Stats_Format::TEXT;
+		return true;
+	}
+
+	if (option == "--stats=json")
+	{
+		inout_settings.stats_format = Stats_Format::JSON;
+		return true;
+	}
+
+	if (option.starts_with("--command-ids="))
+	{
+		inout_settings.command_id_type = option.substr(sizeof("--command-ids=") - 1);
+		return !inout_settings.command_id_type.empty();
+	}
+
+	if (option == "--typed-entries")
+	{
+		inout_settings.typed_entries = true;
+		return true;
+	}
+
+	if (option == "--journal")
+	{
+		inout_settings.journal = true;
+		return true;
+	}
+
+	if (option == "--binary-entries")
+	{
+		inout_settings.binary_entries = true;
+		return true;
+	}
+
+	if (option == "--shared-library")
+	{
+		inout_settings.shared_library = true;
+		return true;
+	}
+
+	if (option.starts_with("--memoize-tag="))
+	{
+		inout_settings.memoize_tag = option.substr(sizeof("--memoize-tag=") - 1);
+		return !inout_settings.memoize_tag.empty();
+	}
+
+	if (option.starts_with("--memoize-capacity="))
+	{
+		int count = 0;
+		if (!get_int(option.substr(sizeof("--memoize-capacity=") - 1), count) || count < 1)
+		{
+			return false;
+		}
+		inout_settings.memoize_capacity = (size_t)count;
+		return true;
+	}
+
+	if (option.starts_with("--jobs="))
+	{
+		int count = 0;
+		if (!get_int(option.substr(sizeof("--jobs=") - 1), count) || count < 1)
+		{
+			return false;
+		}
+		inout_settings.jobs = (size_t)count;
+		return true;
+	}
+
+	if (option.starts_with("--stats-top="))
+	{
+		int count = 0;
+		if (!get_int(option.substr(sizeof("--stats-top=") - 1), count) || count < 0)
+		{
+			return false;
+		}
+		inout_settings.stats_slowest_files = (size_t)count;
+		return true;
+	}
+
+	if (option == "--wrappers=full")
+	{
+		inout_settings.wrapper_style = Wrapper_Style::FULL;
+		return true;
+	}
+
+	if (option == "--wrappers=template")
+	{
+		inout_settings.wrapper_style = Wrapper_Style::TEMPLATE;
+		return true;
+	}
+
+	if (option == "--wrappers=table")
+	{
+		inout_settings.wrapper_style = Wrapper_Style::TABLE;
+		return true;
+	}
+
+	if (option.starts_with("--module="))
+	{
+		inout_settings.module_name = option.substr(sizeof("--module=") - 1);
+		return !inout_settings.module_name.empty();
+	}
+
+	if (option.starts_with("--module-include="))
+	{
+		inout_settings.module_includes.emplace_back(option.substr(sizeof("--module-include=") - 1));
+		return !inout_settings.module_includes.back().empty();
+	}
+
+	if (option.starts_with("--task-type="))
+	{
+		inout_settings.task_type = option.substr(sizeof("--task-type=") - 1);
+		return !inout_settings.task_type.empty();
+	}
+
+	if (option.starts_with("--stats-file="))
+	{
+		inout_settings.stats_file = option.substr(sizeof("--stats-file=") - 1);
+		return true;
+	}
+
+	return false;
+}
+
+std::string escape_json_string(std::string_view source)
+{
+	std::string result;
+	result.reserve(source.size());
+	for (char c : source)
+	{
+		switch (c)
+		{
+		case '"':
+			result += "\\\"";
+			break;
+		case '\\':
+			result += "\\\\";
+			break;
+		case '\n':
+			result += "\\n";
+			break;
+		case '\t':
+			result += "\\t";
+			break;
+		default:
+			result += c;
+		}
+	}
+	return result;
+}
+
 std::string read_file_to_string(const std::filesystem::path &path)
 {
 	std::ifstream file(path);
@@ -14,11 +14,18 @@ DOCUMENTATION GOES HERE. What should even be in this header comment?
 #include <filesystem>
 #include <functional>
 #include <string_view>
-#include <regex>
+#include <iterator>
 #include <chrono>
 #include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <span>
+#include <unordered_set>
+#include <atomic>
+#include <thread>
 
 #include "function_finder/function_finder.hpp"
+#include "function_finder/allocation_tracking.hpp"
 
 /// <summary>
 /// Current Function Finder version
@@ -31,6 +38,46 @@ const int VERSION = 1;
 const std::vector<std::string> ACCEPTED_EXTENSIONS = {
 	".cpp", ".hpp", ".h", ".c", ".cxx" };
 
+/// <summary>
+/// The formats the '--stats' report can be printed in.
+/// </summary>
+enum class Stats_Format
+{
+	/// <summary>
+	/// No report is printed.
+	/// </summary>
+	NONE,
+	TEXT,
+	JSON
+};
+
+/// <summary>
+/// How the wrapper functions are generated. Set with '--wrappers=<full|template|table>'.
+/// </summary>
+enum class Wrapper_Style
+{
+	/// <summary>
+	/// A hand-unrolled parser per command. The most readable, and easy to step through.
+	/// </summary>
+	FULL,
+
+	/// <summary>
+	/// One line per command instantiating the shared \ref template_wrapper from
+	/// "function_finder/template_wrappers.hpp". Much smaller output, and commands with the same
+	/// argument types share their parsing code. Instrumented and asynchronous commands still get
+	/// full wrappers.
+	/// </summary>
+	TEMPLATE,
+
+	/// <summary>
+	/// A constexpr argument descriptor table per command, and a thin wrapper that has the shared
+	/// \ref parse_table_arguments parse its arguments. Keeps the parsing code in one small
+	/// function. Instrumented and asynchronous commands, and commands taking lists, still get full
+	/// wrappers.
+	/// </summary>
+	TABLE
+};
+
 /// <summary>
 /// A simple struct for passing around command line settings fed to the program.
 /// </summary>
@@ -61,11 +108,350 @@ struct Settings
 	/// "_function_" then the wrapper function will be called "_function_add"
 	/// </summary>
 	std::string wrapper_function_prefix;
+
+	/// <summary>
+	/// Whether to emit per-command invocation metrics into the wrappers. See 
+	/// "function_finder/instrumentation.hpp". Set with '--instrument'.
+	/// </summary>
+	bool instrument = false;
+
+	/// <summary>
+	/// Format of the timing and throughput report. Set with '--stats' or '--stats=<text|json>'.
+	/// </summary>
+	Stats_Format stats_format = Stats_Format::NONE;
+
+	/// <summary>
+	/// Number of slowest files to list in the report. Set with '--stats-top=<N>'.
+	/// </summary>
+	size_t stats_slowest_files = 10;
+
+	/// <summary>
+	/// Where to write the report. Printed to stdout if empty. Set with '--stats-file=<path>'.
+	/// </summary>
+	std::filesystem::path stats_file;
+
+	/// <summary>
+	/// Whether to skip printing progress messages, like the list of scanned files. Set with
+	/// '--quiet'.
+	/// </summary>
+	bool quiet = false;
+
+	/// <summary>
+	/// Name of the coroutine task type asynchronous client functions return, like "Task" for
+	/// functions returning 'Task<int>'. Such functions get wrappers returning a \ref Call_Task,
+	/// see "function_finder/command_task.hpp". Empty if asynchronous functions aren't supported.
+	/// Set with '--task-type=<name>'.
+	/// </summary>
+	std::string task_type;
+
+	/// <summary>
+	/// How the wrapper functions are generated. Set with '--wrappers=<full|template|table>'.
+	/// </summary>
+	Wrapper_Style wrapper_style = Wrapper_Style::FULL;
+
+	/// <summary>
+	/// Whether full wrappers format their error messages in place, rather than calling the shared
+	/// out-of-line error helpers in function_finder.hpp. Only useful to compare the two. Set with
+	/// '--inline-errors'.
+	/// </summary>
+	bool inline_errors = false;
+
+	/// <summary>
+	/// Name of the C++20 module to write the registry as. Consumers import the module, rather than
+	/// including a header that has to be parsed in every translation unit. Empty to write a header.
+	/// Set with '--module=<name>'.
+	/// </summary>
+	std::string module_name;
+
+	/// <summary>
+	/// Client headers the module includes, for declarations it can't write itself: commands in
+	/// namespaces or classes, and custom task types. They have to declare all commands, the module
+	/// doesn't declare any itself then. Set with '--module-include=<header>', which can be given
+	/// multiple times.
+	/// </summary>
+	std::vector<std::string> module_includes;
+
+	/// <summary>
+	/// Number of threads rendering the wrappers. 0 to use one per hardware thread. Set with
+	/// '--jobs=<N>'.
+	/// </summary>
+	size_t jobs = 0;
+
+	/// <summary>
+	/// Name of the id enum to generate, with one enumerator per command and a \ref Command_Table
+	/// to call commands by id. Empty to not generate one. Set with '--command-ids=<name>'.
+	/// </summary>
+	std::string command_id_type;
+
+	/// <summary>
+	/// Tag marking pure client functions whose results are cached by their wrappers, keyed by the
+	/// argument values. See "function_finder/memoization.hpp". Empty if nothing is memoized. Set
+	/// with '--memoize-tag=<tag>'.
+	/// </summary>
+	std::string memoize_tag;
+
+	/// <summary>
+	/// Number of results each memoized command keeps. Set with '--memoize-capacity=<N>'.
+	/// </summary>
+	size_t memoize_capacity = 128;
+
+	/// <summary>
+	/// Whether to also generate a typed entry point per command, which takes its first argument
+	/// from another command's result without converting it to text. See
+	/// "function_finder/pipeline.hpp". Set with '--typed-entries'.
+	/// </summary>
+	bool typed_entries = false;
+
+	/// <summary>
+	/// Whether the wrappers record their calls, with the parsed argument values, to the journal
+	/// started with 'start_command_journal()'. See "function_finder/command_journal.hpp". Set with
+	/// '--journal'.
+	/// </summary>
+	bool journal = false;
+
+	/// <summary>
+	/// Whether to also generate a binary entry point per command, which reads the arguments from a
+	/// binary buffer rather than parsing them from text. See "function_finder/binary_arguments.hpp".
+	/// Set with '--binary-entries'.
+	/// </summary>
+	bool binary_entries = false;
+
+	/// <summary>
+	/// Whether to also generate an exported 'function_finder_register_commands' function, so the
+	/// output can be built into a shared library and loaded, and reloaded, at runtime. See
+	/// "function_finder/hot_reload.hpp". Set with '--shared-library'.
+	/// </summary>
+	bool shared_library = false;
+};
+
+/// <summary>
+/// Timing of a single imported file.
+/// </summary>
+struct File_Stats
+{
+	std::filesystem::path path;
+	size_t bytes = 0;
+	size_t functions = 0;
+
+	/// <summary>
+	/// Time spent reading, scanning and parsing the file.
+	/// </summary>
+	std::chrono::nanoseconds duration{};
+};
+
+/// <summary>
+/// Timing and throughput numbers gathered during a run. Always collected, since it's cheap, but
+/// only reported when asked for with '--stats'.
+/// </summary>
+struct Run_Stats
+{
+	/// <summary>
+	/// Time spent iterating directories and filtering extensions.
+	/// </summary>
+	std::chrono::nanoseconds directory_walk{};
+
+	/// <summary>
+	/// Time spent reading files into memory.
+	/// </summary>
+	std::chrono::nanoseconds read{};
+
+	/// <summary>
+	/// Time spent looking for the search term in file contents.
+	/// </summary>
+	std::chrono::nanoseconds scan{};
+
+	/// <summary>
+	/// Time spent parsing the declarations of found functions.
+	/// </summary>
+	std::chrono::nanoseconds parse{};
+
+	/// <summary>
+	/// Time spent generating the output file contents.
+	/// </summary>
+	std::chrono::nanoseconds export_code{};
+
+	/// <summary>
+	/// Time spent writing the output file to disk.
+	/// </summary>
+	std::chrono::nanoseconds write{};
+
+	/// <summary>
+	/// Allocations made while importing. Only counted in builds with allocation tracking, see
+	/// "function_finder/allocation_tracking.hpp".
+	/// </summary>
+	Allocation_Counters import_allocations;
+
+	/// <summary>
+	/// Allocations made while generating and writing the output file.
+	/// </summary>
+	Allocation_Counters export_allocations;
+
+	size_t files_scanned = 0;
+	size_t bytes_scanned = 0;
+	size_t functions_found = 0;
+
+	/// <summary>
+	/// Per-file timings, in import order.
+	/// </summary>
+	std::vector<File_Stats> files;
+};
+
+/// <summary>
+/// Adds the time between its construction and destruction to a duration.
+/// </summary>
+class Scoped_Timer
+{
+private:
+	std::chrono::nanoseconds &target;
+	std::chrono::steady_clock::time_point start;
+
+public:
+	explicit Scoped_Timer(std::chrono::nanoseconds &target)
+		: target(target), start(std::chrono::steady_clock::now())
+	{
+	}
+
+	~Scoped_Timer()
+	{
+		target += std::chrono::steady_clock::now() - start;
+	}
+};
+
+/// <summary>
+/// Memory for everything the importer produces in one run. Strings and argument lists are bump
+/// allocated from a few large blocks, which are all freed at once when the arena is destroyed.
+/// Strings that repeat across functions, like file paths, are interned so they're stored once.
+/// </summary>
+class Import_Arena
+{
+private:
+	std::pmr::monotonic_buffer_resource memory{ 64 * 1024 };
+	std::pmr::unordered_set<std::string_view> interned_strings{ &memory };
+
+public:
+	Import_Arena() = default;
+	Import_Arena(const Import_Arena &) = delete;
+	Import_Arena &operator=(const Import_Arena &) = delete;
+
+	/// <summary>
+	/// Allocates uninitialized memory for count objects of type T. The objects are never
+	/// destroyed, so T should be trivially destructible.
+	/// </summary>
+	template <typename T>
+	T *allocate(size_t count)
+	{
+		return static_cast<T *>(memory.allocate(count * sizeof(T), alignof(T)));
+	}
+
+	/// <summary>
+	/// Copies a string into the arena.
+	/// </summary>
+	std::string_view copy(std::string_view source)
+	{
+		if (source.empty())
+		{
+			return {};
+		}
+		char *destination = allocate<char>(source.size());
+		std::copy(source.begin(), source.end(), destination);
+		return { destination, source.size() };
+	}
+
+	/// <summary>
+	/// Copies a string into the arena, unless an equal string has been interned before.
+	/// </summary>
+	std::string_view intern(std::string_view source)
+	{
+		auto found = interned_strings.find(source);
+		if (found != interned_strings.end())
+		{
+			return *found;
+		}
+		return *interned_strings.insert(copy(source)).first;
+	}
+};
+
+/// <summary>
+/// An argument as parsed by the importer. Strings point into an \ref Import_Arena.
+/// </summary>
+struct Parsed_Argument
+{
+	std::string_view name;
+	Value_Type type = Value_Type::UNKNOWN;
+
+	/// <summary>
+	/// The type as written in the declaration, like "std::span<const float>". Interned.
+	/// </summary>
+	std::string_view cpp_type;
+
+	bool has_default_value = false;
+
+	/// <summary>
+	/// Zero if has_default_value is false.
+	/// </summary>
+	Value default_value = {};
+
+	/// <summary>
+	/// The argument note, with newlines escaped so it can be written into a string literal.
+	/// </summary>
+	std::string_view note;
 };
 
 /// <summary>
-/// A wrapper for std::ostream specializing it for writing code files. This includes handling of
-/// indentation and automatic endlines
+/// A function as parsed by the importer. This is the importer-side counterpart to
+/// \ref Function_Decl, which is what the generated code builds for the consumer. Strings and the
+/// argument list point into an \ref Import_Arena, which has to outlive it.
+/// </summary>
+struct Parsed_Function
+{
+	std::string_view name;
+
+	/// <summary>
+	/// The function note, with newlines escaped so it can be written into a string literal.
+	/// </summary>
+	std::string_view note;
+
+	/// <summary>
+	/// Interned, so all functions of a file share it.
+	/// </summary>
+	std::string_view file;
+
+	size_t line = 0;
+
+	/// <summary>
+	/// For asynchronous functions, the type of the value their task produces.
+	/// </summary>
+	Value_Type return_type = Value_Type::UNKNOWN;
+
+	/// <summary>
+	/// The return type as written in the declaration, like "Task<int>". Interned.
+	/// </summary>
+	std::string_view return_cpp_type;
+
+	/// <summary>
+	/// Whether the function is a coroutine returning the task type from \ref Settings::task_type.
+	/// </summary>
+	bool is_async = false;
+
+	/// <summary>
+	/// Whether the function has the tag from \ref Settings::memoize_tag, so its wrapper caches
+	/// results.
+	/// </summary>
+	bool is_memoized = false;
+
+	std::span<const Parsed_Argument> arguments;
+	int num_required_args = 0;
+	int num_optional_args = 0;
+
+	/// <summary>
+	/// False for functions in namespaces or classes, which the consumer has to declare themselves.
+	/// </summary>
+	bool create_predeclaration = false;
+};
+
+/// <summary>
+/// Writes code into a string buffer. This includes handling of indentation and automatic endlines.
+/// Nothing is flushed or copied through streams, the buffer is written to the file in one go.
 /// </summary>
 class Cpp_File_Writer
 {
@@ -73,7 +459,7 @@ private:
 	/// <summary>
 	/// The number of spaces to use per indentation level.
 	/// </summary>
-	const int tab_size = 4;
+	static constexpr int tab_size = 4;
 
 	/// <summary>
 	/// Current indentation level.
@@ -81,9 +467,9 @@ private:
 	int current_indent = 0;
 
 	/// <summary>
-	/// The wrapped stream used for output
+	/// The buffer that is appended to.
 	/// </summary>
-	std::ostream &stream;
+	std::string &buffer;
 
 	/// <summary>
 	/// Whether we're appending to the end of a line. This means to NOT add indentation or to end
@@ -91,42 +477,72 @@ private:
 	/// </summary>
 	bool line_continuation_mode = false;
 
+	void begin_line()
+	{
+		if (!line_continuation_mode)
+		{
+			buffer.append((size_t)(current_indent * tab_size), ' ');
+		}
+	}
+
+	void end_line()
+	{
+		if (!line_continuation_mode)
+		{
+			buffer += '\n';
+		}
+	}
+
 public:
-	explicit Cpp_File_Writer(std::ostream &stream)
-		:stream(stream)
+	/// <summary>
+	/// Creates a writer appending to out_buffer, starting at the given indentation level.
+	/// </summary>
+	explicit Cpp_File_Writer(std::string &out_buffer, int indent = 0)
+		: current_indent(indent), buffer(out_buffer)
 	{
 	}
 
 	/// <summary>
-	/// Override stream operator to handle indentation level before outputting the actual obj.
-	/// Includes
+	/// Writes obj as a line, or as part of the current line in line continuation mode.
 	/// </summary>
 	/// <typeparam name="T">Type of parameter to output</typeparam>
 	/// <param name="obj">Object to output</param>
-	/// <returns></returns>
+	/// <returns>The writer, to allow chaining.</returns>
 	template <typename T>
 	Cpp_File_Writer &operator<<(T const &obj)
 	{
-		// Handle indentation
-		if (!line_continuation_mode)
+		begin_line();
+		if constexpr (std::is_convertible_v<T const &, std::string_view>)
 		{
-			for (int i = 0; i < current_indent * tab_size; i++)
-			{
-				stream << ' ';
-			}
+			buffer += std::string_view(obj);
 		}
-
-		stream << obj;
-
-		if (!line_continuation_mode)
+		else
 		{
-			stream << "\n";
+			std::format_to(std::back_inserter(buffer), "{}", obj);
 		}
-
-		// Return stream to allow chaining.
+		end_line();
 		return *this;
 	}
 
+	/// <summary>
+	/// Like operator<<(std::format(...)), but formats straight into the buffer.
+	/// </summary>
+	template <typename... Args>
+	void format(std::format_string<Args...> pattern, Args &&...args)
+	{
+		begin_line();
+		std::format_to(std::back_inserter(buffer), pattern, std::forward<Args>(args)...);
+		end_line();
+	}
+
+	/// <summary>
+	/// Appends already formatted code as is, like the output of another writer.
+	/// </summary>
+	void append(std::string_view code)
+	{
+		buffer += code;
+	}
+
 	void enable_line_continuation_mode()
 	{
 		line_continuation_mode = true;
@@ -147,9 +563,14 @@ public:
 		current_indent--;
 	}
 
+	int get_indent() const
+	{
+		return current_indent;
+	}
+
 	void skip_line()
 	{
-		stream << std::endl;
+		buffer += '\n';
 	}
 };
 
@@ -159,45 +580,56 @@ public:
 /// </summary>
 /// <param name="settings">The settings to use when importing, most relevant is the source path.
 /// </param>
+/// <param name="arena">Memory the parsed functions are stored in.</param>
 /// <param name="inout_functions">The list of all parsed functions.</param>
+/// <param name="inout_stats">Timing and throughput numbers are added to this.</param>
 /// <returns>True if the import was successful and without issues.</returns>
-bool import_functions(const Settings &settings, std::vector<Function_Decl> &inout_functions);
+bool import_functions(const Settings &settings, Import_Arena &arena,
+	std::vector<Parsed_Function> &inout_functions, Run_Stats &inout_stats);
 
 /// <summary>
 /// Exports all the functions in the functions parameter to the destination file.
 /// </summary>
 /// <param name="settings">Settings to use when exporting.</param>
 /// <param name="functions">The parsed functions.</param>
+/// <param name="inout_stats">Timing numbers are added to this.</param>
 /// <returns>True if the export was successful.</returns>
-bool export_functions(const Settings &settings, const std::vector<Function_Decl> &functions);
+bool export_functions(const Settings &settings, const std::vector<Parsed_Function> &functions,
+	Run_Stats &inout_stats);
 
 /// <summary>
 /// Imports all functions found for the search term in files in a directory recursively.
 /// </summary>
 /// <param name="path">Path to the directory.</param>
+/// <param name="arena">Memory the parsed functions are stored in.</param>
 /// <param name="functions">List of functions to import into.</param>
 /// <param name="settings">Settings used for importing.</param>
+/// <param name="inout_stats">Timing and throughput numbers are added to this.</param>
 /// <returns>True if import was successful.</returns>
-bool import_directory(const std::filesystem::path &path, std::vector<Function_Decl> &functions,
-	const Settings &settings);
+bool import_directory(const std::filesystem::path &path, Import_Arena &arena,
+	std::vector<Parsed_Function> &functions, const Settings &settings, Run_Stats &inout_stats);
 
 /// <summary>
 /// Imports all functions found for the search term in the file.
 /// </summary>
 /// <param name="path">Path to the directory.</param>
+/// <param name="arena">Memory the parsed functions are stored in.</param>
 /// <param name="functions">List of functions to import into.</param>
 /// <param name="settings">Settings used for importing.</param>
+/// <param name="inout_stats">Timing and throughput numbers are added to this.</param>
 /// <returns>True if import was successful.</returns>
-bool import_file(const std::filesystem::path &path, std::vector<Function_Decl> &inout_functions,
-	const Settings &settings);
+bool import_file(const std::filesystem::path &path, Import_Arena &arena,
+	std::vector<Parsed_Function> &inout_functions, const Settings &settings, Run_Stats &inout_stats);
 
 /// <summary>
 /// Imports a function from source.
 /// </summary>
 /// <param name="source">A string_view starting with a function declaration to be parsed.</param>
+/// <param name="arena">Memory the function's strings and arguments are stored in.</param>
 /// <param name="out_function">Function to output into.</param>
 /// <returns>True if successful.</returns>
-bool import_function(std::string_view source, Function_Decl *out_function, const Settings &settings);
+bool import_function(std::string_view source, Import_Arena &arena, Parsed_Function *out_function,
+	const Settings &settings);
 
 
 
@@ -208,20 +640,23 @@ bool import_function(std::string_view source, Function_Decl *out_function, const
  /// <summary>
  /// Fetches arguments for the arguments string pointed to by source.
  /// </summary>
- /// <param name="source">A string_view starting with a string parameter list.</param>
- /// <param name="out_args">List to store parsed arguments in.</param>
- /// <returns>True if successful.
- /// </returns>
-bool get_arguments(std::string_view source, std::vector<Argument> &out_args);
+/// <param name="source">A string_view starting with a string parameter list.</param>
+/// <param name="arena">Memory the arguments are stored in.</param>
+/// <param name="out_args">Set to the parsed arguments.</param>
+/// <returns>True if successful.
+/// </returns>
+bool get_arguments(std::string_view source, Import_Arena &arena,
+	std::span<const Parsed_Argument> &out_args);
 
 /// <summary>
 /// Parses an argument pointed to by source.
 /// </summary>
 /// <param name="source">A string_view starting with a string parameter</param>
+/// <param name="arena">Memory the argument's strings are stored in.</param>
 /// <param name="out_arg">Where to store the parsed argument.</param>
 /// <returns>The string length of the parsed argument. Return value can be used to step forward 
 /// in source</returns>
-size_t get_argument(std::string_view source, Argument &out_arg);
+size_t get_argument(std::string_view source, Import_Arena &arena, Parsed_Argument &out_arg);
 
 /// <summary>
 /// Parses a C++ type into a \ref Value_Type pointed to by source.
@@ -232,32 +667,139 @@ size_t get_argument(std::string_view source, Argument &out_arg);
 /// in source</returns>
 size_t get_type(std::string_view source, Value_Type &out_type);
 
-size_t get_comment(std::string_view source, std::string &out_result);
+/// <summary>
+/// Parses the configured task type of asynchronous functions, like "Task<int>" or "Task<void>", see
+/// \ref Settings::task_type. A task type without template arguments produces void.
+/// </summary>
+/// <param name="source">A string_view starting with a C++ type.</param>
+/// <param name="settings">Settings holding the task type name.</param>
+/// <param name="out_type">Set to the type of the value the task produces, UNKNOWN if it isn't
+/// supported.</param>
+/// <returns>The string length of the task type, or 0 if source doesn't start with it.</returns>
+size_t get_task_type(std::string_view source, const Settings &settings, Value_Type &out_type);
+
+/// <summary>
+/// Parses the template argument list of a std::vector or std::span, like "<const float>", into the
+/// matching list type.
+/// </summary>
+/// <param name="source">A string_view starting right after "std::vector" or "std::span".</param>
+/// <param name="out_type">Set to INTEGER_ARRAY, FLOAT_ARRAY or DOUBLE_ARRAY, or UNKNOWN if the
+/// element type isn't supported.</param>
+/// <returns>The length of the template argument list, or 0 if it couldn't be parsed.</returns>
+size_t get_array_element_type(std::string_view source, Value_Type &out_type);
+
+/// <summary>
+/// Finds the comment pointed to by source.
+/// </summary>
+/// <param name="out_result">Set to the comment text, without the comment markers and surrounding
+/// whitespace. Points into source.</param>
+/// <returns>The length of the comment, or 0 if source doesn't start with one.</returns>
+size_t get_comment(std::string_view source, std::string_view &out_result);
+
+/// <summary>
+/// Copies a comment into the arena, escaping newlines so it can be written into a string literal.
+/// </summary>
+std::string_view store_note(Import_Arena &arena, std::string_view comment);
 
 /**************************************
  *           Exporter helpers         *
  **************************************/
 void export_header(Cpp_File_Writer &w, const Settings &settings);
-void export_pre_declarations(Cpp_File_Writer &w, const std::vector<Function_Decl> &functions);
-void export_wrapper_functions(Cpp_File_Writer &w, const std::vector<Function_Decl> &functions, const Settings &settings);
-void export_wrapper_function(Cpp_File_Writer &w, const Function_Decl &f, const Settings &settings);
-void export_argument_handler(Cpp_File_Writer &w, size_t i, const Argument &arg);
-void export_consumer_function_value_handler(Cpp_File_Writer &w, const Function_Decl &f);
+void export_pre_declarations(Cpp_File_Writer &w, const std::vector<Parsed_Function> &functions,
+	const Settings &settings);
+void export_wrapper_functions(Cpp_File_Writer &w, const std::vector<Parsed_Function> &functions,
+	const Settings &settings, Allocation_Counters &inout_allocations);
+void export_wrapper(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings);
+void export_wrapper_function(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings);
+void export_template_wrapper(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings);
+void export_table_wrapper(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings);
+void export_piped_wrapper(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings);
+void export_binary_wrapper(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings);
+void export_argument_handler(Cpp_File_Writer &w, const Parsed_Function &f, size_t i,
+	const Settings &settings, size_t num_piped_args = 0);
+void export_consumer_function_value_handler(Cpp_File_Writer &w, const Parsed_Function &f,
+	const Settings &settings);
+void export_memo_cache(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings);
+void export_memo_lookup(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings);
+void export_command_ids(Cpp_File_Writer &w, const std::vector<Parsed_Function> &functions,
+	const Settings &settings);
 void export_initialization_function(Cpp_File_Writer &w,
-	const std::vector<Function_Decl> &functions, const Settings &settings);
+	const std::vector<Parsed_Function> &functions, const Settings &settings,
+	Allocation_Counters &inout_allocations);
+void export_registration_function(Cpp_File_Writer &w, const Settings &settings);
+void export_initialization_entry(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings);
+
+std::string function_call_string(const Parsed_Function &func);
+std::string memo_key_type(const Parsed_Function &f);
+bool has_typed_entry(const Parsed_Function &f, const Settings &settings);
+bool has_binary_entry(const Parsed_Function &f, const Settings &settings);
+
+/// <summary>
+/// Turns a function name into something usable in identifiers, by replacing the colons of
+/// namespaces and classes with underscores.
+/// </summary>
+std::string to_identifier(std::string_view name);
+
+/// <summary>
+/// Writes a default value as a C++ literal of its own type. Unlike \ref to_string, whole floats
+/// and doubles keep their decimal point, like '2.0', so they don't turn into ints in the output.
+/// </summary>
+std::string to_cpp_literal(const Value &value);
 
-std::string function_call_string(const Function_Decl &func);
+/// <summary>
+/// Writes the code for one function, like \ref export_wrapper.
+/// </summary>
+using Function_Exporter = void (*)(Cpp_File_Writer &w, const Parsed_Function &f, const Settings &settings);
+
+/// <summary>
+/// Minimum number of functions per thread in \ref export_in_parallel.
+/// </summary>
+inline constexpr size_t EXPORT_FUNCTIONS_PER_JOB = 64;
+
+/// <summary>
+/// Number of threads to export the given number of functions with.
+/// </summary>
+size_t get_export_jobs(const Settings &settings, size_t num_functions);
+
+/// <summary>
+/// Renders the code of every function with export_function on multiple threads, then appends it
+/// to w in the order of functions. The output doesn't depend on the number of threads.
+/// </summary>
+/// <param name="w">Writer to append to. The code is indented to its current level.</param>
+/// <param name="functions">Functions to export.</param>
+/// <param name="settings">Export settings, including the number of threads.</param>
+/// <param name="export_function">Writes the code for one function.</param>
+/// <param name="inout_allocations">The allocations of the worker threads are added to this.</param>
+void export_in_parallel(Cpp_File_Writer &w, const std::vector<Parsed_Function> &functions,
+	const Settings &settings, Function_Exporter export_function, Allocation_Counters &inout_allocations);
+
+/// <summary>
+/// The statement a wrapper for the function returns its call result with. Asynchronous wrappers
+/// are coroutines, so they co_return it.
+/// </summary>
+std::string_view return_statement(const Parsed_Function &func);
 
 /**************************************
  *           Printing functions       *
  **************************************/
 void print_help();
+void print_experimental();
 void print_extensions();
 void print_example();
 
+/// <summary>
+/// Prints the '--stats' report in the format asked for by the settings.
+/// </summary>
+/// <param name="settings">Settings deciding the format and destination of the report.</param>
+/// <param name="stats">The numbers gathered during the run.</param>
+/// <returns>True if the report could be written.</returns>
+bool print_stats(const Settings &settings, const Run_Stats &stats);
+
 
 /**************************************
  *             Utilities              *
  **************************************/
+bool parse_option(std::string_view option, Settings &inout_settings);
+std::string escape_json_string(std::string_view source);
 std::string read_file_to_string(const std::filesystem::path &path);
 bool file_matches_extension(const std::filesystem::path &path);
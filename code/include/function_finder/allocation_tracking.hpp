@@ -0,0 +1,126 @@
+/*
+Counts heap allocations per thread, to make allocation regressions visible. The counting is done
+by replacement global operator new/delete functions, which a program opts into by expanding
+FUNCTION_FINDER_ALLOCATION_HOOKS in exactly one of its source files.
+
+Function Finder itself, and instrumented wrappers, only read the counters when built with the
+FUNCTION-FINDER_TRACK_ALLOCATIONS CMake option, which defines FUNCTION_FINDER_TRACK_ALLOCATIONS.
+Without hooks the counters simply stay at zero.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "function_finder/function_finder.hpp"
+
+/// <summary>
+/// Number of allocations and allocated bytes.
+/// </summary>
+struct Allocation_Counters
+{
+	uint64_t allocations = 0;
+	uint64_t bytes = 0;
+
+	Allocation_Counters &operator+=(const Allocation_Counters &other)
+	{
+		allocations += other.allocations;
+		bytes += other.bytes;
+		return *this;
+	}
+
+	Allocation_Counters operator-(const Allocation_Counters &other) const
+	{
+		return { allocations - other.allocations, bytes - other.bytes };
+	}
+};
+
+/// <summary>
+/// Whether this build counts allocations in Function Finder and instrumented wrappers.
+/// </summary>
+#ifdef FUNCTION_FINDER_TRACK_ALLOCATIONS
+inline constexpr bool ALLOCATION_TRACKING_ENABLED = true;
+#else
+inline constexpr bool ALLOCATION_TRACKING_ENABLED = false;
+#endif
+
+/// <summary>
+/// Allocations made by the calling thread since it started. Trivially constructible, so it's
+/// safe to touch from operator new at any point of the thread's life.
+/// </summary>
+inline thread_local Allocation_Counters thread_allocation_counters;
+
+/// <summary>
+/// Called by the allocation hooks for every allocation.
+/// </summary>
+inline void record_allocation(size_t bytes)
+{
+	thread_allocation_counters.allocations++;
+	thread_allocation_counters.bytes += bytes;
+}
+
+/// <summary>
+/// Returns the allocations made by the calling thread so far. Subtract two snapshots to get the
+/// allocations in between.
+/// </summary>
+inline Allocation_Counters get_thread_allocation_counters()
+{
+	return thread_allocation_counters;
+}
+
+/// <summary>
+/// Adds the allocations the calling thread makes between its construction and destruction to a
+/// set of counters.
+/// </summary>
+class Scoped_Allocation_Counter
+{
+private:
+	Allocation_Counters &target;
+	Allocation_Counters start;
+
+public:
+	explicit Scoped_Allocation_Counter(Allocation_Counters &target)
+		: target(target), start(get_thread_allocation_counters())
+	{
+	}
+
+	~Scoped_Allocation_Counter()
+	{
+		target += get_thread_allocation_counters() - start;
+	}
+
+	Scoped_Allocation_Counter(const Scoped_Allocation_Counter &) = delete;
+	Scoped_Allocation_Counter &operator=(const Scoped_Allocation_Counter &) = delete;
+};
+
+/// <summary>
+/// Frees memory allocated by the allocation hooks. Kept out of line: GCC warns about
+/// -Wmismatched-new-delete wherever it inlines a delete that frees memory from operator new, not
+/// knowing that the hooks' operator new allocates with malloc.
+/// </summary>
+FUNCTION_FINDER_NOINLINE inline void free_hooked_allocation(void *memory) noexcept
+{
+	std::free(memory);
+}
+
+/// <summary>
+/// Replacement global allocation functions feeding \ref record_allocation. Expand in exactly one
+/// source file of the program, at global scope. The nothrow and array forms of the standard library
+/// forward to these, over-aligned allocations are not counted.
+/// </summary>
+#define FUNCTION_FINDER_ALLOCATION_HOOKS                                                           \
+	void *operator new(std::size_t size)                                                           \
+	{                                                                                              \
+		record_allocation(size);                                                                   \
+		if (void *memory = std::malloc(size ? size : 1))                                           \
+		{                                                                                          \
+			return memory;                                                                         \
+		}                                                                                          \
+		throw std::bad_alloc();                                                                    \
+	}                                                                                              \
+	void *operator new[](std::size_t size) { return ::operator new(size); }                        \
+	void operator delete(void *memory) noexcept { free_hooked_allocation(memory); }                \
+	void operator delete[](void *memory) noexcept { free_hooked_allocation(memory); }              \
+	void operator delete(void *memory, std::size_t) noexcept { free_hooked_allocation(memory); }   \
+	void operator delete[](void *memory, std::size_t) noexcept { free_hooked_allocation(memory); }
@@ -0,0 +1,345 @@
+/*
+Binary entry points, for callers that already have typed values, like RPC servers. Registries
+generated with '--binary-entries' get a second wrapper per command, stored in
+'Function_Decl::binary_function', which reads the arguments from a binary buffer straight into the
+client function's parameters, rather than parsing them from text:
+
+    std::string arguments;
+    write_binary_value(arguments, 1);
+    write_binary_value(arguments, 2.5);
+
+    Call_Result result = commands["add"].binary_function(arguments, true);
+    std::string response;
+    write_binary_result(response, result);
+
+The buffer holds the arguments in order, each as its \ref Value_Type as a byte followed by the
+value, little endian: integers and floats take 4 bytes, doubles 8 and bools 1. Strings are their
+length as 4 bytes followed by the characters, and lists their element count as 4 bytes followed by
+the elements. Optional arguments may be left off the end, but nothing may follow the last argument.
+Results are encoded the same way, see
+\ref write_binary_result, with no value after the type for void results.
+*/
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "function_finder/function_finder.hpp"
+
+/// <summary>
+/// Appends a number's bytes, little endian.
+/// </summary>
+template <typename T>
+inline void write_binary_bytes(std::string &out, T value)
+{
+	char bytes[sizeof(T)];
+	std::memcpy(bytes, &value, sizeof(T));
+	if constexpr (std::endian::native == std::endian::big)
+	{
+		std::reverse(bytes, bytes + sizeof(T));
+	}
+	out.append(bytes, sizeof(T));
+}
+
+/// <summary>
+/// Reads a little endian number from the front of input, and advances past it.
+/// </summary>
+/// <returns>False if input is too short.</returns>
+template <typename T>
+inline bool read_binary_bytes(std::string_view &input, T &out_value)
+{
+	if (input.size() < sizeof(T))
+	{
+		return false;
+	}
+	char bytes[sizeof(T)];
+	std::memcpy(bytes, input.data(), sizeof(T));
+	if constexpr (std::endian::native == std::endian::big)
+	{
+		std::reverse(bytes, bytes + sizeof(T));
+	}
+	std::memcpy(&out_value, bytes, sizeof(T));
+	input.remove_prefix(sizeof(T));
+	return true;
+}
+
+/// <summary>
+/// The \ref Value_Type a C++ type is encoded as.
+/// </summary>
+template <typename T>
+constexpr Value_Type binary_value_type()
+{
+	if constexpr (std::is_same_v<T, int>) return Value_Type::INTEGER;
+	else if constexpr (std::is_same_v<T, float>) return Value_Type::FLOAT;
+	else if constexpr (std::is_same_v<T, double>) return Value_Type::DOUBLE;
+	else if constexpr (std::is_same_v<T, bool>) return Value_Type::BOOLEAN;
+	else if constexpr (std::is_same_v<T, std::vector<int>>) return Value_Type::INTEGER_ARRAY;
+	else if constexpr (std::is_same_v<T, std::vector<float>>) return Value_Type::FLOAT_ARRAY;
+	else if constexpr (std::is_same_v<T, std::vector<double>>) return Value_Type::DOUBLE_ARRAY;
+	else return Value_Type::STRING;
+}
+
+inline void write_binary_value(std::string &out, int value)
+{
+	out.push_back((char)Value_Type::INTEGER);
+	write_binary_bytes(out, (int32_t)value);
+}
+
+inline void write_binary_value(std::string &out, float value)
+{
+	out.push_back((char)Value_Type::FLOAT);
+	write_binary_bytes(out, value);
+}
+
+inline void write_binary_value(std::string &out, double value)
+{
+	out.push_back((char)Value_Type::DOUBLE);
+	write_binary_bytes(out, value);
+}
+
+inline void write_binary_value(std::string &out, bool value)
+{
+	out.push_back((char)Value_Type::BOOLEAN);
+	out.push_back(value ? 1 : 0);
+}
+
+inline void write_binary_value(std::string &out, std::string_view value)
+{
+	out.push_back((char)Value_Type::STRING);
+	write_binary_bytes(out, (uint32_t)value.size());
+	out += value;
+}
+
+/// <summary>
+/// Without this, string literals would be written as bools.
+/// </summary>
+inline void write_binary_value(std::string &out, const char *value)
+{
+	write_binary_value(out, std::string_view(value));
+}
+
+template <typename T>
+inline void write_binary_value(std::string &out, const std::vector<T> &values)
+{
+	out.push_back((char)binary_value_type<std::vector<T>>());
+	write_binary_bytes(out, (uint32_t)values.size());
+	for (T value : values)
+	{
+		write_binary_bytes(out, value);
+	}
+}
+
+/// <summary>
+/// Encodes all arguments of a call in one go.
+/// </summary>
+template <typename... Args>
+inline std::string write_binary_arguments(const Args &...args)
+{
+	std::string out;
+	(write_binary_value(out, args), ...);
+	return out;
+}
+
+/// <summary>
+/// Reads an argument from the front of input, and advances past it. Used by the binary entry
+/// points. The value has to have exactly the argument's type.
+/// </summary>
+/// <returns>False if the type doesn't match or the value is cut off. Nothing is read then.</returns>
+template <typename T>
+inline bool read_binary_argument(std::string_view &input, T &out_value)
+{
+	if (input.empty() || (Value_Type)input[0] != binary_value_type<T>())
+	{
+		return false;
+	}
+	std::string_view rest = input.substr(1);
+
+	if constexpr (std::is_same_v<T, int>)
+	{
+		int32_t value;
+		if (!read_binary_bytes(rest, value))
+		{
+			return false;
+		}
+		out_value = value;
+	}
+	else if constexpr (std::is_same_v<T, bool>)
+	{
+		uint8_t value;
+		if (!read_binary_bytes(rest, value))
+		{
+			return false;
+		}
+		out_value = value != 0;
+	}
+	else if constexpr (std::is_floating_point_v<T>)
+	{
+		if (!read_binary_bytes(rest, out_value))
+		{
+			return false;
+		}
+	}
+	else if constexpr (std::is_same_v<T, std::string>)
+	{
+		uint32_t size;
+		if (!read_binary_bytes(rest, size) || rest.size() < size)
+		{
+			return false;
+		}
+		out_value.assign(rest.data(), size);
+		rest.remove_prefix(size);
+	}
+	else
+	{
+		using Element = typename T::value_type;
+		uint32_t count;
+		if (!read_binary_bytes(rest, count) || rest.size() / sizeof(Element) < count)
+		{
+			return false;
+		}
+		out_value.resize(count);
+		if constexpr (std::endian::native == std::endian::little)
+		{
+			std::memcpy(out_value.data(), rest.data(), count * sizeof(Element));
+			rest.remove_prefix(count * sizeof(Element));
+		}
+		else
+		{
+			for (Element &element : out_value)
+			{
+				read_binary_bytes(rest, element);
+			}
+		}
+	}
+
+	input = rest;
+	return true;
+}
+
+/// <summary>
+/// Encodes the value of a successful call. Strings are taken from string_value, so they're never
+/// truncated.
+/// </summary>
+inline void write_binary_result(std::string &out, const Call_Result &result)
+{
+	switch (result.value.type)
+	{
+	case Value_Type::INTEGER:
+		write_binary_value(out, result.value.data.int_value);
+		break;
+	case Value_Type::FLOAT:
+		write_binary_value(out, result.value.data.float_value);
+		break;
+	case Value_Type::DOUBLE:
+		write_binary_value(out, result.value.data.double_value);
+		break;
+	case Value_Type::BOOLEAN:
+		write_binary_value(out, result.value.data.bool_value);
+		break;
+	case Value_Type::STRING:
+		write_binary_value(out, std::string_view(result.string_value));
+		break;
+	default:
+		out.push_back((char)Value_Type::VOID);
+		break;
+	}
+}
+
+/// <summary>
+/// Decodes a result encoded with \ref write_binary_result, and advances past it.
+/// </summary>
+/// <returns>False if the result is cut off or of a type commands don't return.</returns>
+inline bool read_binary_result(std::string_view &input, Call_Result &out_result)
+{
+	if (input.empty())
+	{
+		return false;
+	}
+
+	Value_Type type = (Value_Type)input[0];
+	bool success = false;
+	switch (type)
+	{
+	case Value_Type::VOID:
+		input.remove_prefix(1);
+		success = true;
+		break;
+	case Value_Type::INTEGER:
+		success = read_binary_argument(input, out_result.value.data.int_value);
+		break;
+	case Value_Type::FLOAT:
+		success = read_binary_argument(input, out_result.value.data.float_value);
+		break;
+	case Value_Type::DOUBLE:
+		success = read_binary_argument(input, out_result.value.data.double_value);
+		break;
+	case Value_Type::BOOLEAN:
+		success = read_binary_argument(input, out_result.value.data.bool_value);
+		break;
+	case Value_Type::STRING:
+		success = read_binary_argument(input, out_result.string_value);
+		if (success)
+		{
+			set_string_value(out_result.value, out_result.string_value);
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (success)
+	{
+		out_result.value.type = type;
+		out_result.status = Call_Result_Status::SUCCESS;
+	}
+	return success;
+}
+
+/// <summary>
+/// Sets the error binary entry points report when an argument can't be read. Kept out of line,
+/// like \ref set_argument_parsing_error.
+/// </summary>
+/// <param name="input">What's left of the arguments, starting at the one that failed.</param>
+FUNCTION_FINDER_COLD FUNCTION_FINDER_NOINLINE inline void set_binary_argument_error(
+	Call_Result &out_result, size_t index, std::string_view argument_name, Value_Type type,
+	std::string_view input)
+{
+	Value_Type provided_type = (Value_Type)input[0];
+	if (provided_type == type)
+	{
+		out_result.error_message = std::format("Failed to read argument {} '{}'. The {} is cut off",
+			index, argument_name, value_type_to_cpp_type(type));
+	}
+	else
+	{
+		// Unknown types have no name.
+		std::string provided_name = value_type_to_cpp_type(provided_type);
+		out_result.error_message = std::format("Failed to read argument {} '{}'. Expected a {}, but got {}",
+			index, argument_name, value_type_to_cpp_type(type),
+			provided_name.empty() ? std::format("type {}", (int)provided_type) : "a " + provided_name);
+	}
+	out_result.status = Call_Result_Status::ARGUMENT_PARSING_ERROR;
+	out_result.error_helper_value = (int)index;
+}
+
+/// <summary>
+/// Sets the error binary entry points report when bytes are left after the last argument, which
+/// points at a broken encoder or framing rather than a wrong argument. Kept out of line, like
+/// \ref set_argument_parsing_error.
+/// </summary>
+/// <param name="input">What's left of the arguments after the last one.</param>
+FUNCTION_FINDER_COLD FUNCTION_FINDER_NOINLINE inline void set_extra_binary_arguments_error(
+	Call_Result &out_result, std::string_view command_name, size_t num_args, std::string_view input)
+{
+	out_result.error_message = std::format("'{}' takes {} arguments, but {} bytes are left after the last one",
+		command_name, num_args, input.size());
+	out_result.status = Call_Result_Status::ARGUMENT_PARSING_ERROR;
+	out_result.error_helper_value = (int)num_args;
+}
@@ -0,0 +1,889 @@
+/*
+Records command calls to an append-only binary journal, and replays journals. Only included by
+generated files created with the '--journal' option, whose wrappers record every call they make
+once its arguments are parsed:
+
+    start_command_journal("session.ffj");
+    ...                                     // Calls are recorded, from any thread.
+    stop_command_journal();
+
+    Journal_Replay_Stats stats;
+    replay_command_journal("session.ffj", commands, stats);
+    std::cout << to_string(stats);
+
+A call is recorded as the command's id, a timestamp and the parsed argument values, in a compact
+binary form. Each thread appends to a buffer of its own without taking locks, so recording threads
+don't slow each other down; full buffers are written to the file as one block. Replaying loads the
+whole journal first and then runs the calls back to back, in the order they were recorded, through
+the regular wrappers of the given commands.
+
+Calls made while a journal is being stopped may be missed. The file is only complete once
+stop_command_journal() returns.
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "function_finder/function_finder.hpp"
+
+/// <summary>
+/// The first bytes of every journal file.
+/// </summary>
+inline constexpr std::string_view COMMAND_JOURNAL_MAGIC = "FFJRNL01";
+
+/// <summary>
+/// Size of each thread's journal buffer. A thread writes to the file once per this many bytes of
+/// recorded calls.
+/// </summary>
+inline constexpr size_t JOURNAL_THREAD_BUFFER_SIZE = 64 * 1024;
+
+/// <summary>
+/// The blocks a journal file is made of, after the magic bytes. Every block is its type byte, its
+/// size as a varint and that many bytes of content.
+/// </summary>
+enum class Journal_Block : uint8_t
+{
+	/// <summary>
+	/// Names a command id: the id as a varint, then the name. Written before any call of the
+	/// command.
+	/// </summary>
+	COMMAND_NAME = 'N',
+
+	/// <summary>
+	/// Calls recorded by one thread. Each call is the command id, the nanoseconds since the journal
+	/// started and the number of arguments as varints, followed by the arguments. Each argument is
+	/// its \ref Value_Type as a byte and its value: integers as zigzag varints, floats and doubles
+	/// as their little endian bytes, bools as a byte, and strings and lists as their length as a
+	/// varint followed by the characters or elements.
+	/// </summary>
+	CALLS = 'C'
+};
+
+/// <summary>
+/// Recorded calls of one thread that haven't been written to the file yet. Only the owning thread
+/// appends, and only while holding the registry mutex does anyone write its contents out.
+/// </summary>
+struct Journal_Thread_Buffer
+{
+	std::unique_ptr<char[]> data = std::make_unique<char[]>(JOURNAL_THREAD_BUFFER_SIZE);
+
+	/// <summary>
+	/// Bytes of complete calls in data. Only changed by the owning thread, and published with
+	/// release so other threads can write them out.
+	/// </summary>
+	std::atomic<size_t> committed{ 0 };
+
+	/// <summary>
+	/// Bytes already written to the file, or discarded. Guarded by the registry mutex.
+	/// </summary>
+	size_t flushed = 0;
+
+	/// <summary>
+	/// The call being encoded. Only touched by the owning thread, and kept to reuse its capacity.
+	/// </summary>
+	std::string record;
+};
+
+/// <summary>
+/// Global bookkeeping for the journal. Owns the per-thread buffers, and hands the buffers of
+/// threads that exited on to new threads, so programs starting threads over and over keep a
+/// buffer per running thread rather than per thread ever started. The mutex is only taken when
+/// registering commands, when threads start or exit, when a buffer is written to the file, and
+/// when starting or stopping.
+/// </summary>
+struct Command_Journal_Registry
+{
+	std::mutex mutex;
+	std::vector<std::string> names;
+	std::vector<std::unique_ptr<Journal_Thread_Buffer>> thread_buffers;
+
+	/// <summary>
+	/// Buffers of exited threads, empty and ready for new ones.
+	/// </summary>
+	std::vector<Journal_Thread_Buffer *> free_buffers;
+
+	std::ofstream file;
+	uint64_t bytes_written = 0;
+
+	/// <summary>
+	/// Whether wrappers record their calls. Checked before anything else, so calls cost a single
+	/// load while no journal is recorded.
+	/// </summary>
+	std::atomic<bool> recording{ false };
+
+	/// <summary>
+	/// steady_clock time the journal was started at, in nanoseconds.
+	/// </summary>
+	std::atomic<int64_t> start_time{ 0 };
+
+	/// <summary>
+	/// Writes what's left in the buffers, so journals that are never stopped still end up complete
+	/// when the program exits normally.
+	/// </summary>
+	~Command_Journal_Registry()
+	{
+		std::lock_guard lock(mutex);
+		flush_thread_buffers();
+	}
+
+	/// <summary>
+	/// Appends a block to the file, if one is open. The mutex must be held.
+	/// </summary>
+	void write_block(Journal_Block type, const char *content, size_t size)
+	{
+		if (!file.is_open() || size == 0)
+		{
+			return;
+		}
+
+		char header[11];
+		header[0] = (char)type;
+		size_t header_size = 1;
+		for (uint64_t value = size; ; value >>= 7)
+		{
+			header[header_size++] = (char)((value & 0x7f) | (value >= 0x80 ? 0x80 : 0));
+			if (value < 0x80)
+			{
+				break;
+			}
+		}
+		file.write(header, (std::streamsize)header_size);
+		file.write(content, (std::streamsize)size);
+		bytes_written += header_size + size;
+	}
+
+	/// <summary>
+	/// Writes the calls every thread has committed so far. The mutex must be held.
+	/// </summary>
+	void flush_thread_buffers()
+	{
+		for (auto &buffer : thread_buffers)
+		{
+			size_t committed = buffer->committed.load(std::memory_order_acquire);
+			write_block(Journal_Block::CALLS, buffer->data.get() + buffer->flushed,
+				committed - buffer->flushed);
+			buffer->flushed = committed;
+		}
+		if (file.is_open())
+		{
+			file.flush();
+		}
+	}
+};
+
+inline Command_Journal_Registry &get_command_journal_registry()
+{
+	static Command_Journal_Registry registry;
+	return registry;
+}
+
+/// <summary>
+/// Appends an unsigned LEB128 varint: 7 bits per byte, lowest first.
+/// </summary>
+inline void write_journal_varint(std::string &out, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((char)((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	out.push_back((char)value);
+}
+
+inline void write_journal_bytes(std::string &out, const void *data, size_t size)
+{
+	out.append((const char *)data, size);
+}
+
+/// <summary>
+/// Zigzag encodes an integer, so small negative numbers make small varints too.
+/// </summary>
+inline uint64_t to_journal_zigzag(int value)
+{
+	return ((uint32_t)value << 1) ^ (value < 0 ? 0xffffffffu : 0u);
+}
+
+inline int from_journal_zigzag(uint64_t bits)
+{
+	return (int)(uint32_t)((bits >> 1) ^ (~(bits & 1) + 1));
+}
+
+// The encoding of each argument type, see \ref Journal_Block::CALLS.
+
+inline void write_journal_value(std::string &out, int value)
+{
+	out.push_back((char)Value_Type::INTEGER);
+	write_journal_varint(out, to_journal_zigzag(value));
+}
+
+inline void write_journal_value(std::string &out, float value)
+{
+	out.push_back((char)Value_Type::FLOAT);
+	write_journal_bytes(out, &value, sizeof(value));
+}
+
+inline void write_journal_value(std::string &out, double value)
+{
+	out.push_back((char)Value_Type::DOUBLE);
+	write_journal_bytes(out, &value, sizeof(value));
+}
+
+inline void write_journal_value(std::string &out, bool value)
+{
+	out.push_back((char)Value_Type::BOOLEAN);
+	out.push_back(value ? 1 : 0);
+}
+
+inline void write_journal_value(std::string &out, const std::string &value)
+{
+	out.push_back((char)Value_Type::STRING);
+	write_journal_varint(out, value.size());
+	out += value;
+}
+
+template <typename T>
+inline void write_journal_value(std::string &out, const std::vector<T> &values)
+{
+	Value_Type type = std::is_same_v<T, int> ? Value_Type::INTEGER_ARRAY :
+		std::is_same_v<T, float> ? Value_Type::FLOAT_ARRAY : Value_Type::DOUBLE_ARRAY;
+	out.push_back((char)type);
+	write_journal_varint(out, values.size());
+	for (T value : values)
+	{
+		if constexpr (std::is_same_v<T, int>)
+		{
+			write_journal_varint(out, to_journal_zigzag(value));
+		}
+		else
+		{
+			write_journal_bytes(out, &value, sizeof(value));
+		}
+	}
+}
+
+/// <summary>
+/// Registers a command for the journal and returns its dense id. Called once per generated
+/// wrapper, the first time it runs. Registering the same name twice returns the same id.
+/// </summary>
+inline uint32_t register_journal_command(std::string_view name)
+{
+	auto &registry = get_command_journal_registry();
+	std::lock_guard lock(registry.mutex);
+
+	for (size_t i = 0; i < registry.names.size(); i++)
+	{
+		if (registry.names[i] == name)
+		{
+			return (uint32_t)i;
+		}
+	}
+
+	uint32_t id = (uint32_t)registry.names.size();
+	registry.names.emplace_back(name);
+
+	// The name goes out before any call of the command can.
+	std::string block;
+	write_journal_varint(block, id);
+	block += name;
+	registry.write_block(Journal_Block::COMMAND_NAME, block.data(), block.size());
+	return id;
+}
+
+/// <summary>
+/// Holds a thread's journal buffer while the thread runs. When the thread exits, its calls are
+/// written to the file and the buffer goes back to the registry for the next thread.
+/// </summary>
+struct Journal_Thread_Buffer_Owner
+{
+	Journal_Thread_Buffer *buffer = nullptr;
+
+	Journal_Thread_Buffer_Owner()
+	{
+		auto &registry = get_command_journal_registry();
+		std::lock_guard lock(registry.mutex);
+		if (!registry.free_buffers.empty())
+		{
+			buffer = registry.free_buffers.back();
+			registry.free_buffers.pop_back();
+		}
+		else
+		{
+			registry.thread_buffers.push_back(std::make_unique<Journal_Thread_Buffer>());
+			buffer = registry.thread_buffers.back().get();
+		}
+	}
+
+	~Journal_Thread_Buffer_Owner()
+	{
+		auto &registry = get_command_journal_registry();
+		std::lock_guard lock(registry.mutex);
+		size_t committed = buffer->committed.load(std::memory_order_relaxed);
+		registry.write_block(Journal_Block::CALLS, buffer->data.get() + buffer->flushed,
+			committed - buffer->flushed);
+		buffer->flushed = 0;
+		buffer->committed.store(0, std::memory_order_relaxed);
+		registry.free_buffers.push_back(buffer);
+	}
+
+	Journal_Thread_Buffer_Owner(const Journal_Thread_Buffer_Owner &) = delete;
+	Journal_Thread_Buffer_Owner &operator=(const Journal_Thread_Buffer_Owner &) = delete;
+};
+
+/// <summary>
+/// Returns the journal buffer of the calling thread, taking one if needed.
+/// </summary>
+inline Journal_Thread_Buffer &get_thread_journal_buffer()
+{
+	thread_local Journal_Thread_Buffer_Owner owner;
+	return *owner.buffer;
+}
+
+/// <summary>
+/// Writes the calling thread's buffer to the file and empties it. Records that don't fit in a
+/// buffer at all are written as a block of their own.
+/// </summary>
+FUNCTION_FINDER_COLD FUNCTION_FINDER_NOINLINE inline void flush_thread_journal_buffer(Journal_Thread_Buffer &buffer,
+	std::string_view oversized_record = {})
+{
+	auto &registry = get_command_journal_registry();
+	std::lock_guard lock(registry.mutex);
+
+	size_t committed = buffer.committed.load(std::memory_order_relaxed);
+	registry.write_block(Journal_Block::CALLS, buffer.data.get() + buffer.flushed,
+		committed - buffer.flushed);
+	registry.write_block(Journal_Block::CALLS, oversized_record.data(), oversized_record.size());
+
+	// Other threads only read the buffer while holding the mutex, so it can be reused right away.
+	buffer.flushed = 0;
+	buffer.committed.store(0, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Records a call of a command, with its parsed arguments. Called by wrappers generated with
+/// '--journal'. Does nothing unless a journal is being recorded.
+/// </summary>
+template <typename... Args>
+inline void record_journal_call(uint32_t command_id, const Args &...args)
+{
+	auto &registry = get_command_journal_registry();
+	if (!registry.recording.load(std::memory_order_acquire))
+	{
+		return;
+	}
+
+	int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	int64_t elapsed = std::max<int64_t>(now - registry.start_time.load(std::memory_order_relaxed), 0);
+
+	Journal_Thread_Buffer &buffer = get_thread_journal_buffer();
+	std::string &record = buffer.record;
+	record.clear();
+	write_journal_varint(record, command_id);
+	write_journal_varint(record, (uint64_t)elapsed);
+	write_journal_varint(record, sizeof...(Args));
+	(write_journal_value(record, args), ...);
+
+	size_t committed = buffer.committed.load(std::memory_order_relaxed);
+	if (committed + record.size() > JOURNAL_THREAD_BUFFER_SIZE) [[unlikely]]
+	{
+		if (record.size() > JOURNAL_THREAD_BUFFER_SIZE)
+		{
+			flush_thread_journal_buffer(buffer, record);
+			return;
+		}
+		flush_thread_journal_buffer(buffer);
+		committed = 0;
+	}
+
+	std::memcpy(buffer.data.get() + committed, record.data(), record.size());
+	buffer.committed.store(committed + record.size(), std::memory_order_release);
+}
+
+/// <summary>
+/// Starts recording calls to a new journal at path, replacing any file there. Commands that were
+/// registered before are named in the journal right away, the others when they first run.
+/// </summary>
+/// <returns>False if a journal is already being recorded or the file can't be opened. The errors
+/// are printed.</returns>
+inline bool start_command_journal(const std::string &path)
+{
+	auto &registry = get_command_journal_registry();
+	std::lock_guard lock(registry.mutex);
+
+	if (registry.file.is_open())
+	{
+		std::cerr << "[ERROR] A command journal is already being recorded. Stop it first\n";
+		return false;
+	}
+
+	registry.file.open(path, std::ios::binary | std::ios::trunc);
+	if (!registry.file.is_open())
+	{
+		std::cerr << std::format("[ERROR] Could not open command journal \"{}\" for writing\n", path);
+		return false;
+	}
+	registry.file.write(COMMAND_JOURNAL_MAGIC.data(), (std::streamsize)COMMAND_JOURNAL_MAGIC.size());
+	registry.bytes_written = COMMAND_JOURNAL_MAGIC.size();
+
+	for (size_t i = 0; i < registry.names.size(); i++)
+	{
+		std::string block;
+		write_journal_varint(block, i);
+		block += registry.names[i];
+		registry.write_block(Journal_Block::COMMAND_NAME, block.data(), block.size());
+	}
+
+	// Calls that raced with stopping the previous journal don't belong in this one.
+	for (auto &buffer : registry.thread_buffers)
+	{
+		buffer->flushed = buffer->committed.load(std::memory_order_acquire);
+	}
+
+	registry.start_time.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_relaxed);
+	registry.recording.store(true, std::memory_order_release);
+	return true;
+}
+
+/// <summary>
+/// Writes all calls recorded so far to the file, without stopping. Lets long recordings survive a
+/// crash up to the last flush.
+/// </summary>
+inline void flush_command_journal()
+{
+	auto &registry = get_command_journal_registry();
+	std::lock_guard lock(registry.mutex);
+	registry.flush_thread_buffers();
+}
+
+/// <summary>
+/// Stops recording, writes the remaining calls and closes the journal.
+/// </summary>
+/// <returns>The size of the journal file in bytes, or 0 if none was being recorded.</returns>
+inline uint64_t stop_command_journal()
+{
+	auto &registry = get_command_journal_registry();
+	std::lock_guard lock(registry.mutex);
+	if (!registry.file.is_open())
+	{
+		return 0;
+	}
+
+	registry.recording.store(false, std::memory_order_relaxed);
+	registry.flush_thread_buffers();
+	registry.file.close();
+	return registry.bytes_written;
+}
+
+/// <summary>
+/// Whether a journal is being recorded.
+/// </summary>
+inline bool is_command_journal_recording()
+{
+	return get_command_journal_registry().recording.load(std::memory_order_relaxed);
+}
+
+/// <summary>
+/// One call loaded from a journal, with its arguments converted back to text.
+/// </summary>
+struct Journal_Call
+{
+	/// <summary>
+	/// Nanoseconds since the journal started.
+	/// </summary>
+	uint64_t time = 0;
+
+	const Function_Decl *command = nullptr;
+	std::vector<std::string> args;
+};
+
+/// <summary>
+/// What \ref replay_command_journal did, and how fast.
+/// </summary>
+struct Journal_Replay_Stats
+{
+	/// <summary>
+	/// Calls that ran, and how many of them failed.
+	/// </summary>
+	uint64_t calls = 0;
+	uint64_t failed_calls = 0;
+
+	/// <summary>
+	/// Calls of commands that aren't in the replaying program.
+	/// </summary>
+	uint64_t skipped_calls = 0;
+
+	/// <summary>
+	/// Size of the journal file.
+	/// </summary>
+	uint64_t bytes = 0;
+
+	/// <summary>
+	/// Time from the journal's start to its last call, when it was recorded.
+	/// </summary>
+	std::chrono::nanoseconds recorded_time{ 0 };
+
+	/// <summary>
+	/// Time spent reading and decoding the journal, and running the calls.
+	/// </summary>
+	std::chrono::nanoseconds load_time{ 0 };
+	std::chrono::nanoseconds replay_time{ 0 };
+};
+
+/// <summary>
+/// Reads a varint from the front of source and advances past it.
+/// </summary>
+/// <returns>False if source ends in the middle of it.</returns>
+inline bool read_journal_varint(std::string_view &source, uint64_t &out_value)
+{
+	out_value = 0;
+	for (size_t i = 0; i < source.size() && i < 10; i++)
+	{
+		out_value |= (uint64_t)(source[i] & 0x7f) << (7 * i);
+		if (!(source[i] & 0x80))
+		{
+			source.remove_prefix(i + 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+/// <summary>
+/// Reads a fixed size value from the front of source and advances past it.
+/// </summary>
+template <typename T>
+inline bool read_journal_bytes(std::string_view &source, T &out_value)
+{
+	if (source.size() < sizeof(T))
+	{
+		return false;
+	}
+	std::memcpy(&out_value, source.data(), sizeof(T));
+	source.remove_prefix(sizeof(T));
+	return true;
+}
+
+/// <summary>
+/// Appends a number as text that the argument parsers read back as exactly the same value.
+/// </summary>
+template <typename T>
+inline void append_journal_number(std::string &out, T value)
+{
+	// The parsers don't read exponents, so floating point numbers are written in full.
+	char text[512];
+	std::to_chars_result result;
+	if constexpr (std::is_floating_point_v<T>)
+	{
+		result = std::to_chars(text, text + sizeof(text), value, std::chars_format::fixed);
+	}
+	else
+	{
+		result = std::to_chars(text, text + sizeof(text), value);
+	}
+	out.append(text, result.ptr);
+}
+
+/// <summary>
+/// Reads an argument from the front of source, advances past it, and converts it to the text the
+/// wrappers parse.
+/// </summary>
+/// <returns>False if the argument is cut off or has an unknown type.</returns>
+inline bool read_journal_argument(std::string_view &source, std::string &out_text)
+{
+	if (source.empty())
+	{
+		return false;
+	}
+	Value_Type type = (Value_Type)source[0];
+	source.remove_prefix(1);
+
+	auto read_int = [&source](int &out_value)
+	{
+		uint64_t bits;
+		if (!read_journal_varint(source, bits))
+		{
+			return false;
+		}
+		out_value = from_journal_zigzag(bits);
+		return true;
+	};
+
+	out_text.clear();
+	switch (type)
+	{
+	case Value_Type::INTEGER:
+	{
+		int value;
+		if (!read_int(value))
+		{
+			return false;
+		}
+		append_journal_number(out_text, value);
+		return true;
+	}
+	case Value_Type::FLOAT:
+	{
+		float value;
+		if (!read_journal_bytes(source, value))
+		{
+			return false;
+		}
+		append_journal_number(out_text, value);
+		return true;
+	}
+	case Value_Type::DOUBLE:
+	{
+		double value;
+		if (!read_journal_bytes(source, value))
+		{
+			return false;
+		}
+		append_journal_number(out_text, value);
+		return true;
+	}
+	case Value_Type::BOOLEAN:
+	{
+		uint8_t value;
+		if (!read_journal_bytes(source, value))
+		{
+			return false;
+		}
+		out_text = value ? "true" : "false";
+		return true;
+	}
+	case Value_Type::STRING:
+	{
+		uint64_t size;
+		if (!read_journal_varint(source, size) || size > source.size())
+		{
+			return false;
+		}
+		out_text.assign(source.data(), size);
+		source.remove_prefix(size);
+		return true;
+	}
+	case Value_Type::INTEGER_ARRAY:
+	case Value_Type::FLOAT_ARRAY:
+	case Value_Type::DOUBLE_ARRAY:
+	{
+		uint64_t count;
+		if (!read_journal_varint(source, count))
+		{
+			return false;
+		}
+		for (uint64_t i = 0; i < count; i++)
+		{
+			if (i > 0)
+			{
+				out_text += ',';
+			}
+
+			// Elements are only printed once they were read completely.
+			if (type == Value_Type::INTEGER_ARRAY)
+			{
+				int value;
+				if (!read_int(value))
+				{
+					return false;
+				}
+				append_journal_number(out_text, value);
+			}
+			else if (type == Value_Type::FLOAT_ARRAY)
+			{
+				float value;
+				if (!read_journal_bytes(source, value))
+				{
+					return false;
+				}
+				append_journal_number(out_text, value);
+			}
+			else
+			{
+				double value;
+				if (!read_journal_bytes(source, value))
+				{
+					return false;
+				}
+				append_journal_number(out_text, value);
+			}
+		}
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+/// <summary>
+/// Reads a journal and matches its calls to commands, sorted by the time they were recorded. Calls
+/// of commands that aren't in commands are counted in out_stats.skipped_calls and left out. A
+/// journal that was cut off, by a crash for example, loads up to the last complete block.
+/// </summary>
+/// <returns>False if the file can't be read or isn't a journal. The errors are printed.</returns>
+inline bool load_command_journal(const std::string &path, const Function_Map &commands,
+	std::vector<Journal_Call> &out_calls, Journal_Replay_Stats &out_stats)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << std::format("[ERROR] Could not open command journal \"{}\"\n", path);
+		return false;
+	}
+	std::string contents{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+	out_stats.bytes = contents.size();
+
+	std::string_view source = contents;
+	if (!source.starts_with(COMMAND_JOURNAL_MAGIC))
+	{
+		std::cerr << std::format("[ERROR] \"{}\" is not a command journal\n", path);
+		return false;
+	}
+	source.remove_prefix(COMMAND_JOURNAL_MAGIC.size());
+
+	// Journal ids to commands. Commands missing from this program stay nullptr.
+	std::vector<const Function_Decl *> id_commands;
+	std::vector<bool> id_named;
+	uint64_t last_time = 0;
+
+	while (!source.empty())
+	{
+		size_t offset = contents.size() - source.size();
+		Journal_Block type = (Journal_Block)source[0];
+		source.remove_prefix(1);
+
+		uint64_t size;
+		if (!read_journal_varint(source, size) || size > source.size())
+		{
+			std::cerr << std::format("[ERROR] Command journal \"{}\" is cut off after {} bytes, only loading "
+				"the calls before that\n", path, offset);
+			break;
+		}
+		std::string_view block = source.substr(0, size);
+		source.remove_prefix(size);
+
+		if (type == Journal_Block::COMMAND_NAME)
+		{
+			uint64_t id;
+			if (!read_journal_varint(block, id) || id > UINT32_MAX)
+			{
+				std::cerr << std::format("[ERROR] Command journal \"{}\" has a broken block at byte {}\n",
+					path, offset);
+				return false;
+			}
+			if (id >= id_commands.size())
+			{
+				id_commands.resize(id + 1, nullptr);
+				id_named.resize(id + 1, false);
+			}
+			auto found = commands.find(std::string(block));
+			id_commands[id] = found != commands.end() ? &found->second : nullptr;
+			id_named[id] = true;
+			continue;
+		}
+
+		if (type != Journal_Block::CALLS)
+		{
+			std::cerr << std::format("[ERROR] Command journal \"{}\" has an unknown block at byte {}\n",
+				path, offset);
+			return false;
+		}
+
+		while (!block.empty())
+		{
+			Journal_Call call;
+			uint64_t id, count;
+			bool success = read_journal_varint(block, id) && id < id_named.size() && id_named[id] &&
+				read_journal_varint(block, call.time) && read_journal_varint(block, count);
+			for (uint64_t i = 0; success && i < count; i++)
+			{
+				success = read_journal_argument(block, call.args.emplace_back());
+			}
+			if (!success)
+			{
+				std::cerr << std::format("[ERROR] Command journal \"{}\" has a broken call in the block at "
+					"byte {}\n", path, offset);
+				return false;
+			}
+
+			last_time = std::max(last_time, call.time);
+			call.command = id_commands[id];
+			if (!call.command)
+			{
+				out_stats.skipped_calls++;
+				continue;
+			}
+			out_calls.push_back(std::move(call));
+		}
+	}
+
+	// Every thread wrote its own blocks, so calls from different threads are interleaved.
+	std::stable_sort(out_calls.begin(), out_calls.end(), [](const Journal_Call &a, const Journal_Call &b)
+		{ return a.time < b.time; });
+	out_stats.recorded_time = std::chrono::nanoseconds(last_time);
+	return true;
+}
+
+/// <summary>
+/// Runs all calls in a journal through the given commands, one after the other on the calling
+/// thread, as fast as possible. Asynchronous commands are waited for.
+/// </summary>
+/// <returns>False if the journal can't be loaded, see \ref load_command_journal. Failing calls
+/// don't stop the replay, they're counted in out_stats.failed_calls.</returns>
+inline bool replay_command_journal(const std::string &path, const Function_Map &commands,
+	Journal_Replay_Stats &out_stats)
+{
+	out_stats = {};
+	auto load_start = std::chrono::steady_clock::now();
+	std::vector<Journal_Call> calls;
+	if (!load_command_journal(path, commands, calls, out_stats))
+	{
+		return false;
+	}
+
+	auto replay_start = std::chrono::steady_clock::now();
+	for (Journal_Call &call : calls)
+	{
+		Call_Result result = call.command->function(call.args, true);
+		if (result.status != Call_Result_Status::SUCCESS)
+		{
+			out_stats.failed_calls++;
+		}
+	}
+	auto replay_end = std::chrono::steady_clock::now();
+
+	out_stats.calls = calls.size();
+	out_stats.load_time = replay_start - load_start;
+	out_stats.replay_time = replay_end - replay_start;
+	return true;
+}
+
+/// <summary>
+/// Summary of a replay, with its throughput.
+/// </summary>
+inline std::string to_string(const Journal_Replay_Stats &stats)
+{
+	double replay_seconds = std::chrono::duration<double>(stats.replay_time).count();
+	double load_seconds = std::chrono::duration<double>(stats.load_time).count();
+	return std::format("Replayed {} calls ({} failed, {} skipped) in {:.3f} ms: {:.0f} calls/s. Loading "
+		"{} bytes took {:.3f} ms ({:.1f} MB/s). The calls were recorded over {:.3f} s",
+		stats.calls, stats.failed_calls, stats.skipped_calls, replay_seconds * 1e3,
+		replay_seconds > 0 ? (double)stats.calls / replay_seconds : 0.0, stats.bytes, load_seconds * 1e3,
+		load_seconds > 0 ? (double)stats.bytes / load_seconds / 1e6 : 0.0,
+		std::chrono::duration<double>(stats.recorded_time).count());
+}
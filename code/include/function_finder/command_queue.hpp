@@ -0,0 +1,274 @@
+/*
+A queue for running commands on one thread, like a game's main thread, while any thread submits
+them. Producers never take a lock or wait for each other, and the consuming thread runs the queued
+commands at a point of its choosing, spending at most a given amount of time per drain:
+
+    Command_Queue queue(commands);
+
+    // Any thread
+    queue.submit("spawn", { "orc", "3" }, [](Call_Result &result) { ... });
+
+    // Main thread, once per frame
+    queue.drain(std::chrono::milliseconds(2));
+
+Completion callbacks run on the draining thread, right after their command. Commands that didn't
+fit in the budget stay queued, in order, for the next drain. Asynchronous commands are started by
+the drain and their callback runs in the first drain after they finish, so they never block it.
+*/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "function_finder/function_finder.hpp"
+#include "function_finder/command_task.hpp"
+
+/// <summary>
+/// Called with the result of a queued command, on the thread draining the queue. The result may be
+/// moved out of.
+/// </summary>
+using Command_Completion = std::function<void(Call_Result &result)>;
+
+/// <summary>
+/// A command waiting in a \ref Command_Queue. Producers allocate it, the consumer frees it after
+/// running it.
+/// </summary>
+struct Queued_Command
+{
+	std::atomic<Queued_Command *> next{ nullptr };
+
+	Function_Wrapper function = nullptr;
+
+	/// <summary>
+	/// Preferred over function when set, see '--task-type'.
+	/// </summary>
+	Async_Function_Wrapper async_function = nullptr;
+
+	std::vector<std::string> args;
+	Command_Completion on_complete;
+};
+
+/// <summary>
+/// Multi-producer, single-consumer command queue. Any number of threads may call \ref submit at
+/// the same time, but only one thread at a time may call \ref drain.
+/// </summary>
+/// <details>
+/// An intrusive linked list after Dmitry Vyukov's MPSC queue: submitting is one atomic exchange
+/// on the head, so producers never retry, and the consumer pops from the tail without any atomic
+/// read-modify-write. A submit that has exchanged the head but not linked its node yet briefly
+/// hides the commands behind it from the consumer, which then just picks them up on the next
+/// drain.
+/// </details>
+class Command_Queue
+{
+private:
+	const Function_Map &commands;
+
+	/// <summary>
+	/// The most recently submitted node. Shared by all producers.
+	/// </summary>
+	alignas(64) std::atomic<Queued_Command *> head;
+
+	/// <summary>
+	/// The oldest node, which is popped next. Only touched by the consumer.
+	/// </summary>
+	alignas(64) Queued_Command *tail;
+
+	/// <summary>
+	/// Placeholder node, so the list is never empty and producers never touch the tail.
+	/// </summary>
+	Queued_Command stub;
+
+	/// <summary>
+	/// Asynchronous commands that were started but haven't finished. Only touched by the consumer.
+	/// </summary>
+	std::vector<std::pair<Call_Task, Command_Completion>> running;
+
+public:
+	/// <summary>
+	/// The commands are only read, from all producing threads, so they mustn't change while the
+	/// queue is used.
+	/// </summary>
+	explicit Command_Queue(const Function_Map &commands)
+		: commands(commands), head(&stub), tail(&stub)
+	{
+	}
+
+	Command_Queue(const Command_Queue &) = delete;
+	Command_Queue &operator=(const Command_Queue &) = delete;
+
+	/// <summary>
+	/// Drops the commands that haven't run yet, without calling their callbacks. Asynchronous
+	/// commands that are still running keep running, but their callbacks aren't called either.
+	/// </summary>
+	~Command_Queue()
+	{
+		while (Queued_Command *command = pop())
+		{
+			delete command;
+		}
+	}
+
+	/// <summary>
+	/// Queues a call of the command with the given name. Thread safe.
+	/// </summary>
+	/// <returns>False if there's no command with that name, in which case nothing is queued.</returns>
+	bool submit(const std::string &name, std::vector<std::string> args, Command_Completion on_complete = {})
+	{
+		auto found = commands.find(name);
+		if (found == commands.end())
+		{
+			return false;
+		}
+
+		push(new Queued_Command{ {}, found->second.function, found->second.async_function,
+			std::move(args), std::move(on_complete) });
+		return true;
+	}
+
+	/// <summary>
+	/// Queues a call of the command with the given id, see '--command-ids'. Thread safe, and
+	/// doesn't look up the name.
+	/// </summary>
+	template <typename Id>
+		requires std::is_enum_v<Id>
+	void submit(Id id, std::vector<std::string> args, Command_Completion on_complete = {})
+	{
+		const Command_Info &info = get_command_info(id);
+		push(new Queued_Command{ {}, info.function, info.async_function, std::move(args),
+			std::move(on_complete) });
+	}
+
+	/// <summary>
+	/// Runs queued commands in submission order until the queue is empty or the budget is spent,
+	/// and completes the asynchronous commands that finished since the last drain. At least one
+	/// command runs per drain, so a budget shorter than a command doesn't stall the queue. Only call
+	/// from one thread at a time.
+	/// </summary>
+	/// <returns>The number of commands whose callback was called.</returns>
+	size_t drain(std::chrono::nanoseconds budget)
+	{
+		auto deadline = std::chrono::steady_clock::now() + budget;
+		size_t completed = complete_finished_commands();
+
+		bool first = true;
+		while (first || std::chrono::steady_clock::now() < deadline)
+		{
+			Queued_Command *command = pop();
+			if (!command)
+			{
+				break;
+			}
+			first = false;
+
+			if (command->async_function)
+			{
+				running.emplace_back(command->async_function(std::move(command->args), true),
+					std::move(command->on_complete));
+			}
+			else
+			{
+				Call_Result result = command->function(command->args, true);
+				if (command->on_complete)
+				{
+					command->on_complete(result);
+				}
+				completed++;
+			}
+			delete command;
+		}
+		return completed;
+	}
+
+	/// <summary>
+	/// Number of asynchronous commands started by a drain that haven't completed yet. Only call
+	/// from the draining thread.
+	/// </summary>
+	size_t get_running_count() const
+	{
+		return running.size();
+	}
+
+private:
+	void push(Queued_Command *command)
+	{
+		command->next.store(nullptr, std::memory_order_relaxed);
+		Queued_Command *previous = head.exchange(command, std::memory_order_acq_rel);
+		previous->next.store(command, std::memory_order_release);
+	}
+
+	/// <summary>
+	/// Returns the oldest command, or nullptr if there's none or the oldest one is still being
+	/// linked in by its producer.
+	/// </summary>
+	Queued_Command *pop()
+	{
+		Queued_Command *current = tail;
+		Queued_Command *next = current->next.load(std::memory_order_acquire);
+
+		// Skip the stub.
+		if (current == &stub)
+		{
+			if (!next)
+			{
+				return nullptr;
+			}
+			tail = next;
+			current = next;
+			next = next->next.load(std::memory_order_acquire);
+		}
+
+		if (next)
+		{
+			tail = next;
+			return current;
+		}
+
+		// current is the last node. A producer is linking a newer one in, try again later.
+		if (current != head.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+
+		// Put the stub back behind current, so current can be handed out.
+		push(&stub);
+		next = current->next.load(std::memory_order_acquire);
+		if (next)
+		{
+			tail = next;
+			return current;
+		}
+		return nullptr;
+	}
+
+	size_t complete_finished_commands()
+	{
+		size_t completed = 0;
+		for (size_t i = 0; i < running.size();)
+		{
+			auto &[task, on_complete] = running[i];
+			if (!task.is_ready())
+			{
+				i++;
+				continue;
+			}
+
+			Call_Result result = task.wait();
+			if (on_complete)
+			{
+				on_complete(result);
+			}
+			completed++;
+
+			// Order doesn't matter, they completed whenever they completed.
+			running[i] = std::move(running.back());
+			running.pop_back();
+		}
+		return completed;
+	}
+};
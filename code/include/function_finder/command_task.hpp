@@ -0,0 +1,292 @@
+/*
+Runtime support for asynchronous commands. Client functions returning the task type given with
+'--task-type' are coroutines, and their generated wrappers are coroutines too: calling one parses
+the arguments, starts the client function and returns a \ref Call_Task right away, which completes
+with the \ref Call_Result once the client function finishes. Nothing blocks the calling thread.
+
+Command_Task can also be used as the client-side task type, for consumers that don't have a
+coroutine library of their own: '--task-type=Command_Task'. Any other task type works as long as
+the generated wrapper can co_await it.
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "function_finder/function_finder.hpp"
+
+/// <summary>
+/// Marks a finished task in \ref Command_Task_Promise_Base::state. A fixed value rather than the
+/// address of a static, so tasks finished in a shared library with its own copy of this header,
+/// see "function_finder/hot_reload.hpp", are recognized too. Coroutine frames are aligned, so no
+/// awaiting coroutine has this address.
+/// </summary>
+inline void *command_task_completed_state()
+{
+	return reinterpret_cast<void *>(std::uintptr_t{ 1 });
+}
+
+/// <summary>
+/// Marks a task whose owner was destroyed before it finished. The coroutine frees itself.
+/// </summary>
+inline void *command_task_detached_state()
+{
+	return reinterpret_cast<void *>(std::uintptr_t{ 2 });
+}
+
+/// <summary>
+/// Coroutine that starts immediately and frees itself when done. Used to wait for a task from
+/// outside a coroutine.
+/// </summary>
+struct Detached_Coroutine
+{
+	struct promise_type
+	{
+		Detached_Coroutine get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+/// <summary>
+/// The state every task promise shares, regardless of the result type.
+/// </summary>
+struct Command_Task_Promise_Base
+{
+	/// <summary>
+	/// nullptr while running, the address of the awaiting coroutine once someone awaits the task,
+	/// or one of the command_task_*_state() markers. Atomic since tasks can finish on any thread.
+	/// </summary>
+	std::atomic<void *> state{ nullptr };
+
+	std::exception_ptr exception;
+
+	std::suspend_never initial_suspend() noexcept { return {}; }
+
+	/// <summary>
+	/// Resumes the awaiting coroutine, if any, or frees the coroutine if its task was destroyed.
+	/// </summary>
+	template <typename Promise>
+	struct Final_Awaiter
+	{
+		bool await_ready() noexcept { return false; }
+
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+		{
+			void *previous = handle.promise().state.exchange(command_task_completed_state(),
+				std::memory_order_acq_rel);
+			if (previous == command_task_detached_state())
+			{
+				handle.destroy();
+				return std::noop_coroutine();
+			}
+			if (previous)
+			{
+				return std::coroutine_handle<>::from_address(previous);
+			}
+			return std::noop_coroutine();
+		}
+
+		void await_resume() noexcept {}
+	};
+
+	void unhandled_exception()
+	{
+		exception = std::current_exception();
+	}
+};
+
+template <typename T>
+struct Command_Task_Promise : Command_Task_Promise_Base
+{
+	std::optional<T> result;
+
+	void return_value(T value)
+	{
+		result.emplace(std::move(value));
+	}
+
+	T take_result()
+	{
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+		return std::move(*result);
+	}
+};
+
+template <>
+struct Command_Task_Promise<void> : Command_Task_Promise_Base
+{
+	void return_void() {}
+
+	void take_result()
+	{
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+	}
+};
+
+/// <summary>
+/// An eagerly started coroutine producing a T. Await it with co_await from another coroutine,
+/// poll it with \ref is_ready, or block on it with \ref wait. The result can be taken once.
+/// </summary>
+/// <details>
+/// Destroying a task that hasn't finished detaches it: the coroutine keeps running and frees
+/// itself at the end. Exceptions thrown by the coroutine are rethrown to whoever takes the result.
+/// Destroying a coroutine while it awaits a task that can finish on another thread at the same
+/// time is unsupported: the task may resume the coroutine while it's being destroyed.
+/// </details>
+template <typename T>
+class Command_Task
+{
+public:
+	struct promise_type : Command_Task_Promise<T>
+	{
+		Command_Task get_return_object()
+		{
+			return Command_Task(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+
+		Command_Task_Promise_Base::Final_Awaiter<promise_type> final_suspend() noexcept
+		{
+			return {};
+		}
+	};
+
+private:
+	std::coroutine_handle<promise_type> handle;
+
+	explicit Command_Task(std::coroutine_handle<promise_type> handle)
+		: handle(handle)
+	{
+	}
+
+	/// <summary>
+	/// Awaits completion without taking the result.
+	/// </summary>
+	struct Completion_Awaiter
+	{
+		std::coroutine_handle<promise_type> handle;
+
+		bool await_ready() const noexcept
+		{
+			return handle.promise().state.load(std::memory_order_acquire) ==
+				command_task_completed_state();
+		}
+
+		bool await_suspend(std::coroutine_handle<> awaiting) noexcept
+		{
+			// Fails if the task finished in the meantime, in which case we continue right away.
+			void *expected = nullptr;
+			return handle.promise().state.compare_exchange_strong(expected, awaiting.address(),
+				std::memory_order_acq_rel);
+		}
+
+		void await_resume() const noexcept {}
+	};
+
+	static Detached_Coroutine signal_when_ready(Completion_Awaiter awaiter,
+		std::promise<void> ready)
+	{
+		co_await awaiter;
+		ready.set_value();
+	}
+
+public:
+	Command_Task(Command_Task &&other) noexcept
+		: handle(std::exchange(other.handle, nullptr))
+	{
+	}
+
+	Command_Task &operator=(Command_Task &&other) noexcept
+	{
+		if (this != &other)
+		{
+			release();
+			handle = std::exchange(other.handle, nullptr);
+		}
+		return *this;
+	}
+
+	Command_Task(const Command_Task &) = delete;
+	Command_Task &operator=(const Command_Task &) = delete;
+
+	~Command_Task()
+	{
+		release();
+	}
+
+	/// <summary>
+	/// Whether the coroutine has finished and the result can be taken without waiting.
+	/// </summary>
+	bool is_ready() const
+	{
+		return Completion_Awaiter{ handle }.await_ready();
+	}
+
+	/// <summary>
+	/// Blocks until the coroutine finishes and takes its result. Deadlocks if the coroutine can
+	/// only make progress on the calling thread, prefer co_await or polling \ref is_ready there.
+	/// </summary>
+	T wait()
+	{
+		if (!is_ready())
+		{
+			std::promise<void> ready;
+			std::future<void> future = ready.get_future();
+			signal_when_ready(Completion_Awaiter{ handle }, std::move(ready));
+			future.wait();
+		}
+		return handle.promise().take_result();
+	}
+
+	auto operator co_await() noexcept
+	{
+		struct Awaiter : Completion_Awaiter
+		{
+			T await_resume()
+			{
+				return this->handle.promise().take_result();
+			}
+		};
+		return Awaiter{ { handle } };
+	}
+
+private:
+	void release()
+	{
+		if (!handle)
+		{
+			return;
+		}
+
+		// Only a finished coroutine is freed here. A running one is left to free itself, also when
+		// a coroutine awaits it: a task only goes away mid-await when the awaiting coroutine is
+		// destroyed, so it mustn't be resumed either.
+		auto &state = handle.promise().state;
+		void *current = state.load(std::memory_order_acquire);
+		while (current != command_task_completed_state())
+		{
+			if (state.compare_exchange_weak(current, command_task_detached_state(),
+				std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				handle = nullptr;
+				return;
+			}
+		}
+		handle.destroy();
+		handle = nullptr;
+	}
+};
@@ -0,0 +1,185 @@
+/*
+The Function Finder runtime as a C++20 module, for registries generated with '--module=<name>'.
+Generated modules re-export it, so consumers usually only import the registry:
+
+    import console_commands;
+
+    Function_Map commands;
+    init_console_commands(commands);
+
+The runtime headers are included into the global module fragment and their public names exported
+from there, so the module and the headers can be used side by side. Macros aren't part of a module:
+programs counting allocations still include "function_finder/allocation_tracking.hpp" in the source
+file expanding FUNCTION_FINDER_ALLOCATION_HOOKS.
+
+Built by the Function_Finder_Module CMake target, see the FUNCTION-FINDER_BUILD_MODULE option.
+
+Experimental: neither this module nor a registry generated with '--module' has been built by a
+compiler with module support yet, so both may need fixes before they compile.
+*/
+module;
+
+#include "function_finder/function_finder.hpp"
+#include "function_finder/allocation_tracking.hpp"
+#include "function_finder/instrumentation.hpp"
+#include "function_finder/command_task.hpp"
+#include "function_finder/template_wrappers.hpp"
+#include "function_finder/memoization.hpp"
+#include "function_finder/command_queue.hpp"
+#include "function_finder/script_scheduler.hpp"
+#include "function_finder/pipeline.hpp"
+#include "function_finder/command_journal.hpp"
+#include "function_finder/binary_arguments.hpp"
+#include "function_finder/hot_reload.hpp"
+
+export module function_finder;
+
+// function_finder.hpp
+export using ::Value_Type;
+export using ::is_array_type;
+export using ::Value_Data;
+export using ::Value;
+export using ::Call_Result_Status;
+export using ::Call_Result;
+export using ::set_string_value;
+export using ::Function_Wrapper;
+export using ::Call_Task;
+export using ::Async_Function_Wrapper;
+export using ::Piped_Function_Wrapper;
+export using ::Binary_Function_Wrapper;
+export using ::Function_Decl;
+export using ::Argument;
+export using ::Function_Map;
+export using ::FUNCTION_FINDER_REGISTRY_VERSION;
+export using ::command_registry_abi;
+export using ::advance;
+export using ::skip_whitespace;
+export using ::get_int;
+export using ::get_bool;
+export using ::get_quoted_string;
+export using ::get_word_length;
+export using ::get_string;
+export using ::get_symbol;
+export using ::get_number_array;
+export using ::get_int_array;
+export using ::get_float_array;
+export using ::get_double_array;
+export using ::get_double;
+export using ::get_float;
+export using ::value_type_to_cpp_type;
+export using ::value_type_to_readable_string;
+export using ::to_string;
+export using ::set_not_enough_arguments_error;
+export using ::set_argument_parsing_error;
+export using ::set_piped_value_error;
+export using ::Argument_Value;
+export using ::Argument_Descriptor;
+export using ::Command_Descriptor;
+export using ::parse_table_arguments;
+export using ::Command_Info;
+export using ::Command_Table;
+export using ::get_command_info;
+export using ::call_command;
+export using ::find_command_id;
+export using ::can_pipe_value;
+export using ::get_piped_value;
+
+// allocation_tracking.hpp
+export using ::Allocation_Counters;
+export using ::ALLOCATION_TRACKING_ENABLED;
+export using ::record_allocation;
+export using ::free_hooked_allocation;
+export using ::get_thread_allocation_counters;
+export using ::Scoped_Allocation_Counter;
+
+// instrumentation.hpp
+export using ::LATENCY_HISTOGRAM_BUCKETS;
+export using ::Call_Stats;
+export using ::Call_Stats_Registry;
+export using ::get_call_stats_registry;
+export using ::Call_Stats_Thread_Owner;
+export using ::UNTRACKED_CALL_STATS_COMMAND;
+export using ::register_call_stats_command;
+export using ::set_call_tracing_enabled;
+export using ::Instrumented_Call;
+export using ::collect_call_stats;
+export using ::reset_call_stats;
+export using ::write_chrome_trace;
+
+// command_task.hpp
+export using ::Command_Task;
+
+// template_wrappers.hpp
+export using ::Fixed_String;
+export using ::template_wrapper;
+
+// memoization.hpp
+export using ::Memo_Stats;
+export using ::Memo_Key_Hash;
+export using ::Memo_Key_Equal;
+export using ::Memo_Cache_Base;
+export using ::Memo_Cache_Registry;
+export using ::get_memo_cache_registry;
+export using ::Memo_Cache;
+export using ::invalidate_memoized_results;
+export using ::collect_memo_stats;
+
+// command_queue.hpp
+export using ::Command_Completion;
+export using ::Queued_Command;
+export using ::Command_Queue;
+
+// script_scheduler.hpp
+export using ::Script_Resources;
+export using ::Script_Command;
+export using ::Script_Command_Result;
+export using ::Script_Report;
+export using ::Script_Scheduler;
+
+// pipeline.hpp
+export using ::Pipeline_Stage;
+export using ::split_command_words;
+export using ::parse_pipeline;
+export using ::run_pipeline;
+
+// command_journal.hpp
+export using ::COMMAND_JOURNAL_MAGIC;
+export using ::JOURNAL_THREAD_BUFFER_SIZE;
+export using ::Journal_Block;
+export using ::Command_Journal_Registry;
+export using ::get_command_journal_registry;
+export using ::Journal_Thread_Buffer_Owner;
+export using ::register_journal_command;
+export using ::record_journal_call;
+export using ::start_command_journal;
+export using ::flush_command_journal;
+export using ::stop_command_journal;
+export using ::is_command_journal_recording;
+export using ::Journal_Call;
+export using ::Journal_Replay_Stats;
+export using ::load_command_journal;
+export using ::replay_command_journal;
+
+// binary_arguments.hpp
+export using ::write_binary_bytes;
+export using ::read_binary_bytes;
+export using ::binary_value_type;
+export using ::write_binary_value;
+export using ::write_binary_arguments;
+export using ::read_binary_argument;
+export using ::write_binary_result;
+export using ::read_binary_result;
+export using ::set_binary_argument_error;
+export using ::set_extra_binary_arguments_error;
+
+// hot_reload.hpp
+export using ::COMMAND_LIBRARY_REGISTER_SYMBOL;
+export using ::Register_Commands_Function;
+export using ::open_command_library;
+export using ::find_command_library_symbol;
+export using ::close_command_library;
+export using ::Loaded_Commands;
+export using ::get_thread_retired_command_versions;
+export using ::retire_command_version;
+export using ::release_retired_command_versions;
+export using ::Command_Library;
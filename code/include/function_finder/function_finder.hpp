@@ -4,13 +4,49 @@ TODO USAGE GUIDE, VERSION NUMBER ETC
 */
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
 #include <cstring>
 #include <string>
+#include <type_traits>
+#include <vector>
 #include <iostream>
 #include <format>
 #include <string_view>
 #include <unordered_map>
 
+/// <summary>
+/// Marks functions that rarely run, like the generated initialization function. Compilers optimize
+/// them for size and spend less time on them, which matters for registries with many commands.
+/// </summary>
+#if defined(__GNUC__) || defined(__clang__)
+#define FUNCTION_FINDER_COLD [[gnu::cold]]
+#else
+#define FUNCTION_FINDER_COLD
+#endif
+
+/// <summary>
+/// Keeps a function out of line, for code meant to be shared rather than copied into every caller.
+/// </summary>
+#if defined(_MSC_VER)
+#define FUNCTION_FINDER_NOINLINE __declspec(noinline)
+#else
+#define FUNCTION_FINDER_NOINLINE __attribute__((noinline))
+#endif
+
+/// <summary>
+/// Exports a function from a shared library, also when it's built with hidden visibility. Used by
+/// registries generated with '--shared-library'.
+/// </summary>
+#if defined(_WIN32)
+#define FUNCTION_FINDER_EXPORT __declspec(dllexport)
+#else
+#define FUNCTION_FINDER_EXPORT __attribute__((visibility("default")))
+#endif
+
 // Pre-decls
 struct Argument;
 struct Value;
@@ -33,9 +69,27 @@ enum class Value_Type
 	INTEGER,
 	FLOAT,
 	DOUBLE,
-	BOOLEAN
+	BOOLEAN,
+
+	/// <summary>
+	/// Lists of numbers. Arguments declared as std::vector or std::span of int, float or double.
+	/// Only supported as argument types, without default values. Parsed from a single argument
+	/// string like "1,2,3", "[1 2 3]" or "1.5f, -2". See \ref get_number_array.
+	/// </summary>
+	INTEGER_ARRAY,
+	FLOAT_ARRAY,
+	DOUBLE_ARRAY
 };
 
+/// <summary>
+/// Whether the type is one of the list types, INTEGER_ARRAY and so on.
+/// </summary>
+inline bool is_array_type(Value_Type type)
+{
+	return type == Value_Type::INTEGER_ARRAY || type == Value_Type::FLOAT_ARRAY ||
+		type == Value_Type::DOUBLE_ARRAY;
+}
+
 /// <summary>
 /// A union with each of the different types of data
 /// </summary>
@@ -80,17 +134,65 @@ struct Call_Result
 {
 	Call_Result_Status status;
 	Value value; // Unset if error!
+
+	/// <summary>
+	/// The complete result of commands returning std::string, moved out of the client function's
+	/// return value. value.data.string_value only holds as much of it as fits. Move it out again to
+	/// keep large results without copying them.
+	/// </summary>
+	std::string string_value;
 	
 	// Error stuff
 	std::string error_message; // Empty if no error!
 	int error_helper_value; // Helper value. Points to the wrong argument index. and more!
 };
 
+/// <summary>
+/// Copies as much of source as fits into the string storage of a value, always leaving it null
+/// terminated.
+/// </summary>
+inline void set_string_value(Value &out_value, std::string_view source)
+{
+	size_t length = std::min(source.size(), sizeof(out_value.data.string_value) - 1);
+	std::memcpy(out_value.data.string_value, source.data(), length);
+	out_value.data.string_value[length] = '\0';
+}
+
 /// <summary>
 /// Base type for the wrappers generated by this program. It takes a string list to handle parsing. 
 /// </summary>
 using Function_Wrapper = Call_Result (*)(std::vector<std::string> &args, bool call_client_function);
 
+template <typename T>
+class Command_Task;
+
+/// <summary>
+/// An awaitable \ref Call_Result. See "function_finder/command_task.hpp".
+/// </summary>
+using Call_Task = Command_Task<Call_Result>;
+
+/// <summary>
+/// Type of the wrappers generated for asynchronous commands, see '--task-type'. They start the
+/// client function and return without waiting for it, which is why they take the arguments by
+/// value: the coroutine keeps them alive until the client function finishes.
+/// </summary>
+using Async_Function_Wrapper = Call_Task (*)(std::vector<std::string> args, bool call_client_function);
+
+/// <summary>
+/// Type of the typed entry points generated with '--typed-entries'. They take their first argument
+/// from the result of another command as is, rather than parsing it from text, and parse the rest
+/// from args like a regular wrapper. See "function_finder/pipeline.hpp".
+/// </summary>
+using Piped_Function_Wrapper = Call_Result (*)(Call_Result &input, std::vector<std::string> &args,
+	bool call_client_function);
+
+/// <summary>
+/// Type of the binary entry points generated with '--binary-entries'. They read the arguments from
+/// a binary buffer rather than parsing them from text. See "function_finder/binary_arguments.hpp"
+/// for the format.
+/// </summary>
+using Binary_Function_Wrapper = Call_Result (*)(std::string_view arguments, bool call_client_function);
+
 /// <summary>
 /// Contains information parsed on a source code function declaration.
 /// </summary>
@@ -128,6 +230,26 @@ struct Function_Decl
 	/// </summary>
 	Function_Wrapper function = nullptr;
 
+	/// <summary>
+	/// For asynchronous commands, a pointer to a generated wrapper that returns as soon as the
+	/// client function is started. nullptr for regular commands. The regular wrapper in function
+	/// also works for asynchronous commands, but blocks until the client function finishes.
+	/// </summary>
+	Async_Function_Wrapper async_function = nullptr;
+
+	/// <summary>
+	/// A pointer to the generated typed entry point, which takes the first argument from another
+	/// command's result. nullptr unless generated with '--typed-entries', and for commands without
+	/// arguments, asynchronous commands and commands whose first argument is a list.
+	/// </summary>
+	Piped_Function_Wrapper piped_function = nullptr;
+
+	/// <summary>
+	/// A pointer to the generated binary entry point, which reads the arguments from a binary
+	/// buffer. nullptr unless generated with '--binary-entries', and for asynchronous commands.
+	/// </summary>
+	Binary_Function_Wrapper binary_function = nullptr;
+
 	/// <summary>
 	/// The return type of the consumer-written function.
 	/// </summary>
@@ -237,7 +359,7 @@ struct Argument
 	{
 		this->has_default_value = true;
 		this->default_value.type = Value_Type::STRING;
-		strncpy(this->default_value.data.string_value, default_value, sizeof(this->default_value.data.string_value));
+		set_string_value(this->default_value, default_value);
 	}
 
 	/// <summary>
@@ -292,11 +414,26 @@ struct Argument
 /// </summary>
 using Function_Map = std::unordered_map<std::string, Function_Decl>;
 
+/// <summary>
+/// Bumped whenever the registry types change in a way their sizes don't show.
+/// </summary>
+constexpr uint32_t FUNCTION_FINDER_REGISTRY_VERSION = 1;
+
+/// <summary>
+/// Identifies the layout of the registry types. Shared libraries with commands only register
+/// them with hosts built against the same layout, see "function_finder/hot_reload.hpp".
+/// </summary>
+constexpr uint64_t command_registry_abi()
+{
+	return ((uint64_t)FUNCTION_FINDER_REGISTRY_VERSION << 48) ^ ((uint64_t)sizeof(Function_Decl) << 32) ^
+		((uint64_t)sizeof(Call_Result) << 16) ^ (uint64_t)sizeof(Function_Map);
+}
+
 
 /// <summary>
 /// Advances the string_view cursor 'length' characters.
 /// </summary>
-std::string_view advance(std::string_view source, size_t length)
+inline std::string_view advance(std::string_view source, size_t length)
 {
 	return source.substr(length);
 }
@@ -304,7 +441,7 @@ std::string_view advance(std::string_view source, size_t length)
 /// <summary>
 /// Advances the cursor past all white-space characters.
 /// </summary>
-std::string_view skip_whitespace(std::string_view source)
+inline std::string_view skip_whitespace(std::string_view source)
 {
 	if(source.size() == 0)
 	{
@@ -446,7 +583,7 @@ inline size_t get_string(std::string_view source, std::string &out_result)
 /// could allow names that aren't legal C++ symbol names like "123__::__4". However, since that 
 /// wouldn't compile anyway, I don't consider that a real issue. 
 /// </summary>
-inline size_t get_symbol(std::string_view source, std::string &out_result)
+inline size_t get_symbol(std::string_view source, std::string_view &out_result)
 {
 	size_t max_length = source.size();
 	size_t length = 0;
@@ -455,11 +592,113 @@ inline size_t get_symbol(std::string_view source, std::string &out_result)
 		length++;
 	}
 
-	out_result = std::string(source.begin(), source.begin() + length);
+	out_result = source.substr(0, length);
 
 	return length;
 }
 
+/// <summary>
+/// Same as the above, but copies the symbol into out_result.
+/// </summary>
+inline size_t get_symbol(std::string_view source, std::string &out_result)
+{
+	std::string_view symbol;
+	size_t length = get_symbol(source, symbol);
+	out_result = symbol;
+	return length;
+}
+
+/// <summary>
+/// Parses a whole list of numbers into out_result in a single pass over source. Numbers are
+/// separated by commas and/or whitespace, and the list may be wrapped in square brackets. Floating
+/// point numbers may have an 'f' suffix. out_result is cleared first, so a reused vector keeps its
+/// capacity.
+/// </summary>
+/// <returns>The length of source, or 0 if any part of it isn't a number.</returns>
+template <typename T>
+inline size_t get_number_array(std::string_view source, std::vector<T> &out_result)
+{
+	out_result.clear();
+
+	const char *cursor = source.data();
+	const char *end = source.data() + source.size();
+	auto is_separator = [](char c) { return c == ',' || std::isspace((unsigned char)c); };
+
+	bool bracketed = cursor != end && *cursor == '[';
+	if (bracketed)
+	{
+		cursor++;
+	}
+
+	while (true)
+	{
+		while (cursor != end && is_separator(*cursor))
+		{
+			cursor++;
+		}
+		if (cursor == end || *cursor == ']')
+		{
+			break;
+		}
+
+		// from_chars doesn't accept an explicit plus sign.
+		if (*cursor == '+')
+		{
+			cursor++;
+		}
+
+		T value;
+		auto result = std::from_chars(cursor, end, value);
+		if (result.ec != std::errc())
+		{
+			return 0;
+		}
+		cursor = result.ptr;
+
+		if constexpr (std::is_floating_point_v<T>)
+		{
+			if (cursor != end && *cursor == 'f')
+			{
+				cursor++;
+			}
+		}
+
+		// Numbers have to be followed by a separator or the end of the list, so "1x" fails.
+		if (cursor != end && !is_separator(*cursor) && *cursor != ']')
+		{
+			return 0;
+		}
+		out_result.push_back(value);
+	}
+
+	// A closing bracket has to match an opening one, and end the source.
+	if (bracketed != (cursor != end))
+	{
+		return 0;
+	}
+	if (bracketed && cursor + 1 != end)
+	{
+		return 0;
+	}
+
+	return source.size();
+}
+
+inline size_t get_int_array(std::string_view source, std::vector<int> &out_result)
+{
+	return get_number_array(source, out_result);
+}
+
+inline size_t get_float_array(std::string_view source, std::vector<float> &out_result)
+{
+	return get_number_array(source, out_result);
+}
+
+inline size_t get_double_array(std::string_view source, std::vector<double> &out_result)
+{
+	return get_number_array(source, out_result);
+}
+
 /// <summary>
 /// Parses the first double found in the source string.
 /// </summary>
@@ -586,6 +825,12 @@ inline std::string value_type_to_cpp_type(Value_Type type)
 		return "double";
 	case Value_Type::BOOLEAN:
 		return "bool";
+	case Value_Type::INTEGER_ARRAY:
+		return "std::vector<int>";
+	case Value_Type::FLOAT_ARRAY:
+		return "std::vector<float>";
+	case Value_Type::DOUBLE_ARRAY:
+		return "std::vector<double>";
 	}
 	return "";
 }
@@ -609,6 +854,12 @@ inline std::string value_type_to_readable_string(Value_Type type)
 		return "double";
 	case Value_Type::BOOLEAN:
 		return "bool";
+	case Value_Type::INTEGER_ARRAY:
+		return "int_array";
+	case Value_Type::FLOAT_ARRAY:
+		return "float_array";
+	case Value_Type::DOUBLE_ARRAY:
+		return "double_array";
 	}
 	return "";
 }
@@ -632,6 +883,12 @@ inline std::string to_string(Value_Type type)
 		return "Value_Type::DOUBLE";
 	case Value_Type::BOOLEAN:
 		return "Value_Type::BOOLEAN";
+	case Value_Type::INTEGER_ARRAY:
+		return "Value_Type::INTEGER_ARRAY";
+	case Value_Type::FLOAT_ARRAY:
+		return "Value_Type::FLOAT_ARRAY";
+	case Value_Type::DOUBLE_ARRAY:
+		return "Value_Type::DOUBLE_ARRAY";
 	}
 	return "";
 }
@@ -660,3 +917,377 @@ inline std::string to_string(const Value &value)
 		return "UNKNOWN";
 	}
 }
+
+
+/**************************************
+ *          Error reporting           *
+ **************************************/
+
+/// <summary>
+/// Sets the error wrappers report when fewer arguments than required are provided. Shared by all
+/// wrappers and kept out of line, so the message formatting doesn't sit in their hot paths.
+/// </summary>
+FUNCTION_FINDER_COLD FUNCTION_FINDER_NOINLINE inline void set_not_enough_arguments_error(
+	Call_Result &out_result, std::string_view command_name, size_t num_required_args,
+	size_t num_provided_args)
+{
+	out_result.error_message = std::format("Not enough arguments for '{}'. Needed {}, but got {}",
+		command_name, num_required_args, num_provided_args);
+	out_result.status = Call_Result_Status::NOT_ENOUGH_ARGUMENTS_ERROR;
+	out_result.error_helper_value = (int)num_provided_args;
+}
+
+/// <summary>
+/// Sets the error wrappers report when an argument can't be parsed. Shared by all wrappers and kept
+/// out of line, like \ref set_not_enough_arguments_error.
+/// </summary>
+/// <param name="index">Index of the argument.</param>
+/// <param name="argument_name">Name of the argument in the client function.</param>
+/// <param name="type">The type the argument was parsed as.</param>
+/// <param name="argument">The provided argument.</param>
+FUNCTION_FINDER_COLD FUNCTION_FINDER_NOINLINE inline void set_argument_parsing_error(
+	Call_Result &out_result, size_t index, std::string_view argument_name, Value_Type type,
+	std::string_view argument)
+{
+	out_result.error_message = std::format("Failed to parse argument {} '{}'. Attempted to parse a {}, "
+		"but got string '{}'", index, argument_name, value_type_to_cpp_type(type), argument);
+	out_result.status = Call_Result_Status::ARGUMENT_PARSING_ERROR;
+	out_result.error_helper_value = (int)index;
+}
+
+/// <summary>
+/// Sets the error typed entry points report when the piped in value has the wrong type. Pipelines
+/// check the types before running, see \ref can_pipe_value.
+/// </summary>
+FUNCTION_FINDER_COLD FUNCTION_FINDER_NOINLINE inline void set_piped_value_error(
+	Call_Result &out_result, std::string_view argument_name, Value_Type type, Value_Type provided_type)
+{
+	out_result.error_message = std::format("Can't pass a {} as argument 0 '{}', which is a {}",
+		value_type_to_cpp_type(provided_type), argument_name, value_type_to_cpp_type(type));
+	out_result.status = Call_Result_Status::ARGUMENT_PARSING_ERROR;
+	out_result.error_helper_value = 0;
+}
+
+
+/**************************************
+ *       Table-driven wrappers        *
+ **************************************/
+
+/// <summary>
+/// A parsed argument, or a default value, for the wrappers generated with '--wrappers=table'.
+/// Strings point into the argument list or at a string literal.
+/// </summary>
+struct Argument_Value
+{
+	union
+	{
+		int int_value;
+		float float_value;
+		double double_value;
+		bool bool_value;
+	};
+	std::string_view string_value;
+
+	constexpr Argument_Value()
+		: int_value(0)
+	{
+	}
+};
+
+/// <summary>
+/// Describes an argument of a table-driven command. The generated tables are constexpr, so they
+/// end up as read-only data rather than code.
+/// </summary>
+struct Argument_Descriptor
+{
+	const char *name;
+	Value_Type type;
+	bool has_default_value = false;
+	Argument_Value default_value;
+
+	/// <summary>
+	/// Constructor for arguments without default values.
+	/// </summary>
+	constexpr Argument_Descriptor(const char *name, Value_Type type)
+		: name(name), type(type)
+	{
+	}
+
+	/// <summary>
+	/// Constructor for arguments with string default value.
+	/// </summary>
+	constexpr Argument_Descriptor(const char *name, Value_Type type, const char *default_value)
+		: Argument_Descriptor(name, type)
+	{
+		has_default_value = true;
+		this->default_value.string_value = default_value;
+	}
+
+	/// <summary>
+	/// Constructor for arguments with int default value.
+	/// </summary>
+	constexpr Argument_Descriptor(const char *name, Value_Type type, int default_value)
+		: Argument_Descriptor(name, type)
+	{
+		has_default_value = true;
+		this->default_value.int_value = default_value;
+	}
+
+	/// <summary>
+	/// Constructor for arguments with float default value.
+	/// </summary>
+	constexpr Argument_Descriptor(const char *name, Value_Type type, float default_value)
+		: Argument_Descriptor(name, type)
+	{
+		has_default_value = true;
+		this->default_value.float_value = default_value;
+	}
+
+	/// <summary>
+	/// Constructor for arguments with double default value.
+	/// </summary>
+	constexpr Argument_Descriptor(const char *name, Value_Type type, double default_value)
+		: Argument_Descriptor(name, type)
+	{
+		has_default_value = true;
+		this->default_value.double_value = default_value;
+	}
+
+	/// <summary>
+	/// Constructor for arguments with bool default value.
+	/// </summary>
+	constexpr Argument_Descriptor(const char *name, Value_Type type, bool default_value)
+		: Argument_Descriptor(name, type)
+	{
+		has_default_value = true;
+		this->default_value.bool_value = default_value;
+	}
+};
+
+/// <summary>
+/// Describes a table-driven command: everything \ref parse_table_arguments needs to parse its
+/// arguments.
+/// </summary>
+struct Command_Descriptor
+{
+	const char *name;
+	const Argument_Descriptor *arguments;
+	int num_arguments;
+	int num_required_args;
+	Value_Type return_type;
+};
+
+/// <summary>
+/// The interpreter behind the wrappers generated with '--wrappers=table'. Parses the arguments of
+/// any command according to its descriptor, so all commands share this one function rather than
+/// each having its own parser. Reports the same errors as the full wrappers.
+/// </summary>
+/// <param name="command">The command being called.</param>
+/// <param name="args">The provided arguments.</param>
+/// <param name="out_values">Array of command.num_arguments values to parse into. Arguments that
+/// weren't provided get their default value.</param>
+/// <param name="out_result">Set to success with the command's return type, or to the error.</param>
+/// <returns>True if all arguments could be parsed.</returns>
+FUNCTION_FINDER_NOINLINE inline bool parse_table_arguments(const Command_Descriptor &command,
+	const std::vector<std::string> &args, Argument_Value *out_values, Call_Result &out_result)
+{
+	if (args.size() < (size_t)command.num_required_args) [[unlikely]]
+	{
+		set_not_enough_arguments_error(out_result, command.name, command.num_required_args, args.size());
+		return false;
+	}
+
+	for (int i = 0; i < command.num_arguments; i++)
+	{
+		const Argument_Descriptor &argument = command.arguments[i];
+		Argument_Value &value = out_values[i];
+		if ((size_t)i >= args.size())
+		{
+			value = argument.default_value;
+			continue;
+		}
+
+		size_t success = 0;
+		switch (argument.type)
+		{
+		case Value_Type::STRING:
+			value.string_value = args[i];
+			success = 1;
+			break;
+		case Value_Type::INTEGER:
+			success = get_int(args[i], value.int_value);
+			break;
+		case Value_Type::FLOAT:
+			success = get_float(args[i], value.float_value);
+			break;
+		case Value_Type::DOUBLE:
+			success = get_double(args[i], value.double_value);
+			break;
+		case Value_Type::BOOLEAN:
+			success = get_bool(args[i], value.bool_value);
+			break;
+		default:
+			break;
+		}
+
+		if (!success) [[unlikely]]
+		{
+			set_argument_parsing_error(out_result, i, argument.name, argument.type, args[i]);
+			return false;
+		}
+	}
+
+	out_result.value.type = command.return_type;
+	out_result.status = Call_Result_Status::SUCCESS;
+	return true;
+}
+
+
+/**************************************
+ *            Command ids             *
+ **************************************/
+
+/// <summary>
+/// What a registry generated with '--command-ids=<name>' stores per command, in the order of its
+/// id enum. Enough to call a command without going through the \ref Function_Map.
+/// </summary>
+struct Command_Info
+{
+	const char *name;
+	Function_Wrapper function;
+	Async_Function_Wrapper async_function;
+	Value_Type return_type;
+	int num_required_args;
+	int num_optional_args;
+};
+
+/// <summary>
+/// The commands of a registry, indexed by its id enum. Specialized by the generated file for the
+/// enum it declares, with these members:
+///
+///     static constexpr size_t count;                                // Number of commands.
+///     static constexpr std::array<Command_Info, count> commands;     // Indexed by the enum.
+///     static constexpr std::array<Id, count> sorted_ids;             // Sorted by command name.
+/// </summary>
+template <typename Id>
+struct Command_Table;
+
+/// <summary>
+/// Returns the info of a command. No lookup, just an array access.
+/// </summary>
+template <typename Id>
+constexpr const Command_Info &get_command_info(Id id)
+{
+	return Command_Table<Id>::commands[(size_t)id];
+}
+
+/// <summary>
+/// Calls a command by id, like calling its \ref Function_Decl::function.
+/// </summary>
+template <typename Id>
+Call_Result call_command(Id id, std::vector<std::string> &args, bool call_client_function = true)
+{
+	return Command_Table<Id>::commands[(size_t)id].function(args, call_client_function);
+}
+
+/// <summary>
+/// Finds the id of a command by name. A binary search, so resolve names once and keep the ids
+/// rather than calling this for every call.
+/// </summary>
+/// <returns>True if there's a command with that name.</returns>
+template <typename Id>
+bool find_command_id(std::string_view name, Id &out_id)
+{
+	using Table = Command_Table<Id>;
+	auto found = std::lower_bound(Table::sorted_ids.begin(), Table::sorted_ids.end(), name,
+		[](Id id, std::string_view key) { return std::string_view(Table::commands[(size_t)id].name) < key; });
+
+	if (found == Table::sorted_ids.end() || Table::commands[(size_t)*found].name != name)
+	{
+		return false;
+	}
+	out_id = *found;
+	return true;
+}
+
+
+/**************************************
+ *         Typed entry points         *
+ **************************************/
+
+/// <summary>
+/// Whether a result of type from can be passed as an argument of type to without going through
+/// text. Numbers convert to wider number types, everything else has to match.
+/// </summary>
+constexpr bool can_pipe_value(Value_Type from, Value_Type to)
+{
+	switch (to)
+	{
+	case Value_Type::STRING:
+	case Value_Type::INTEGER:
+	case Value_Type::BOOLEAN:
+		return from == to;
+	case Value_Type::FLOAT:
+		return from == Value_Type::INTEGER || from == Value_Type::FLOAT;
+	case Value_Type::DOUBLE:
+		return from == Value_Type::INTEGER || from == Value_Type::FLOAT || from == Value_Type::DOUBLE;
+	default:
+		return false;
+	}
+}
+
+/// <summary>
+/// Takes the value of a result for an argument, for the entry points generated with
+/// '--typed-entries'. Strings are moved out of the result.
+/// </summary>
+/// <returns>False if the types don't match, see \ref can_pipe_value.</returns>
+inline bool get_piped_value(Call_Result &input, int &out_value)
+{
+	if (input.value.type != Value_Type::INTEGER)
+	{
+		return false;
+	}
+	out_value = input.value.data.int_value;
+	return true;
+}
+
+inline bool get_piped_value(Call_Result &input, float &out_value)
+{
+	switch (input.value.type)
+	{
+	case Value_Type::INTEGER: out_value = (float)input.value.data.int_value; return true;
+	case Value_Type::FLOAT: out_value = input.value.data.float_value; return true;
+	default: return false;
+	}
+}
+
+inline bool get_piped_value(Call_Result &input, double &out_value)
+{
+	switch (input.value.type)
+	{
+	case Value_Type::INTEGER: out_value = input.value.data.int_value; return true;
+	case Value_Type::FLOAT: out_value = input.value.data.float_value; return true;
+	case Value_Type::DOUBLE: out_value = input.value.data.double_value; return true;
+	default: return false;
+	}
+}
+
+inline bool get_piped_value(Call_Result &input, bool &out_value)
+{
+	if (input.value.type != Value_Type::BOOLEAN)
+	{
+		return false;
+	}
+	out_value = input.value.data.bool_value;
+	return true;
+}
+
+inline bool get_piped_value(Call_Result &input, std::string &out_value)
+{
+	if (input.value.type != Value_Type::STRING)
+	{
+		return false;
+	}
+	out_value = std::move(input.string_value);
+	return true;
+}
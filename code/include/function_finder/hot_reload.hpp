@@ -0,0 +1,427 @@
+/*
+Loads commands from a shared library at runtime, and loads them again whenever the library is
+rebuilt, so changing a command only takes rebuilding the library rather than restarting the
+program. Generate the registry with '--shared-library', build it into a shared library and load it
+from the host program:
+
+    Command_Library library("build/libgame_commands.so");
+    library.load();
+    ...
+    library.reload_if_changed();                    // Say once per frame, or per command typed.
+
+    Call_Result result;
+    library.call("add", args, result);
+
+    auto commands = library.get_commands();         // Or hold on to a version for a while.
+    commands->functions.at("add").function(args, true);
+
+    std::optional<Call_Task> task = library.call_async("count_slowly", args);
+
+Every load creates a new \ref Loaded_Commands, which is swapped in atomically, so other threads
+keep calling commands while the library is reloaded. Callers hold a shared_ptr to the version
+they're calling, and a version's library is only unloaded once nothing holds it anymore, so calls
+in flight keep running the code they started in. Tasks started with \ref Command_Library::call_async
+hold their version until they finish. The thread finishing a task may still be running the
+library's code right then, so only that thread unloads the version, once it's back in the host's
+code: when it next loads or checks for changes, calls release_retired_command_versions(), or
+exits. Threads that resume tasks, like a task executor, should call release_retired_command_versions()
+between tasks, or versions pile up until they exit. Tasks started straight from a version's
+async_function don't hold it: hold on to the version until every one of them has finished.
+
+The library is copied before it's loaded. The copy always gets loaded as a new library, where
+loading the same path again may just return the version loaded before, and it leaves the original
+free to be overwritten by the next build while the old version is still in use.
+
+The library has its own copy of the runtime's global state, like the instrumentation and journal
+registries, unless the host program exports its symbols to it. State kept in the library, like
+memoized results, starts out empty after every reload. Build the library with '-fno-gnu-unique'
+when using GCC, otherwise the first version loaded stays loaded for good.
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
+
+#include "function_finder/function_finder.hpp"
+#include "function_finder/command_task.hpp"
+
+/// <summary>
+/// Name of the function libraries generated with '--shared-library' register their commands with.
+/// </summary>
+inline constexpr const char *COMMAND_LIBRARY_REGISTER_SYMBOL = "function_finder_register_commands";
+
+/// <summary>
+/// Signature of \ref COMMAND_LIBRARY_REGISTER_SYMBOL. Returns false, without registering anything,
+/// if registry_abi isn't the library's \ref command_registry_abi.
+/// </summary>
+using Register_Commands_Function = bool (*)(Function_Map &out_functions, uint64_t registry_abi);
+
+/// <summary>
+/// Loads a shared library, resolving all its symbols right away.
+/// </summary>
+/// <returns>The library's handle, or nullptr with out_error set.</returns>
+inline void *open_command_library(const std::filesystem::path &path, std::string &out_error)
+{
+#if defined(_WIN32)
+	HMODULE library = LoadLibraryW(path.c_str());
+	if (library == nullptr)
+	{
+		out_error = std::format("error {}", GetLastError());
+	}
+	return (void *)library;
+#else
+	void *library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+	if (library == nullptr)
+	{
+		out_error = dlerror();
+	}
+	return library;
+#endif
+}
+
+inline void *find_command_library_symbol(void *library, const char *name)
+{
+#if defined(_WIN32)
+	return (void *)GetProcAddress((HMODULE)library, name);
+#else
+	return dlsym(library, name);
+#endif
+}
+
+inline void close_command_library(void *library)
+{
+#if defined(_WIN32)
+	FreeLibrary((HMODULE)library);
+#else
+	dlclose(library);
+#endif
+}
+
+/// <summary>
+/// One loaded version of a command library. The library stays loaded as long as this exists.
+/// </summary>
+struct Loaded_Commands
+{
+	Function_Map functions;
+
+	/// <summary>
+	/// Counts the versions loaded by a \ref Command_Library, starting at 1.
+	/// </summary>
+	uint64_t generation = 0;
+
+	/// <summary>
+	/// The copy of the library that was loaded. Removed when the library is unloaded.
+	/// </summary>
+	std::filesystem::path loaded_path;
+
+	void *library = nullptr;
+
+	Loaded_Commands() = default;
+	Loaded_Commands(const Loaded_Commands &) = delete;
+	Loaded_Commands &operator=(const Loaded_Commands &) = delete;
+
+	~Loaded_Commands()
+	{
+		// The names and declarations were created by the library's code, drop them while it's
+		// still there.
+		functions.clear();
+		if (library != nullptr)
+		{
+			close_command_library(library);
+		}
+		if (!loaded_path.empty())
+		{
+			std::error_code error;
+			std::filesystem::remove(loaded_path, error);
+		}
+	}
+};
+
+/// <summary>
+/// Versions whose last asynchronous task finished on the calling thread. Unloading them right there
+/// would unmap the library's code while it's still on the thread's stack, below the task's final
+/// resumption. Other threads can't tell when this thread has left the library's code, so only this
+/// thread releases them, see \ref release_retired_command_versions. Dropped when the thread exits.
+/// </summary>
+inline std::vector<std::shared_ptr<const Loaded_Commands>> &get_thread_retired_command_versions()
+{
+	thread_local std::vector<std::shared_ptr<const Loaded_Commands>> versions;
+	return versions;
+}
+
+inline void retire_command_version(std::shared_ptr<const Loaded_Commands> commands)
+{
+	get_thread_retired_command_versions().push_back(std::move(commands));
+}
+
+/// <summary>
+/// Drops the versions retired by tasks that finished on the calling thread, unloading those
+/// nothing else holds. Called by \ref Command_Library when loading, checking for changes and when
+/// it's destroyed. Threads that resume tasks but don't load libraries call it themselves, never
+/// from a command's code.
+/// </summary>
+inline void release_retired_command_versions()
+{
+	std::vector<std::shared_ptr<const Loaded_Commands>> versions;
+	versions.swap(get_thread_retired_command_versions());
+}
+
+/// <summary>
+/// A shared library with commands, which can be reloaded while other threads are calling them.
+/// See the top of this file.
+/// </summary>
+class Command_Library
+{
+public:
+	explicit Command_Library(std::filesystem::path path)
+		: path(std::move(path))
+	{
+	}
+
+	Command_Library(const Command_Library &) = delete;
+	Command_Library &operator=(const Command_Library &) = delete;
+
+	~Command_Library()
+	{
+		release_retired_command_versions();
+	}
+
+	/// <summary>
+	/// Loads the library, replacing the version loaded before. The old version is unloaded once
+	/// the last call using it returns.
+	/// </summary>
+	/// <returns>False if the library couldn't be loaded. The version loaded before stays.</returns>
+	bool load()
+	{
+		release_retired_command_versions();
+		std::lock_guard lock(load_mutex);
+		std::error_code error;
+		auto write_time = std::filesystem::last_write_time(path, error);
+		if (error)
+		{
+			std::cerr << std::format("[ERROR] Could not find command library '{}': {}\n",
+				path.generic_string(), error.message());
+			return false;
+		}
+		return load_locked(write_time);
+	}
+
+	/// <summary>
+	/// Loads the library again if it was written to since it was last loaded. Cheap enough to call
+	/// often. A library that fails to load, say because it was loaded halfway through being
+	/// written, is tried again once it changes again.
+	/// </summary>
+	/// <returns>True if a new version was loaded.</returns>
+	bool reload_if_changed()
+	{
+		release_retired_command_versions();
+		std::lock_guard lock(load_mutex);
+		std::error_code error;
+		auto write_time = std::filesystem::last_write_time(path, error);
+		if (error || write_time == loaded_write_time)
+		{
+			return false;
+		}
+		return load_locked(write_time);
+	}
+
+	/// <summary>
+	/// The version loaded last, or nullptr if none was. Holding it keeps it loaded.
+	/// </summary>
+	std::shared_ptr<const Loaded_Commands> get_commands() const
+	{
+#if defined(__cpp_lib_atomic_shared_ptr)
+		return current.load();
+#else
+		return std::atomic_load(&current);
+#endif
+	}
+
+	/// <summary>
+	/// Calls a command of the version loaded last, which stays loaded until the call returns even
+	/// if the library is reloaded meanwhile.
+	/// </summary>
+	/// <returns>False if nothing is loaded or the command doesn't exist.</returns>
+	bool call(const std::string &name, std::vector<std::string> &args, Call_Result &out_result,
+		bool call_client_function = true) const
+	{
+		auto commands = get_commands();
+		if (commands == nullptr)
+		{
+			return false;
+		}
+		auto it = commands->functions.find(name);
+		if (it == commands->functions.end() || it->second.function == nullptr)
+		{
+			return false;
+		}
+		out_result = it->second.function(args, call_client_function);
+		return true;
+	}
+
+	/// <summary>
+	/// Starts an asynchronous command of the version loaded last. The task keeps that version
+	/// loaded until it finishes, also when it's destroyed before then.
+	/// </summary>
+	/// <returns>Nothing if nothing is loaded, or the command doesn't exist or isn't asynchronous.
+	/// </returns>
+	std::optional<Call_Task> call_async(const std::string &name, std::vector<std::string> args,
+		bool call_client_function = true) const
+	{
+		auto commands = get_commands();
+		if (commands == nullptr)
+		{
+			return std::nullopt;
+		}
+		auto it = commands->functions.find(name);
+		if (it == commands->functions.end() || it->second.async_function == nullptr)
+		{
+			return std::nullopt;
+		}
+		Call_Task task = it->second.async_function(std::move(args), call_client_function);
+		return keep_loaded_until_done(std::move(commands), std::move(task));
+	}
+
+	/// <summary>
+	/// The generation of the version loaded last, 0 if none was.
+	/// </summary>
+	uint64_t get_generation() const
+	{
+		auto commands = get_commands();
+		return commands != nullptr ? commands->generation : 0;
+	}
+
+	const std::filesystem::path &get_path() const
+	{
+		return path;
+	}
+
+private:
+	/// <summary>
+	/// Awaits a task started by a version's code, holding on to the version until the task is
+	/// done and freed. The version is retired rather than dropped, see
+	/// \ref get_thread_retired_command_versions.
+	/// </summary>
+	static Call_Task keep_loaded_until_done(std::shared_ptr<const Loaded_Commands> commands,
+		Call_Task task)
+	{
+		Call_Result result;
+		std::exception_ptr exception;
+		{
+			Call_Task running = std::move(task);
+			try
+			{
+				result = co_await running;
+			}
+			catch (...)
+			{
+				exception = std::current_exception();
+			}
+		}
+
+		retire_command_version(std::move(commands));
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+		co_return result;
+	}
+
+	static uint64_t get_process_id()
+	{
+#if defined(_WIN32)
+		return GetCurrentProcessId();
+#else
+		return (uint64_t)getpid();
+#endif
+	}
+
+	bool load_locked(std::filesystem::file_time_type write_time)
+	{
+		// Only try each build once, successful or not.
+		loaded_write_time = write_time;
+		uint64_t generation = ++load_count;
+
+		auto loaded = std::make_shared<Loaded_Commands>();
+		loaded->generation = generation;
+		loaded->loaded_path = std::filesystem::temp_directory_path() / std::format("{}.{}.{}{}",
+			path.stem().generic_string(), get_process_id(), generation, path.extension().generic_string());
+
+		std::error_code error;
+		std::filesystem::copy_file(path, loaded->loaded_path,
+			std::filesystem::copy_options::overwrite_existing, error);
+		if (error)
+		{
+			std::cerr << std::format("[ERROR] Could not copy command library '{}' to '{}': {}\n",
+				path.generic_string(), loaded->loaded_path.generic_string(), error.message());
+			loaded->loaded_path.clear();
+			return false;
+		}
+
+		std::string load_error;
+		loaded->library = open_command_library(loaded->loaded_path, load_error);
+		if (loaded->library == nullptr)
+		{
+			std::cerr << std::format("[ERROR] Could not load command library '{}': {}\n",
+				path.generic_string(), load_error);
+			return false;
+		}
+
+		auto register_commands = (Register_Commands_Function)find_command_library_symbol(
+			loaded->library, COMMAND_LIBRARY_REGISTER_SYMBOL);
+		if (register_commands == nullptr)
+		{
+			std::cerr << std::format("[ERROR] Command library '{}' has no '{}' function. Was it generated "
+				"with '--shared-library'?\n", path.generic_string(), COMMAND_LIBRARY_REGISTER_SYMBOL);
+			return false;
+		}
+		if (!register_commands(loaded->functions, command_registry_abi()))
+		{
+			std::cerr << std::format("[ERROR] Command library '{}' was built against a different version of "
+				"Function Finder\n", path.generic_string());
+			return false;
+		}
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+		current.store(std::move(loaded));
+#else
+		std::atomic_store(&current, std::shared_ptr<const Loaded_Commands>(std::move(loaded)));
+#endif
+		return true;
+	}
+
+	std::filesystem::path path;
+
+	/// <summary>
+	/// Serializes loading. Calls don't take it.
+	/// </summary>
+	std::mutex load_mutex;
+	std::filesystem::file_time_type loaded_write_time = std::filesystem::file_time_type::min();
+	uint64_t load_count = 0;
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+	std::atomic<std::shared_ptr<const Loaded_Commands>> current;
+#else
+	std::shared_ptr<const Loaded_Commands> current;
+#endif
+};
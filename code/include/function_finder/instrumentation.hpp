@@ -0,0 +1,719 @@
+/*
+Runtime support for instrumented wrappers. Only included by generated files created with the
+'--instrument' option, so consumers that don't ask for instrumentation pay nothing for it.
+
+Two kinds of data are recorded:
+ * Aggregate metrics per command. Read them with collect_call_stats().
+ * A timeline of the most recent calls per thread. Dump it with write_chrome_trace() and open the
+   file in chrome://tracing or https://ui.perfetto.dev.
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "function_finder/function_finder.hpp"
+#include "function_finder/allocation_tracking.hpp"
+
+/// <summary>
+/// Number of buckets in a latency histogram. Bucket i counts calls that took less than 2^i
+/// nanoseconds (and at least 2^(i-1)). The last bucket also holds everything slower.
+/// </summary>
+inline constexpr size_t LATENCY_HISTOGRAM_BUCKETS = 40;
+
+/// <summary>
+/// Number of commands per lazily allocated block of per-thread counters.
+/// </summary>
+inline constexpr size_t CALL_STATS_CHUNK_SIZE = 64;
+
+/// <summary>
+/// Maximum number of counter blocks per thread. Limits the number of instrumented commands to
+/// CALL_STATS_CHUNK_SIZE * CALL_STATS_MAX_CHUNKS, see \ref register_call_stats_command.
+/// </summary>
+inline constexpr size_t CALL_STATS_MAX_CHUNKS = 1024;
+
+/// <summary>
+/// The id commands past the instrumentation limit get. Their calls aren't recorded.
+/// </summary>
+inline constexpr size_t UNTRACKED_CALL_STATS_COMMAND = SIZE_MAX;
+
+/// <summary>
+/// Number of calls each thread keeps in its trace ring buffer. Older calls are overwritten.
+/// </summary>
+inline constexpr size_t CALL_TRACE_BUFFER_CAPACITY = 4096;
+
+/// <summary>
+/// Aggregated invocation metrics of a single command. This is what \ref collect_call_stats hands
+/// back to the consumer.
+/// </summary>
+struct Call_Stats
+{
+	/// <summary>
+	/// The command name, same as the key in the \ref Function_Map.
+	/// </summary>
+	std::string name;
+
+	/// <summary>
+	/// Number of successful calls where the client function was actually called.
+	/// </summary>
+	uint64_t call_count = 0;
+
+	/// <summary>
+	/// Number of successful calls with call_client_function set to false.
+	/// </summary>
+	uint64_t validation_count = 0;
+
+	/// <summary>
+	/// Number of calls that failed due to missing or unparsable arguments.
+	/// </summary>
+	uint64_t parse_failure_count = 0;
+
+	/// <summary>
+	/// Summed latency of all calls counted in call_count.
+	/// </summary>
+	uint64_t total_nanoseconds = 0;
+
+	/// <summary>
+	/// Summed heap allocations of all calls counted in call_count. Only counted in builds with
+	/// allocation tracking, see "function_finder/allocation_tracking.hpp".
+	/// </summary>
+	uint64_t allocation_count = 0;
+	uint64_t allocated_bytes = 0;
+
+	/// <summary>
+	/// Latency histogram of all calls counted in call_count. See \ref LATENCY_HISTOGRAM_BUCKETS.
+	/// </summary>
+	uint64_t latency_histogram[LATENCY_HISTOGRAM_BUCKETS] = {};
+
+	/// <summary>
+	/// Estimates a latency percentile from the histogram. Returns the upper bound of the bucket
+	/// the percentile falls into, so the result is accurate to within a factor of two.
+	/// </summary>
+	/// <param name="percentile">Percentile in the range [0, 1].</param>
+	uint64_t latency_percentile(double percentile) const
+	{
+		if (call_count == 0)
+		{
+			return 0;
+		}
+
+		uint64_t target = (uint64_t)(percentile * (double)call_count);
+		uint64_t seen = 0;
+		for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+		{
+			seen += latency_histogram[i];
+			if (seen > target || seen == call_count)
+			{
+				return (uint64_t)1 << i;
+			}
+		}
+		return (uint64_t)1 << (LATENCY_HISTOGRAM_BUCKETS - 1);
+	}
+};
+
+/// <summary>
+/// The counters one thread keeps for one command. Each counter is only ever written by its owning
+/// thread, so increments are plain relaxed load/store pairs rather than locked read-modify-writes.
+/// Readers on other threads only ever see whole values.
+/// </summary>
+struct Call_Stats_Counters
+{
+	std::atomic<uint64_t> call_count{ 0 };
+	std::atomic<uint64_t> validation_count{ 0 };
+	std::atomic<uint64_t> parse_failure_count{ 0 };
+	std::atomic<uint64_t> total_nanoseconds{ 0 };
+	std::atomic<uint64_t> allocation_count{ 0 };
+	std::atomic<uint64_t> allocated_bytes{ 0 };
+	std::atomic<uint64_t> latency_histogram[LATENCY_HISTOGRAM_BUCKETS] = {};
+};
+
+/// <summary>
+/// All the counters of one thread. Blocks of counters are allocated the first time the thread
+/// calls a command in that block.
+/// </summary>
+struct Call_Stats_Thread_Block
+{
+	std::atomic<Call_Stats_Counters *> chunks[CALL_STATS_MAX_CHUNKS] = {};
+
+	~Call_Stats_Thread_Block()
+	{
+		for (auto &chunk : chunks)
+		{
+			delete[] chunk.load();
+		}
+	}
+};
+
+/// <summary>
+/// One recorded call in a trace ring buffer. Guarded by a sequence number so a reader on another
+/// thread can detect, and skip, a slot that is being overwritten while it reads it. The sequence
+/// is odd while the slot is being written.
+/// </summary>
+struct Call_Trace_Slot
+{
+	std::atomic<uint64_t> sequence{ 0 };
+
+	/// <summary>
+	/// Trace id of the thread that made the call. Buffers are handed on to new threads, so the
+	/// older calls in a buffer may belong to a thread that exited.
+	/// </summary>
+	std::atomic<uint64_t> thread_id{ 0 };
+
+	std::atomic<uint64_t> command_id{ 0 };
+	std::atomic<int64_t> begin_nanoseconds{ 0 };
+	std::atomic<int64_t> arguments_parsed_nanoseconds{ 0 };
+	std::atomic<int64_t> end_nanoseconds{ 0 };
+	std::atomic<int> status{ 0 };
+	std::atomic<bool> called_client_function{ false };
+};
+
+/// <summary>
+/// The trace ring buffer of one thread. Only the owning thread writes to it.
+/// </summary>
+struct Call_Trace_Buffer
+{
+	/// <summary>
+	/// Trace id of the thread owning the buffer: a small sequential id, new for every thread, used
+	/// as the thread id in the exported trace.
+	/// </summary>
+	uint64_t thread_id = 0;
+
+	/// <summary>
+	/// Total number of calls ever written. The next call goes into slot head % capacity.
+	/// </summary>
+	std::atomic<uint64_t> head{ 0 };
+
+	Call_Trace_Slot slots[CALL_TRACE_BUFFER_CAPACITY];
+};
+
+/// <summary>
+/// Global bookkeeping for instrumentation. Owns the per-thread blocks so counts survive the
+/// threads that produced them. The blocks and buffers of threads that exited are handed on to new
+/// threads, which add their counts to the ones already there, so programs starting threads over
+/// and over keep one per running thread. The mutex is only taken when registering commands, when
+/// threads start or exit, and when aggregating.
+/// </summary>
+struct Call_Stats_Registry
+{
+	std::mutex mutex;
+	std::vector<std::string> names;
+	std::vector<std::unique_ptr<Call_Stats_Thread_Block>> thread_blocks;
+	std::vector<std::unique_ptr<Call_Trace_Buffer>> trace_buffers;
+
+	/// <summary>
+	/// Blocks and buffers of exited threads, ready for new ones.
+	/// </summary>
+	std::vector<Call_Stats_Thread_Block *> free_thread_blocks;
+	std::vector<Call_Trace_Buffer *> free_trace_buffers;
+
+	/// <summary>
+	/// Number of threads that took a trace buffer. Each gets the next trace id, also when it takes
+	/// over the buffer of a thread that exited.
+	/// </summary>
+	uint64_t trace_thread_count = 0;
+
+	/// <summary>
+	/// Whether wrappers write to the trace ring buffers. See \ref set_call_tracing_enabled.
+	/// </summary>
+	std::atomic<bool> tracing_enabled{ true };
+
+	/// <summary>
+	/// Snapshot subtracted from the counters when aggregating. Lets \ref reset_call_stats work
+	/// without writing to counters owned by other threads.
+	/// </summary>
+	std::vector<Call_Stats> baseline;
+};
+
+inline Call_Stats_Registry &get_call_stats_registry()
+{
+	static Call_Stats_Registry registry;
+	return registry;
+}
+
+/// <summary>
+/// Registers a command for instrumentation and returns its dense id. Called once per generated
+/// wrapper, the first time it runs. Registering the same name twice returns the same id.
+/// </summary>
+/// <returns>\ref UNTRACKED_CALL_STATS_COMMAND once CALL_STATS_CHUNK_SIZE * CALL_STATS_MAX_CHUNKS
+/// commands are registered.</returns>
+inline size_t register_call_stats_command(std::string_view name)
+{
+	auto &registry = get_call_stats_registry();
+	std::lock_guard lock(registry.mutex);
+
+	for (size_t i = 0; i < registry.names.size(); i++)
+	{
+		if (registry.names[i] == name)
+		{
+			return i;
+		}
+	}
+
+	if (registry.names.size() >= CALL_STATS_CHUNK_SIZE * CALL_STATS_MAX_CHUNKS)
+	{
+		std::cerr << std::format("[ERROR] Can't instrument '{}', only {} commands can be instrumented. "
+			"Its calls won't be recorded\n", name, CALL_STATS_CHUNK_SIZE * CALL_STATS_MAX_CHUNKS);
+		return UNTRACKED_CALL_STATS_COMMAND;
+	}
+
+	registry.names.emplace_back(name);
+	return registry.names.size() - 1;
+}
+
+/// <summary>
+/// Holds a thread's counters and trace buffer while the thread runs, each taken the first time
+/// it's needed. Hands them back to the registry when the thread exits.
+/// </summary>
+struct Call_Stats_Thread_Owner
+{
+	Call_Stats_Thread_Block *block = nullptr;
+	Call_Trace_Buffer *trace_buffer = nullptr;
+
+	Call_Stats_Thread_Owner() = default;
+	Call_Stats_Thread_Owner(const Call_Stats_Thread_Owner &) = delete;
+	Call_Stats_Thread_Owner &operator=(const Call_Stats_Thread_Owner &) = delete;
+
+	~Call_Stats_Thread_Owner()
+	{
+		if (!block && !trace_buffer)
+		{
+			return;
+		}
+		auto &registry = get_call_stats_registry();
+		std::lock_guard lock(registry.mutex);
+		if (block)
+		{
+			registry.free_thread_blocks.push_back(block);
+		}
+		if (trace_buffer)
+		{
+			registry.free_trace_buffers.push_back(trace_buffer);
+		}
+	}
+
+	FUNCTION_FINDER_COLD FUNCTION_FINDER_NOINLINE void take_block()
+	{
+		auto &registry = get_call_stats_registry();
+		std::lock_guard lock(registry.mutex);
+		if (!registry.free_thread_blocks.empty())
+		{
+			block = registry.free_thread_blocks.back();
+			registry.free_thread_blocks.pop_back();
+			return;
+		}
+		registry.thread_blocks.push_back(std::make_unique<Call_Stats_Thread_Block>());
+		block = registry.thread_blocks.back().get();
+	}
+
+	FUNCTION_FINDER_COLD FUNCTION_FINDER_NOINLINE void take_trace_buffer()
+	{
+		auto &registry = get_call_stats_registry();
+		std::lock_guard lock(registry.mutex);
+		if (!registry.free_trace_buffers.empty())
+		{
+			trace_buffer = registry.free_trace_buffers.back();
+			registry.free_trace_buffers.pop_back();
+		}
+		else
+		{
+			registry.trace_buffers.push_back(std::make_unique<Call_Trace_Buffer>());
+			trace_buffer = registry.trace_buffers.back().get();
+		}
+		trace_buffer->thread_id = ++registry.trace_thread_count;
+	}
+};
+
+inline Call_Stats_Thread_Owner &get_call_stats_thread_owner()
+{
+	thread_local Call_Stats_Thread_Owner owner;
+	return owner;
+}
+
+/// <summary>
+/// Returns the counters of the calling thread for a command, allocating them if needed.
+/// </summary>
+inline Call_Stats_Counters &get_thread_call_stats_counters(size_t command_id)
+{
+	Call_Stats_Thread_Owner &owner = get_call_stats_thread_owner();
+	if (!owner.block) [[unlikely]]
+	{
+		owner.take_block();
+	}
+
+	auto &chunk = owner.block->chunks[command_id / CALL_STATS_CHUNK_SIZE];
+	Call_Stats_Counters *counters = chunk.load(std::memory_order_relaxed);
+	if (!counters)
+	{
+		counters = new Call_Stats_Counters[CALL_STATS_CHUNK_SIZE];
+		chunk.store(counters, std::memory_order_release);
+	}
+	return counters[command_id % CALL_STATS_CHUNK_SIZE];
+}
+
+/// <summary>
+/// Increments a counter owned by the calling thread.
+/// </summary>
+inline void add_to_counter(std::atomic<uint64_t> &counter, uint64_t amount)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Returns the trace ring buffer of the calling thread, allocating it if needed.
+/// </summary>
+inline Call_Trace_Buffer &get_thread_call_trace_buffer()
+{
+	Call_Stats_Thread_Owner &owner = get_call_stats_thread_owner();
+	if (!owner.trace_buffer) [[unlikely]]
+	{
+		owner.take_trace_buffer();
+	}
+	return *owner.trace_buffer;
+}
+
+/// <summary>
+/// Turns the recording of trace events on or off at runtime. Aggregate metrics are always
+/// recorded. Tracing is enabled by default.
+/// </summary>
+inline void set_call_tracing_enabled(bool enabled)
+{
+	get_call_stats_registry().tracing_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Converts a steady_clock time point to the nanosecond timestamps used in traces. Use it to put
+/// your own events (frames, for example) on the same timeline.
+/// </summary>
+inline int64_t to_trace_nanoseconds(std::chrono::steady_clock::time_point time)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+/// <summary>
+/// Placed at the top of every instrumented wrapper. Records the call into the calling thread's
+/// counters and trace buffer when the wrapper returns, based on the final state of the wrapper's
+/// Call_Result.
+/// </summary>
+class Instrumented_Call
+{
+private:
+	size_t command_id;
+	const Call_Result &call_result;
+	bool call_client_function;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::steady_clock::time_point arguments_parsed;
+#ifdef FUNCTION_FINDER_TRACK_ALLOCATIONS
+	Allocation_Counters start_allocations;
+
+	// Asynchronous commands can finish on another thread, whose counters can't be compared.
+	const Allocation_Counters *start_thread_counters = &thread_allocation_counters;
+#endif
+
+	void record_trace_event(std::chrono::steady_clock::time_point end)
+	{
+		Call_Trace_Buffer &buffer = get_thread_call_trace_buffer();
+		uint64_t head = buffer.head.load(std::memory_order_relaxed);
+		Call_Trace_Slot &slot = buffer.slots[head % CALL_TRACE_BUFFER_CAPACITY];
+
+		uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+		slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		slot.thread_id.store(buffer.thread_id, std::memory_order_relaxed);
+		slot.command_id.store(command_id, std::memory_order_relaxed);
+		slot.begin_nanoseconds.store(to_trace_nanoseconds(start), std::memory_order_relaxed);
+		slot.arguments_parsed_nanoseconds.store(to_trace_nanoseconds(arguments_parsed),
+			std::memory_order_relaxed);
+		slot.end_nanoseconds.store(to_trace_nanoseconds(end), std::memory_order_relaxed);
+		slot.status.store((int)call_result.status, std::memory_order_relaxed);
+		slot.called_client_function.store(call_client_function, std::memory_order_relaxed);
+
+		slot.sequence.store(sequence + 2, std::memory_order_release);
+		buffer.head.store(head + 1, std::memory_order_release);
+	}
+
+public:
+	Instrumented_Call(size_t command_id, const Call_Result &call_result, bool call_client_function)
+		: command_id(command_id), call_result(call_result), call_client_function(call_client_function),
+		start(std::chrono::steady_clock::now()), arguments_parsed(start)
+	{
+#ifdef FUNCTION_FINDER_TRACK_ALLOCATIONS
+		start_allocations = get_thread_allocation_counters();
+#endif
+	}
+
+	/// <summary>
+	/// Called by the wrapper right before it calls the client function, splitting the call into
+	/// argument parsing and client function time in the trace.
+	/// </summary>
+	void mark_arguments_parsed()
+	{
+		arguments_parsed = std::chrono::steady_clock::now();
+	}
+
+	~Instrumented_Call()
+	{
+		if (command_id == UNTRACKED_CALL_STATS_COMMAND) [[unlikely]]
+		{
+			return;
+		}
+
+		auto end = std::chrono::steady_clock::now();
+
+		if (get_call_stats_registry().tracing_enabled.load(std::memory_order_relaxed))
+		{
+			record_trace_event(end);
+		}
+
+		Call_Stats_Counters &counters = get_thread_call_stats_counters(command_id);
+
+		if (call_result.status != Call_Result_Status::SUCCESS)
+		{
+			add_to_counter(counters.parse_failure_count, 1);
+			return;
+		}
+
+		if (!call_client_function)
+		{
+			add_to_counter(counters.validation_count, 1);
+			return;
+		}
+
+		uint64_t nanoseconds = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			end - start).count();
+		size_t bucket = std::min((size_t)std::bit_width(nanoseconds), LATENCY_HISTOGRAM_BUCKETS - 1);
+
+		add_to_counter(counters.call_count, 1);
+		add_to_counter(counters.total_nanoseconds, nanoseconds);
+		add_to_counter(counters.latency_histogram[bucket], 1);
+
+#ifdef FUNCTION_FINDER_TRACK_ALLOCATIONS
+		if (start_thread_counters == &thread_allocation_counters)
+		{
+			Allocation_Counters allocations = get_thread_allocation_counters() - start_allocations;
+			add_to_counter(counters.allocation_count, allocations.allocations);
+			add_to_counter(counters.allocated_bytes, allocations.bytes);
+		}
+#endif
+	}
+
+	Instrumented_Call(const Instrumented_Call &) = delete;
+	Instrumented_Call &operator=(const Instrumented_Call &) = delete;
+};
+
+/// <summary>
+/// Sums the counters of all threads. Expects the registry mutex to be held.
+/// </summary>
+inline std::vector<Call_Stats> sum_call_stats_counters(Call_Stats_Registry &registry)
+{
+	std::vector<Call_Stats> result(registry.names.size());
+	for (size_t id = 0; id < result.size(); id++)
+	{
+		Call_Stats &stats = result[id];
+		stats.name = registry.names[id];
+
+		for (const auto &block : registry.thread_blocks)
+		{
+			const Call_Stats_Counters *chunk =
+				block->chunks[id / CALL_STATS_CHUNK_SIZE].load(std::memory_order_acquire);
+			if (!chunk)
+			{
+				continue;
+			}
+
+			const Call_Stats_Counters &counters = chunk[id % CALL_STATS_CHUNK_SIZE];
+			stats.call_count += counters.call_count.load(std::memory_order_relaxed);
+			stats.validation_count += counters.validation_count.load(std::memory_order_relaxed);
+			stats.parse_failure_count += counters.parse_failure_count.load(std::memory_order_relaxed);
+			stats.total_nanoseconds += counters.total_nanoseconds.load(std::memory_order_relaxed);
+			stats.allocation_count += counters.allocation_count.load(std::memory_order_relaxed);
+			stats.allocated_bytes += counters.allocated_bytes.load(std::memory_order_relaxed);
+			for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+			{
+				stats.latency_histogram[i] += counters.latency_histogram[i].load(std::memory_order_relaxed);
+			}
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// Aggregates the metrics of every instrumented command across all threads. Commands only show up
+/// once they have been called at least once.
+/// </summary>
+inline std::vector<Call_Stats> collect_call_stats()
+{
+	auto &registry = get_call_stats_registry();
+	std::lock_guard lock(registry.mutex);
+
+	std::vector<Call_Stats> result = sum_call_stats_counters(registry);
+	for (size_t id = 0; id < result.size() && id < registry.baseline.size(); id++)
+	{
+		Call_Stats &stats = result[id];
+		const Call_Stats &base = registry.baseline[id];
+		stats.call_count -= base.call_count;
+		stats.validation_count -= base.validation_count;
+		stats.parse_failure_count -= base.parse_failure_count;
+		stats.total_nanoseconds -= base.total_nanoseconds;
+		stats.allocation_count -= base.allocation_count;
+		stats.allocated_bytes -= base.allocated_bytes;
+		for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+		{
+			stats.latency_histogram[i] -= base.latency_histogram[i];
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// Aggregates the metrics of the instrumented commands in the given registry. Commands that have
+/// never been called are included with zeroed metrics.
+/// </summary>
+inline std::vector<Call_Stats> collect_call_stats(const Function_Map &commands)
+{
+	std::vector<Call_Stats> all_stats = collect_call_stats();
+
+	std::vector<Call_Stats> result;
+	result.reserve(commands.size());
+	for (const auto &[name, decl] : commands)
+	{
+		auto found = std::find_if(all_stats.begin(), all_stats.end(), [&](const Call_Stats &stats)
+			{ return stats.name == name; });
+		if (found != all_stats.end())
+		{
+			result.push_back(*found);
+		}
+		else
+		{
+			Call_Stats empty;
+			empty.name = name;
+			result.push_back(empty);
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// Resets all metrics to zero, as seen from \ref collect_call_stats.
+/// </summary>
+inline void reset_call_stats()
+{
+	auto &registry = get_call_stats_registry();
+	std::lock_guard lock(registry.mutex);
+	registry.baseline = sum_call_stats_counters(registry);
+}
+
+/// <summary>
+/// Formats the metrics of a command as a single human readable line.
+/// </summary>
+inline std::string to_string(const Call_Stats &stats)
+{
+	uint64_t mean = stats.call_count ? stats.total_nanoseconds / stats.call_count : 0;
+	std::string result = std::format("{}: {} calls, {} validations, {} parse failures, mean {} ns, "
+		"p50 < {} ns, p99 < {} ns", stats.name, stats.call_count, stats.validation_count,
+		stats.parse_failure_count, mean, stats.latency_percentile(0.5),
+		stats.latency_percentile(0.99));
+
+	if (ALLOCATION_TRACKING_ENABLED && stats.call_count)
+	{
+		result += std::format(", {:.1f} allocations ({} B) per call",
+			(double)stats.allocation_count / (double)stats.call_count,
+			stats.allocated_bytes / stats.call_count);
+	}
+	return result;
+}
+
+/// <summary>
+/// Writes the calls currently held in the trace ring buffers of all threads as a Chrome trace
+/// event JSON file. Every call becomes a span named after the command, on the row of the thread that
+/// made it. Calls that reached the client function get two child spans splitting argument parsing
+/// from the client function.
+/// Timestamps come from std::chrono::steady_clock, see \ref to_trace_nanoseconds.
+/// </summary>
+inline void write_chrome_trace(std::ostream &out)
+{
+	auto &registry = get_call_stats_registry();
+	std::lock_guard lock(registry.mutex);
+
+	// Chrome expects microseconds, fractions are allowed.
+	auto to_microseconds = [](int64_t nanoseconds) { return (double)nanoseconds / 1000.0; };
+
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	bool first = true;
+	auto write_event = [&](const std::string &event)
+	{
+		out << (first ? "\n" : ",\n") << event;
+		first = false;
+	};
+
+	// Names every thread's row once, before its first call.
+	std::vector<bool> named_threads(registry.trace_thread_count + 1, false);
+	auto name_thread = [&](uint64_t thread_id)
+	{
+		if (!named_threads[thread_id])
+		{
+			named_threads[thread_id] = true;
+			write_event(std::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{0},"
+				"\"args\":{{\"name\":\"Thread {0}\"}}}}", thread_id));
+		}
+	};
+
+	for (const auto &buffer : registry.trace_buffers)
+	{
+		uint64_t head = buffer->head.load(std::memory_order_acquire);
+		uint64_t first_index = head > CALL_TRACE_BUFFER_CAPACITY ? head - CALL_TRACE_BUFFER_CAPACITY : 0;
+		for (uint64_t i = first_index; i < head; i++)
+		{
+			const Call_Trace_Slot &slot = buffer->slots[i % CALL_TRACE_BUFFER_CAPACITY];
+
+			uint64_t sequence_before = slot.sequence.load(std::memory_order_acquire);
+			uint64_t thread_id = slot.thread_id.load(std::memory_order_relaxed);
+			uint64_t command_id = slot.command_id.load(std::memory_order_relaxed);
+			int64_t begin = slot.begin_nanoseconds.load(std::memory_order_relaxed);
+			int64_t arguments_parsed = slot.arguments_parsed_nanoseconds.load(std::memory_order_relaxed);
+			int64_t end = slot.end_nanoseconds.load(std::memory_order_relaxed);
+			auto status = (Call_Result_Status)slot.status.load(std::memory_order_relaxed);
+			bool called_client_function = slot.called_client_function.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			// Skip slots the owning thread is overwriting right now.
+			if (sequence_before % 2 != 0 || slot.sequence.load(std::memory_order_relaxed) != sequence_before ||
+				command_id >= registry.names.size() || thread_id == 0 ||
+				thread_id > registry.trace_thread_count)
+			{
+				continue;
+			}
+			name_thread(thread_id);
+
+			const std::string &name = registry.names[command_id];
+			bool success = status == Call_Result_Status::SUCCESS;
+			write_event(std::format("{{\"name\":\"{}\",\"cat\":\"command\",\"ph\":\"X\",\"pid\":1,"
+				"\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f},\"args\":{{\"success\":{},\"called\":{}}}}}",
+				name, thread_id, to_microseconds(begin), to_microseconds(end - begin),
+				success ? "true" : "false", called_client_function ? "true" : "false"));
+
+			if (success && called_client_function)
+			{
+				write_event(std::format("{{\"name\":\"parse arguments\",\"cat\":\"command\",\"ph\":\"X\","
+					"\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}", thread_id,
+					to_microseconds(begin), to_microseconds(arguments_parsed - begin)));
+				write_event(std::format("{{\"name\":\"{}\",\"cat\":\"client\",\"ph\":\"X\","
+					"\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}", name, thread_id,
+					to_microseconds(arguments_parsed), to_microseconds(end - arguments_parsed)));
+			}
+		}
+	}
+
+	out << "\n]}\n";
+}
@@ -0,0 +1,345 @@
+/*
+Runtime support for memoized commands. Client functions marked with the tag given with
+'--memoize-tag' get wrappers that cache their results, keyed by the parsed argument values:
+
+    CONSOLE_COMMAND MEMOIZED // Only computed once per distinct argument.
+    int slow_lookup(std::string key);
+
+Every memoized command has its own cache, which keeps the most recently used results up to the
+capacity given with '--memoize-capacity'. Cached results are returned without calling the client
+function, so only memoize functions whose result depends on nothing but their arguments. When
+something they read does change, drop the cached results with invalidate_memoized_results().
+*/
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <unordered_map>
+#include <vector>
+
+#include "function_finder/function_finder.hpp"
+
+/// <summary>
+/// Cache metrics of one memoized command.
+/// </summary>
+struct Memo_Stats
+{
+	std::string name;
+
+	/// <summary>
+	/// Calls answered from the cache.
+	/// </summary>
+	uint64_t hits = 0;
+
+	/// <summary>
+	/// Calls that had to call the client function.
+	/// </summary>
+	uint64_t misses = 0;
+
+	/// <summary>
+	/// Results dropped to make room for newer ones.
+	/// </summary>
+	uint64_t evictions = 0;
+
+	/// <summary>
+	/// Number of cached results, and the most it keeps.
+	/// </summary>
+	size_t size = 0;
+	size_t capacity = 0;
+};
+
+/// <summary>
+/// Hashes memo keys, which are tuples of parsed argument values. Floats and doubles are hashed by
+/// their bits, like \ref Memo_Key_Equal compares them.
+/// </summary>
+struct Memo_Key_Hash
+{
+	static void combine(size_t &seed, size_t hash)
+	{
+		seed ^= hash + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+
+	template <typename T>
+	static size_t hash_value(const T &value)
+	{
+		return std::hash<T>{}(value);
+	}
+
+	static size_t hash_value(float value)
+	{
+		return std::hash<uint32_t>{}(std::bit_cast<uint32_t>(value));
+	}
+
+	static size_t hash_value(double value)
+	{
+		return std::hash<uint64_t>{}(std::bit_cast<uint64_t>(value));
+	}
+
+	template <typename T>
+	static size_t hash_value(const std::vector<T> &values)
+	{
+		size_t seed = values.size();
+		for (const T &value : values)
+		{
+			combine(seed, hash_value(value));
+		}
+		return seed;
+	}
+
+	template <typename... T>
+	size_t operator()(const std::tuple<T...> &key) const
+	{
+		size_t seed = 0;
+		std::apply([&seed](const auto &...values) { (combine(seed, hash_value(values)), ...); }, key);
+		return seed;
+	}
+};
+
+/// <summary>
+/// Compares memo keys. Floats and doubles are compared by their bits rather than with ==, under
+/// which NaN never equals itself: a NaN key would never be found, and never evicted either.
+/// </summary>
+struct Memo_Key_Equal
+{
+	template <typename T>
+	static bool equal_value(const T &a, const T &b)
+	{
+		return a == b;
+	}
+
+	static bool equal_value(float a, float b)
+	{
+		return std::bit_cast<uint32_t>(a) == std::bit_cast<uint32_t>(b);
+	}
+
+	static bool equal_value(double a, double b)
+	{
+		return std::bit_cast<uint64_t>(a) == std::bit_cast<uint64_t>(b);
+	}
+
+	template <typename T>
+	static bool equal_value(const std::vector<T> &a, const std::vector<T> &b)
+	{
+		return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+			[](const T &x, const T &y) { return equal_value(x, y); });
+	}
+
+	template <typename... T>
+	bool operator()(const std::tuple<T...> &a, const std::tuple<T...> &b) const
+	{
+		return [&a, &b]<size_t... I>(std::index_sequence<I...>)
+		{
+			return (equal_value(std::get<I>(a), std::get<I>(b)) && ...);
+		}(std::index_sequence_for<T...>{});
+	}
+};
+
+/// <summary>
+/// The part of a \ref Memo_Cache that doesn't depend on the argument types, so all caches can be
+/// listed and invalidated together.
+/// </summary>
+class Memo_Cache_Base
+{
+public:
+	virtual ~Memo_Cache_Base() = default;
+	virtual std::string_view get_name() const = 0;
+	virtual Memo_Stats get_stats() const = 0;
+	virtual void clear() = 0;
+};
+
+/// <summary>
+/// All memoized commands called so far. Caches register themselves when their wrapper first
+/// runs, so commands that were never called aren't listed.
+/// </summary>
+struct Memo_Cache_Registry
+{
+	std::mutex mutex;
+	std::vector<Memo_Cache_Base *> caches;
+};
+
+inline Memo_Cache_Registry &get_memo_cache_registry()
+{
+	static Memo_Cache_Registry registry;
+	return registry;
+}
+
+/// <summary>
+/// The results of one memoized command, keyed by its argument values. Evicts the least recently
+/// used result when full. Safe to use from multiple threads.
+/// </summary>
+/// <typeparam name="Key">std::tuple of the parsed argument types.</typeparam>
+template <typename Key>
+class Memo_Cache : public Memo_Cache_Base
+{
+private:
+	using Entry = std::pair<Key, Call_Result>;
+
+	std::string_view name;
+	size_t capacity;
+
+	mutable std::mutex mutex;
+
+	/// <summary>
+	/// Most recently used first.
+	/// </summary>
+	std::list<Entry> entries;
+	std::unordered_map<Key, typename std::list<Entry>::iterator, Memo_Key_Hash, Memo_Key_Equal> index;
+
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t evictions = 0;
+
+public:
+	Memo_Cache(std::string_view name, size_t capacity)
+		: name(name), capacity(capacity)
+	{
+		Memo_Cache_Registry &registry = get_memo_cache_registry();
+		std::lock_guard lock(registry.mutex);
+		registry.caches.push_back(this);
+	}
+
+	~Memo_Cache() override
+	{
+		Memo_Cache_Registry &registry = get_memo_cache_registry();
+		std::lock_guard lock(registry.mutex);
+		std::erase(registry.caches, this);
+	}
+
+	Memo_Cache(const Memo_Cache &) = delete;
+	Memo_Cache &operator=(const Memo_Cache &) = delete;
+
+	/// <summary>
+	/// Copies the cached result for key into out_result, if there is one.
+	/// </summary>
+	/// <returns>True on a hit.</returns>
+	bool find(const Key &key, Call_Result &out_result)
+	{
+		std::lock_guard lock(mutex);
+		auto found = index.find(key);
+		if (found == index.end())
+		{
+			misses++;
+			return false;
+		}
+
+		hits++;
+		entries.splice(entries.begin(), entries, found->second);
+		out_result = found->second->second;
+		return true;
+	}
+
+	/// <summary>
+	/// Caches the result for key, evicting the least recently used result if the cache is full.
+	/// </summary>
+	void insert(Key key, const Call_Result &result)
+	{
+		std::lock_guard lock(mutex);
+		if (capacity == 0)
+		{
+			return;
+		}
+
+		// Another thread may have computed the same result in the meantime.
+		auto found = index.find(key);
+		if (found != index.end())
+		{
+			found->second->second = result;
+			entries.splice(entries.begin(), entries, found->second);
+			return;
+		}
+
+		if (entries.size() >= capacity)
+		{
+			index.erase(entries.back().first);
+			entries.pop_back();
+			evictions++;
+		}
+		entries.emplace_front(std::move(key), result);
+		index.emplace(entries.front().first, entries.begin());
+	}
+
+	std::string_view get_name() const override
+	{
+		return name;
+	}
+
+	Memo_Stats get_stats() const override
+	{
+		std::lock_guard lock(mutex);
+		return { std::string(name), hits, misses, evictions, entries.size(), capacity };
+	}
+
+	void clear() override
+	{
+		std::lock_guard lock(mutex);
+		entries.clear();
+		index.clear();
+	}
+};
+
+/// <summary>
+/// Drops the cached results of all memoized commands.
+/// </summary>
+inline void invalidate_memoized_results()
+{
+	Memo_Cache_Registry &registry = get_memo_cache_registry();
+	std::lock_guard lock(registry.mutex);
+	for (Memo_Cache_Base *cache : registry.caches)
+	{
+		cache->clear();
+	}
+}
+
+/// <summary>
+/// Drops the cached results of one memoized command.
+/// </summary>
+/// <returns>False if the command isn't memoized or was never called, so nothing was cached.</returns>
+inline bool invalidate_memoized_results(std::string_view command_name)
+{
+	Memo_Cache_Registry &registry = get_memo_cache_registry();
+	std::lock_guard lock(registry.mutex);
+	for (Memo_Cache_Base *cache : registry.caches)
+	{
+		if (cache->get_name() == command_name)
+		{
+			cache->clear();
+			return true;
+		}
+	}
+	return false;
+}
+
+/// <summary>
+/// Returns the cache metrics of every memoized command called so far.
+/// </summary>
+inline std::vector<Memo_Stats> collect_memo_stats()
+{
+	Memo_Cache_Registry &registry = get_memo_cache_registry();
+	std::lock_guard lock(registry.mutex);
+	std::vector<Memo_Stats> result;
+	for (const Memo_Cache_Base *cache : registry.caches)
+	{
+		result.push_back(cache->get_stats());
+	}
+	return result;
+}
+
+/// <summary>
+/// One line summary of a command's cache.
+/// </summary>
+inline std::string to_string(const Memo_Stats &stats)
+{
+	uint64_t calls = stats.hits + stats.misses;
+	return std::format("{}: {} hits, {} misses ({:.1f}% hit rate), {} evictions, {}/{} cached",
+		stats.name, stats.hits, stats.misses, calls ? 100.0 * (double)stats.hits / (double)calls : 0.0,
+		stats.evictions, stats.size, stats.capacity);
+}
@@ -0,0 +1,149 @@
+/*
+Runs pipelines of commands, where each command's result becomes the first argument of the next
+one, like 'add 1 2 | multiply 3'. Needs registries generated with '--typed-entries': results are
+passed to the next command's typed entry point as they are, rather than converted to text and
+parsed again, so large strings are moved along and numbers keep their precision.
+
+    std::vector<Pipeline_Stage> pipeline;
+    if (parse_pipeline("add 1 2 | multiply", commands, pipeline))
+    {
+        Call_Result result = run_pipeline(pipeline);
+    }
+
+All stages are checked before anything runs: every command has to exist, and every result has to
+fit the first argument of the next command, see \ref can_pipe_value.
+*/
+#pragma once
+
+#include <format>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "function_finder/function_finder.hpp"
+
+/// <summary>
+/// One command of a pipeline, with the arguments written after it. The first stage gets all its
+/// arguments from text, the later ones all but the first.
+/// </summary>
+struct Pipeline_Stage
+{
+	const Function_Decl *command = nullptr;
+	std::vector<std::string> args;
+};
+
+/// <summary>
+/// Splits a command line into words, like a console does. Quoted words may contain spaces.
+/// </summary>
+/// <returns>False if a quote isn't closed.</returns>
+inline bool split_command_words(std::string_view line, std::vector<std::string> &out_words)
+{
+	// A copy, so the parsing functions stop at the end of the line.
+	std::string text(line);
+	std::string_view current = skip_whitespace(text);
+	while (!current.empty())
+	{
+		std::string word;
+		size_t length = get_string(current, word);
+		if (!length)
+		{
+			return false;
+		}
+		out_words.push_back(std::move(word));
+		current = skip_whitespace(advance(current, length));
+	}
+	return true;
+}
+
+/// <summary>
+/// Parses a pipeline like 'add 1 2 | multiply 3' and checks that the commands fit together. A line
+/// without '|' is a pipeline of one command.
+/// </summary>
+/// <returns>False if a command doesn't exist or can't take the previous command's result. The
+/// errors are printed.</returns>
+inline bool parse_pipeline(std::string_view line, const Function_Map &commands,
+	std::vector<Pipeline_Stage> &out_stages)
+{
+	// Split on the '|'s that aren't quoted.
+	std::vector<std::string_view> parts;
+	bool quoted = false;
+	size_t part_start = 0;
+	for (size_t i = 0; i < line.size(); i++)
+	{
+		if (line[i] == '\"')
+		{
+			quoted = !quoted;
+		}
+		else if (line[i] == '|' && !quoted)
+		{
+			parts.push_back(line.substr(part_start, i - part_start));
+			part_start = i + 1;
+		}
+	}
+	parts.push_back(line.substr(part_start));
+
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		std::vector<std::string> words;
+		bool closed = split_command_words(parts[i], words);
+		if (!closed || words.empty())
+		{
+			std::cerr << std::format("[ERROR] Pipeline stage {} is {}\n", i,
+				closed ? "empty" : "missing a closing quote");
+			return false;
+		}
+
+		auto found = commands.find(words[0]);
+		if (found == commands.end())
+		{
+			std::cerr << std::format("[ERROR] Unknown command '{}' in pipeline stage {}\n", words[0], i);
+			return false;
+		}
+		const Function_Decl &command = found->second;
+
+		if (i > 0)
+		{
+			const Function_Decl &previous = *out_stages.back().command;
+			if (!command.piped_function)
+			{
+				std::cerr << std::format("[ERROR] Can't pipe into '{}'. Only commands taking arguments have "
+					"typed entry points, and only when generated with '--typed-entries'\n", command.name);
+				return false;
+			}
+			if (!can_pipe_value(previous.return_type, command.arguments[0].type))
+			{
+				std::cerr << std::format("[ERROR] Can't pipe '{}' into '{}'. It returns a {}, but argument "
+					"'{}' is a {}\n", previous.name, command.name, value_type_to_cpp_type(previous.return_type),
+					command.arguments[0].name, value_type_to_cpp_type(command.arguments[0].type));
+				return false;
+			}
+		}
+
+		words.erase(words.begin());
+		out_stages.push_back({ &command, std::move(words) });
+	}
+	return true;
+}
+
+/// <summary>
+/// Runs a parsed pipeline. Stops at the first command that fails and returns its result.
+/// </summary>
+/// <param name="call_client_function">Whether to call the client functions, or only check the
+/// arguments of the first stage. Later stages need the results of earlier ones, so they're only
+/// checked by \ref parse_pipeline then.</param>
+inline Call_Result run_pipeline(std::vector<Pipeline_Stage> &stages, bool call_client_function = true)
+{
+	Call_Result result = stages[0].command->function(stages[0].args, call_client_function);
+	if (!call_client_function)
+	{
+		return result;
+	}
+
+	for (size_t i = 1; i < stages.size() && result.status == Call_Result_Status::SUCCESS; i++)
+	{
+		Call_Result input = std::move(result);
+		result = stages[i].command->piped_function(input, stages[i].args, true);
+	}
+	return result;
+}
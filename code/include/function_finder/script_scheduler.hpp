@@ -0,0 +1,474 @@
+/*
+Runs scripts of console commands, like startup scripts, on a pool of threads. Commands that don't
+touch the same resources run in parallel, while commands that do keep their order from the script.
+
+A script has one command per line, written like at a console. Empty lines and lines starting with
+'#' are skipped. What a command touches is declared per command name, or annotated per line with
+'@read:<resource>' and '@write:<resource>' words, which aren't passed to the command:
+
+    load_textures ui @write:textures
+    load_textures world @write:textures
+    load_level forest @read:textures @write:level
+    set_volume 0.5
+
+    Script_Scheduler scheduler(commands);
+    scheduler.declare_resources("set_volume", { {}, { "audio" } });
+
+    std::vector<Script_Command> script;
+    if (scheduler.parse(text, script))
+    {
+        Script_Report report = scheduler.run(script);
+        std::cout << to_string(report) << '\n';
+    }
+
+Each command waits for the earlier commands writing what it reads, and for the earlier commands
+reading or writing what it writes. Commands without any declared resources might touch anything:
+they wait for everything before them, and everything after them waits for them.
+*/
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <format>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "function_finder/function_finder.hpp"
+
+/// <summary>
+/// The resources a command reads and writes. Resources are just names, they mean whatever the
+/// program wants them to.
+/// </summary>
+struct Script_Resources
+{
+	std::vector<std::string> reads;
+	std::vector<std::string> writes;
+};
+
+/// <summary>
+/// One parsed line of a script.
+/// </summary>
+struct Script_Command
+{
+	std::string name;
+	std::vector<std::string> args;
+
+	/// <summary>
+	/// Line in the script, starting at 1.
+	/// </summary>
+	size_t line = 0;
+
+	Function_Wrapper function = nullptr;
+
+	/// <summary>
+	/// The declared resources and the line's annotations combined.
+	/// </summary>
+	Script_Resources resources;
+
+	/// <summary>
+	/// Indices of the earlier commands this one has to wait for.
+	/// </summary>
+	std::vector<size_t> dependencies;
+};
+
+/// <summary>
+/// Result of one command of a script run.
+/// </summary>
+struct Script_Command_Result
+{
+	Call_Result result;
+
+	/// <summary>
+	/// When the command started, relative to the start of the run, and how long it took.
+	/// </summary>
+	std::chrono::nanoseconds start{};
+	std::chrono::nanoseconds duration{};
+};
+
+/// <summary>
+/// What a script run did and how long it took.
+/// </summary>
+struct Script_Report
+{
+	/// <summary>
+	/// Indexed like the commands of the script.
+	/// </summary>
+	std::vector<Script_Command_Result> results;
+
+	size_t threads = 0;
+
+	/// <summary>
+	/// Time from the first command starting to the last one finishing.
+	/// </summary>
+	std::chrono::nanoseconds wall_time{};
+
+	/// <summary>
+	/// Sum of the durations of all commands, which is about what running them one by one takes.
+	/// </summary>
+	std::chrono::nanoseconds total_command_time{};
+
+	/// <summary>
+	/// Duration of the longest chain of dependent commands. No number of threads runs the script
+	/// faster than this.
+	/// </summary>
+	std::chrono::nanoseconds critical_path_time{};
+
+	/// <summary>
+	/// Indices of the commands on the critical path, in order.
+	/// </summary>
+	std::vector<size_t> critical_path;
+
+	/// <summary>
+	/// Number of commands that didn't succeed. The other commands still ran.
+	/// </summary>
+	size_t failed_commands = 0;
+};
+
+/// <summary>
+/// Parses scripts into commands with their dependencies, and runs them on a thread pool.
+/// </summary>
+class Script_Scheduler
+{
+private:
+	const Function_Map &commands;
+	std::unordered_map<std::string, Script_Resources> declared_resources;
+
+public:
+	/// <summary>
+	/// The commands are read by all threads of a run, so they mustn't change while it runs.
+	/// </summary>
+	explicit Script_Scheduler(const Function_Map &commands)
+		: commands(commands)
+	{
+	}
+
+	/// <summary>
+	/// Declares the resources every call of a command touches, in addition to the ones annotated
+	/// in scripts. Declare the commands before parsing scripts using them.
+	/// </summary>
+	void declare_resources(const std::string &command_name, Script_Resources resources)
+	{
+		declared_resources[command_name] = std::move(resources);
+	}
+
+	/// <summary>
+	/// Parses a script and works out which commands depend on which.
+	/// </summary>
+	/// <returns>False if a line calls an unknown command or has a malformed annotation. The errors
+	/// are printed with their line numbers.</returns>
+	bool parse(std::string_view script, std::vector<Script_Command> &out_commands) const
+	{
+		bool success = true;
+		size_t line_number = 0;
+		while (!script.empty())
+		{
+			line_number++;
+			auto line_end = script.find('\n');
+			// A copy, so the parsing functions stop at the end of the line.
+			std::string line(script.substr(0, line_end));
+			script = line_end == std::string_view::npos ? std::string_view() : script.substr(line_end + 1);
+
+			Script_Command command;
+			command.line = line_number;
+			if (!parse_line(line, command, success))
+			{
+				continue;
+			}
+			out_commands.push_back(std::move(command));
+		}
+
+		if (success)
+		{
+			add_dependencies(out_commands);
+		}
+		return success;
+	}
+
+	/// <summary>
+	/// Runs parsed commands, each one as soon as the ones it depends on have finished.
+	/// </summary>
+	/// <param name="threads">Number of worker threads, 0 for one per hardware thread.</param>
+	Script_Report run(const std::vector<Script_Command> &script, size_t threads = 0) const
+	{
+		Script_Report report;
+		report.results.resize(script.size());
+		report.threads = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+		if (script.empty())
+		{
+			return report;
+		}
+
+		// Who waits for whom, the other way around.
+		std::vector<std::vector<size_t>> dependents(script.size());
+		std::vector<size_t> waiting_for(script.size());
+		std::deque<size_t> ready;
+		for (size_t i = 0; i < script.size(); i++)
+		{
+			waiting_for[i] = script[i].dependencies.size();
+			for (size_t dependency : script[i].dependencies)
+			{
+				dependents[dependency].push_back(i);
+			}
+			if (waiting_for[i] == 0)
+			{
+				ready.push_back(i);
+			}
+		}
+
+		std::mutex mutex;
+		std::condition_variable wake_up;
+		size_t finished = 0;
+		auto start = std::chrono::steady_clock::now();
+
+		auto work = [&]()
+			{
+				std::unique_lock lock(mutex);
+				while (true)
+				{
+					wake_up.wait(lock, [&]() { return !ready.empty() || finished == script.size(); });
+					if (ready.empty())
+					{
+						return;
+					}
+					size_t index = ready.front();
+					ready.pop_front();
+					lock.unlock();
+
+					// The wrapper may modify the arguments, and the script may be run again.
+					const Script_Command &command = script[index];
+					std::vector<std::string> args = command.args;
+					Script_Command_Result &result = report.results[index];
+					auto command_start = std::chrono::steady_clock::now();
+					result.result = command.function(args, true);
+					auto command_end = std::chrono::steady_clock::now();
+					result.start = command_start - start;
+					result.duration = command_end - command_start;
+
+					lock.lock();
+					finished++;
+					for (size_t dependent : dependents[index])
+					{
+						if (--waiting_for[dependent] == 0)
+						{
+							ready.push_back(dependent);
+						}
+					}
+					wake_up.notify_all();
+				}
+			};
+
+		{
+			std::vector<std::jthread> workers;
+			for (size_t i = 0; i < report.threads; i++)
+			{
+				workers.emplace_back(work);
+			}
+		}
+
+		report.wall_time = std::chrono::steady_clock::now() - start;
+		add_critical_path(script, report);
+		return report;
+	}
+
+private:
+	/// <summary>
+	/// Parses one line into command. Sets inout_success to false on errors.
+	/// </summary>
+	/// <returns>Whether the line has a command.</returns>
+	bool parse_line(std::string_view line, Script_Command &command, bool &inout_success) const
+	{
+		line = skip_whitespace(line);
+		if (line.empty() || line[0] == '#' || line[0] == '\r')
+		{
+			return false;
+		}
+
+		bool has_name = false;
+		while (!line.empty())
+		{
+			std::string word;
+			size_t length = get_string(line, word);
+			if (!length)
+			{
+				std::cerr << std::format("[ERROR] Script line {}: Unterminated quote\n", command.line);
+				inout_success = false;
+				return false;
+			}
+			line = skip_whitespace(advance(line, length));
+
+			if (!has_name)
+			{
+				command.name = std::move(word);
+				has_name = true;
+			}
+			else if (word.starts_with("@read:") && word.size() > sizeof("@read:") - 1)
+			{
+				command.resources.reads.push_back(word.substr(sizeof("@read:") - 1));
+			}
+			else if (word.starts_with("@write:") && word.size() > sizeof("@write:") - 1)
+			{
+				command.resources.writes.push_back(word.substr(sizeof("@write:") - 1));
+			}
+			else if (word.starts_with("@"))
+			{
+				std::cerr << std::format("[ERROR] Script line {}: Unknown annotation '{}'. Use "
+					"'@read:<resource>' or '@write:<resource>'\n", command.line, word);
+				inout_success = false;
+			}
+			else
+			{
+				command.args.push_back(std::move(word));
+			}
+		}
+
+		auto found = commands.find(command.name);
+		if (found == commands.end())
+		{
+			std::cerr << std::format("[ERROR] Script line {}: Unknown command '{}'\n", command.line,
+				command.name);
+			inout_success = false;
+			return false;
+		}
+		command.function = found->second.function;
+
+		auto declared = declared_resources.find(command.name);
+		if (declared != declared_resources.end())
+		{
+			auto &[reads, writes] = declared->second;
+			command.resources.reads.insert(command.resources.reads.end(), reads.begin(), reads.end());
+			command.resources.writes.insert(command.resources.writes.end(), writes.begin(), writes.end());
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Fills in the dependencies of all commands.
+	/// </summary>
+	static void add_dependencies(std::vector<Script_Command> &inout_commands)
+	{
+		struct Resource_Users
+		{
+			size_t last_writer = SIZE_MAX;
+
+			/// <summary>
+			/// Readers since the last writer.
+			/// </summary>
+			std::vector<size_t> readers;
+		};
+
+		// Commands without declared resources write a resource every other command reads, which
+		// orders them against everything.
+		Resource_Users everything;
+		std::unordered_map<std::string_view, Resource_Users> resources;
+
+		auto read = [](Resource_Users &users, size_t index, std::vector<size_t> &out_dependencies)
+			{
+				if (users.last_writer != SIZE_MAX)
+				{
+					out_dependencies.push_back(users.last_writer);
+				}
+				users.readers.push_back(index);
+			};
+		auto write = [](Resource_Users &users, size_t index, std::vector<size_t> &out_dependencies)
+			{
+				if (users.last_writer != SIZE_MAX)
+				{
+					out_dependencies.push_back(users.last_writer);
+				}
+				out_dependencies.insert(out_dependencies.end(), users.readers.begin(), users.readers.end());
+				users.last_writer = index;
+				users.readers.clear();
+			};
+
+		for (size_t i = 0; i < inout_commands.size(); i++)
+		{
+			Script_Command &command = inout_commands[i];
+			std::vector<size_t> &dependencies = command.dependencies;
+			const Script_Resources &used = command.resources;
+			if (used.reads.empty() && used.writes.empty())
+			{
+				write(everything, i, dependencies);
+			}
+			else
+			{
+				read(everything, i, dependencies);
+				for (const auto &resource : used.reads)
+				{
+					read(resources[resource], i, dependencies);
+				}
+				for (const auto &resource : used.writes)
+				{
+					write(resources[resource], i, dependencies);
+				}
+			}
+
+			// Reading and writing the same resource makes a command its own reader.
+			std::erase(dependencies, i);
+			std::sort(dependencies.begin(), dependencies.end());
+			dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+		}
+	}
+
+	/// <summary>
+	/// Finds the chain of dependent commands that took the longest, and sums up the command times.
+	/// </summary>
+	static void add_critical_path(const std::vector<Script_Command> &script, Script_Report &inout_report)
+	{
+		// Dependencies always come earlier in the script, so one pass in order is enough.
+		std::vector<std::chrono::nanoseconds> path_time(script.size());
+		std::vector<size_t> previous(script.size(), SIZE_MAX);
+		size_t last = 0;
+		for (size_t i = 0; i < script.size(); i++)
+		{
+			const Script_Command_Result &result = inout_report.results[i];
+			inout_report.total_command_time += result.duration;
+			if (result.result.status != Call_Result_Status::SUCCESS)
+			{
+				inout_report.failed_commands++;
+			}
+
+			for (size_t dependency : script[i].dependencies)
+			{
+				if (path_time[dependency] > path_time[i])
+				{
+					path_time[i] = path_time[dependency];
+					previous[i] = dependency;
+				}
+			}
+			path_time[i] += result.duration;
+			if (path_time[i] > path_time[last])
+			{
+				last = i;
+			}
+		}
+
+		inout_report.critical_path_time = path_time[last];
+		for (size_t i = last; i != SIZE_MAX; i = previous[i])
+		{
+			inout_report.critical_path.push_back(i);
+		}
+		std::reverse(inout_report.critical_path.begin(), inout_report.critical_path.end());
+	}
+};
+
+/// <summary>
+/// One line summary of a script run.
+/// </summary>
+inline std::string to_string(const Script_Report &report)
+{
+	auto ms = [](std::chrono::nanoseconds time) { return std::chrono::duration<double, std::milli>(time).count(); };
+	double speedup = report.wall_time.count() ?
+		(double)report.total_command_time.count() / (double)report.wall_time.count() : 1.0;
+	return std::format("{} commands on {} threads in {:.2f} ms ({:.2f} ms of commands, {:.1f}x), "
+		"critical path {:.2f} ms over {} commands, {} failed", report.results.size(), report.threads,
+		ms(report.wall_time), ms(report.total_command_time), speedup, ms(report.critical_path_time),
+		report.critical_path.size(), report.failed_commands);
+}
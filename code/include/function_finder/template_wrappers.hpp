@@ -0,0 +1,360 @@
+/*
+Runtime support for '--wrappers=template'. Instead of a hand-written parser per command, the
+generated file instantiates \ref template_wrapper once per command, in a single line:
+
+    inline constexpr Function_Wrapper _w_add = &template_wrapper<"add a b", &add, 5>;
+
+The per-command part only fills in default values and calls the client function. Argument parsing
+and error reporting are instantiated per distinct argument list, so all commands taking, say, an
+int and a std::string share one copy of that code.
+
+Needs a compiler supporting class and floating point template arguments (C++20).
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "function_finder/function_finder.hpp"
+
+/// <summary>
+/// A string that can be passed as a template argument. Used for command signatures and string
+/// default values.
+/// </summary>
+template <size_t N>
+struct Fixed_String
+{
+	char data[N] = {};
+
+	constexpr Fixed_String(const char (&source)[N])
+	{
+		std::copy_n(source, N, data);
+	}
+
+	constexpr std::string_view view() const
+	{
+		return { data, N - 1 };
+	}
+};
+
+/// <summary>
+/// How arguments are stored and parsed, per storage type. See \ref Template_Argument_Storage for
+/// the storage type of each supported argument type.
+/// </summary>
+template <typename T>
+struct Template_Argument_Traits;
+
+template <>
+struct Template_Argument_Traits<int>
+{
+	static constexpr Value_Type type = Value_Type::INTEGER;
+	static bool parse(std::string_view source, int &out_value) { return get_int(source, out_value) != 0; }
+};
+
+template <>
+struct Template_Argument_Traits<float>
+{
+	static constexpr Value_Type type = Value_Type::FLOAT;
+	static bool parse(std::string_view source, float &out_value) { return get_float(source, out_value) != 0; }
+};
+
+template <>
+struct Template_Argument_Traits<double>
+{
+	static constexpr Value_Type type = Value_Type::DOUBLE;
+	static bool parse(std::string_view source, double &out_value) { return get_double(source, out_value) != 0; }
+};
+
+template <>
+struct Template_Argument_Traits<bool>
+{
+	static constexpr Value_Type type = Value_Type::BOOLEAN;
+	static bool parse(std::string_view source, bool &out_value) { return get_bool(source, out_value) != 0; }
+};
+
+template <>
+struct Template_Argument_Traits<std::string>
+{
+	static constexpr Value_Type type = Value_Type::STRING;
+
+	static bool parse(std::string_view source, std::string &out_value)
+	{
+		out_value = source;
+		return true;
+	}
+};
+
+template <>
+struct Template_Argument_Traits<std::vector<int>>
+{
+	static constexpr Value_Type type = Value_Type::INTEGER_ARRAY;
+	static bool parse(std::string_view source, std::vector<int> &out_value) { return get_int_array(source, out_value) != 0; }
+};
+
+template <>
+struct Template_Argument_Traits<std::vector<float>>
+{
+	static constexpr Value_Type type = Value_Type::FLOAT_ARRAY;
+	static bool parse(std::string_view source, std::vector<float> &out_value) { return get_float_array(source, out_value) != 0; }
+};
+
+template <>
+struct Template_Argument_Traits<std::vector<double>>
+{
+	static constexpr Value_Type type = Value_Type::DOUBLE_ARRAY;
+	static bool parse(std::string_view source, std::vector<double> &out_value) { return get_double_array(source, out_value) != 0; }
+};
+
+/// <summary>
+/// The type an argument is parsed into, and how it's passed to the client function. Lists are
+/// parsed into a std::vector, which std::span arguments view.
+/// </summary>
+template <typename T>
+struct Template_Argument_Storage
+{
+	using Type = std::remove_cvref_t<T>;
+
+	static Type &&pass(Type &value) { return std::move(value); }
+};
+
+template <typename T>
+struct Template_Argument_Storage<std::span<T>>
+{
+	using Type = std::vector<std::remove_const_t<T>>;
+
+	// Not moved, a std::span of mutable elements can't view a temporary.
+	static std::span<T> pass(Type &value) { return value; }
+};
+
+/// <summary>
+/// One parsed argument in a \ref Template_Argument_List.
+/// </summary>
+template <size_t I, typename T>
+struct Template_Argument_Slot
+{
+	T value{};
+};
+
+/// <summary>
+/// The parsed arguments of a call. A flat struct rather than a std::tuple, which is much more
+/// expensive to instantiate for every distinct argument list.
+/// </summary>
+template <typename Indices, typename... T>
+struct Template_Argument_List;
+
+template <size_t... I, typename... T>
+struct Template_Argument_List<std::index_sequence<I...>, T...> : Template_Argument_Slot<I, T>...
+{
+};
+
+/// <summary>
+/// Returns argument I of a \ref Template_Argument_List.
+/// </summary>
+template <size_t I, typename T>
+T &get_template_argument(Template_Argument_Slot<I, T> &slot)
+{
+	return slot.value;
+}
+
+/// <summary>
+/// Splits the type of a client function pointer into the parts the wrapper needs.
+/// </summary>
+template <typename Function>
+struct Template_Function_Traits;
+
+template <typename Return, typename... Arguments>
+struct Template_Function_Traits<Return (*)(Arguments...)>
+{
+	using Result = Return;
+	using Storage = Template_Argument_List<std::index_sequence_for<Arguments...>,
+		typename Template_Argument_Storage<Arguments>::Type...>;
+	static constexpr size_t argument_count = sizeof...(Arguments);
+
+	/// <summary>
+	/// Calls the client function, moving the parsed arguments into it.
+	/// </summary>
+	template <auto Function, size_t... I, typename... T>
+	static decltype(auto) call(Template_Argument_List<std::index_sequence<I...>, T...> &arguments)
+	{
+		return Function(Template_Argument_Storage<Arguments>::pass(get_template_argument<I, T>(arguments))...);
+	}
+};
+
+template <typename Return, typename... Arguments>
+struct Template_Function_Traits<Return (*)(Arguments...) noexcept>
+	: Template_Function_Traits<Return (*)(Arguments...)>
+{
+};
+
+/// <summary>
+/// Returns the word at index in a space separated signature like "add a b". Word 0 is the command
+/// name, the others are the argument names.
+/// </summary>
+inline std::string_view get_signature_word(std::string_view signature, size_t index)
+{
+	for (size_t i = 0; i < index; i++)
+	{
+		signature = signature.substr(std::min(signature.find(' '), signature.size() - 1) + 1);
+	}
+	return signature.substr(0, signature.find(' '));
+}
+
+/// <summary>
+/// Parses the provided arguments into inout_arguments, leaving the defaults of arguments that
+/// weren't provided. Instantiated once per argument list, shared by all commands with it.
+/// </summary>
+/// <returns>True if enough arguments were provided and all of them could be parsed. Otherwise
+/// the error is set in out_result.</returns>
+/// <remarks>Never inlined, since the point is that commands share it.</remarks>
+template <size_t... I, typename... T>
+FUNCTION_FINDER_NOINLINE bool parse_template_arguments(const std::vector<std::string> &args,
+	size_t num_required_args, std::string_view signature,
+	Template_Argument_List<std::index_sequence<I...>, T...> &inout_arguments, Call_Result &out_result)
+{
+	if (args.size() < num_required_args) [[unlikely]]
+	{
+		set_not_enough_arguments_error(out_result, get_signature_word(signature, 0), num_required_args,
+			args.size());
+		return false;
+	}
+
+	// Stops at the first argument that fails to parse. Cast, the fold is just 'true' without arguments.
+	size_t failed_index = sizeof...(T);
+	(void)((I >= args.size() ||
+		Template_Argument_Traits<T>::parse(args[I], get_template_argument<I, T>(inout_arguments)) ||
+		(failed_index = I, false)) && ...);
+
+	if (failed_index != sizeof...(T)) [[unlikely]]
+	{
+		constexpr Value_Type types[] = { Template_Argument_Traits<T>::type..., Value_Type::UNKNOWN };
+		set_argument_parsing_error(out_result, failed_index, get_signature_word(signature, failed_index + 1),
+			types[failed_index], args[failed_index]);
+		return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// Template arguments are passed as is, except strings, which are wrapped in a \ref Fixed_String.
+/// </summary>
+template <typename T>
+constexpr const T &template_default_value(const T &value)
+{
+	return value;
+}
+
+template <size_t N>
+constexpr std::string_view template_default_value(const Fixed_String<N> &value)
+{
+	return value.view();
+}
+
+/// <summary>
+/// Sets the arguments starting at Index to the given default values.
+/// </summary>
+template <size_t Index, typename List>
+void set_template_defaults(List &)
+{
+}
+
+template <size_t Index, typename List, typename Default, typename... Rest>
+void set_template_defaults(List &arguments, const Default &value, const Rest &...rest)
+{
+	auto &argument = get_template_argument<Index>(arguments);
+	argument = static_cast<std::remove_reference_t<decltype(argument)>>(template_default_value(value));
+	set_template_defaults<Index + 1>(arguments, rest...);
+}
+
+/// <summary>
+/// Calls the client function with the parsed arguments, see \ref Template_Function_Traits::call.
+/// </summary>
+template <auto Function, typename List>
+decltype(auto) call_template_function(List &arguments)
+{
+	return Template_Function_Traits<decltype(Function)>::template call<Function>(arguments);
+}
+
+/// <summary>
+/// Stores the client function's result like a full wrapper does.
+/// </summary>
+template <typename Result>
+void store_template_result(Call_Result &out_result, Result &&value)
+{
+	using Type = std::remove_cvref_t<Result>;
+	if constexpr (std::is_same_v<Type, std::string>)
+	{
+		out_result.string_value = std::move(value);
+		set_string_value(out_result.value, out_result.string_value);
+	}
+	else if constexpr (std::is_same_v<Type, int>)
+	{
+		out_result.value.data.int_value = value;
+	}
+	else if constexpr (std::is_same_v<Type, float>)
+	{
+		out_result.value.data.float_value = value;
+	}
+	else if constexpr (std::is_same_v<Type, double>)
+	{
+		out_result.value.data.double_value = value;
+	}
+	else
+	{
+		static_assert(std::is_same_v<Type, bool>, "Unsupported return type");
+		out_result.value.data.bool_value = value;
+	}
+}
+
+/// <summary>
+/// A wrapper for a client function, equivalent to the ones generated without '--wrappers=template'.
+/// </summary>
+/// <typeparam name="Signature">The command name followed by the argument names, separated by
+/// spaces. Only used for error messages.</typeparam>
+/// <typeparam name="Function">Pointer to the client function.</typeparam>
+/// <typeparam name="Defaults">Default values of the trailing arguments.</typeparam>
+template <Fixed_String Signature, auto Function, auto... Defaults>
+Call_Result template_wrapper(std::vector<std::string> &args, bool call_client_function)
+{
+	using Traits = Template_Function_Traits<decltype(Function)>;
+	using Result = typename Traits::Result;
+	constexpr size_t num_required_args = Traits::argument_count - sizeof...(Defaults);
+
+	Call_Result call_result;
+	typename Traits::Storage arguments;
+	set_template_defaults<num_required_args>(arguments, Defaults...);
+
+	if (!parse_template_arguments(args, num_required_args, Signature.view(), arguments, call_result))
+	{
+		return call_result;
+	}
+
+	if constexpr (std::is_void_v<Result>)
+	{
+		call_result.value.type = Value_Type::VOID;
+	}
+	else
+	{
+		call_result.value.type = Template_Argument_Traits<std::remove_cvref_t<Result>>::type;
+	}
+	call_result.status = Call_Result_Status::SUCCESS;
+	if (!call_client_function)
+	{
+		return call_result;
+	}
+
+	if constexpr (std::is_void_v<Result>)
+	{
+		call_template_function<Function>(arguments);
+	}
+	else
+	{
+		store_template_result(call_result, call_template_function<Function>(arguments));
+	}
+	return call_result;
+}
@@ -0,0 +1,102 @@
+/*
+Command line entry point of Function Finder. The tool itself lives in "function_finder.cpp" so it
+can be linked into other programs, like the benchmarks.
+See "include/function_finder/function_finder.hpp" for usage guide.
+Copyright Daniel 2023
+*/
+
+#include "function_finder_internal.hpp"
+
+#ifdef FUNCTION_FINDER_TRACK_ALLOCATIONS
+// Feeds the allocation counts reported by '--stats'.
+FUNCTION_FINDER_ALLOCATION_HOOKS
+#endif
+
+/// <summary>
+/// These are the possible exit codes and their meanings.
+/// </summary>
+struct Return_Codes
+{
+	enum Enum
+	{
+		// No errors reported
+		SUCCESS = 0,
+		// Incorrect arguments.
+		ERROR_INSUFFICIENT_ARGUMENTS = 1,
+		// Unrecognized option after the positional arguments.
+		ERROR_UNKNOWN_OPTION = 2,
+	};
+};
+
+int main(int arg_count, const char **args)
+{
+	// Parse arguments
+	if (arg_count < 2)
+	{
+		std::cerr << "[ERROR] Insufficient arguments. See '--help' for usage guide.\n";
+        return Return_Codes::ERROR_INSUFFICIENT_ARGUMENTS;
+	}
+
+	std::string_view arg_1 = args[1];
+
+
+	if (arg_1 == "--help")
+	{
+		print_help();
+	}
+	else if (arg_1 == "--experimental")
+	{
+		print_experimental();
+	}
+	else if (arg_1 == "--extensions")
+	{
+		print_extensions();
+	}
+	else if (arg_1 == "--example")
+	{
+		print_example();
+	}
+	else if (arg_count < 6)
+	{
+		std::cerr << "[ERROR] Needs a input path, output path, search_term, "
+			"init_function name, and wrapper function prefix as arguments. Terminating.\n";
+	
+		return Return_Codes::ERROR_INSUFFICIENT_ARGUMENTS;
+	}
+	else
+	{	
+		// Save settings
+		Settings settings;
+		settings.source = arg_1;
+		settings.destination = args[2];
+		settings.search_term = args[3];
+		settings.init_function_name = args[4];
+		settings.wrapper_function_prefix = args[5];
+
+		// Everything after the positional arguments are options.
+		for (int i = 6; i < arg_count; i++)
+		{
+			if (!parse_option(args[i], settings))
+			{
+				std::cerr << std::format("[ERROR] Unknown option '{}'. See '--help' for usage guide.\n",
+					args[i]);
+				return Return_Codes::ERROR_UNKNOWN_OPTION;
+			}
+		}
+
+		Import_Arena arena;
+		std::vector<Parsed_Function> functions;
+		Run_Stats stats;
+		import_functions(settings, arena, functions, stats);
+
+		export_functions(settings, functions, stats);
+
+		if (settings.stats_format != Stats_Format::NONE)
+		{
+			print_stats(settings, stats);
+		}
+
+	}
+
+	return Return_Codes::SUCCESS;
+}
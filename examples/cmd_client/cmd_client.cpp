@@ -4,20 +4,50 @@
 #include <string>
 #include <cstring>
 #include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <chrono>
+#include <thread>
 
 #include "function_finder/function_finder.hpp"
+#include "function_finder/instrumentation.hpp"
+#include "function_finder/command_task.hpp"
+#include "function_finder/memoization.hpp"
+#include "function_finder/script_scheduler.hpp"
+#include "function_finder/pipeline.hpp"
+#include "function_finder/command_journal.hpp"
 #include "cmd_client.hpp"
 #include "console_commands_out.hpp"
 
+#ifdef FUNCTION_FINDER_TRACK_ALLOCATIONS
+// Lets 'stats' show allocations per call.
+FUNCTION_FINDER_ALLOCATION_HOOKS
+#endif
+
 // Returns true if a built command was run.
 void run_help_command(std::string_view line, Function_Map &commands);
 void run_where_command(std::string_view line, Function_Map &commands);
-void run_custom_command(std::string_view line, Function_Map &commands);
+void run_stats_command(std::string_view line, Function_Map &commands);
+void run_trace_command(std::string_view line);
+void run_script_command(std::string_view line, Function_Map &commands);
+void run_pipeline_command(std::string_view line, Function_Map &commands);
+void run_journal_command(std::string_view line);
+void run_replay_command(std::string_view line, Function_Map &commands);
+void run_custom_command(std::string_view line, Function_Map &commands,
+	std::vector<std::pair<std::string, Call_Task>> &inout_running_commands);
+void print_finished_commands(std::vector<std::pair<std::string, Call_Task>> &inout_running_commands);
+void print_call_result(const Call_Result &result);
 bool convert_string_to_arg_list(std::string_view source, std::vector<std::string> &out_args);
 void print_unknown_command(std::string_view command_name);
 
 const std::string WHERE_COMMAND = "where";
 const std::string HELP_COMMAND = "help";
+const std::string STATS_COMMAND = "stats";
+const std::string TRACE_COMMAND = "trace";
+const std::string SCRIPT_COMMAND = "script";
+const std::string JOURNAL_COMMAND = "journal";
+const std::string REPLAY_COMMAND = "replay";
 const std::string EXIT_COMMAND = "exit";
 
 int main(int arg_c, const char **args)
@@ -25,9 +55,14 @@ int main(int arg_c, const char **args)
 	Function_Map commands;
 	init_console_commands(commands);
 
+	// Asynchronous commands running in the background, and their names.
+	std::vector<std::pair<std::string, Call_Task>> running_commands;
+
 	std::string line;
 	while (true)
 	{
+		print_finished_commands(running_commands);
+
 		std::cout << ">";
 		auto more = (bool)std::getline(std::cin, line);
 		if (!more)
@@ -52,7 +87,43 @@ int main(int arg_c, const char **args)
 			continue;
 		}
 
-		run_custom_command(line, commands);
+		if (line.starts_with(STATS_COMMAND))
+		{
+			run_stats_command(line, commands);
+			continue;
+		}
+
+		if (line.starts_with(TRACE_COMMAND))
+		{
+			run_trace_command(line);
+			continue;
+		}
+
+		if (line.starts_with(SCRIPT_COMMAND))
+		{
+			run_script_command(line, commands);
+			continue;
+		}
+
+		if (line.starts_with(JOURNAL_COMMAND))
+		{
+			run_journal_command(line);
+			continue;
+		}
+
+		if (line.starts_with(REPLAY_COMMAND))
+		{
+			run_replay_command(line, commands);
+			continue;
+		}
+
+		if (line.find('|') != std::string::npos)
+		{
+			run_pipeline_command(line, commands);
+			continue;
+		}
+
+		run_custom_command(line, commands, running_commands);
 	}
 
 	return 0;
@@ -80,6 +151,165 @@ void run_where_command(std::string_view line, Function_Map &commands)
 	}
 }
 
+void run_stats_command(std::string_view line, Function_Map &commands)
+{
+	if (line == STATS_COMMAND + " reset")
+	{
+		reset_call_stats();
+		std::cout << "Command statistics have been reset\n";
+		return;
+	}
+
+	if (line == STATS_COMMAND + " forget")
+	{
+		invalidate_memoized_results();
+		std::cout << "Cached results of memoized commands have been dropped\n";
+		return;
+	}
+
+	std::vector<Call_Stats> all_stats = collect_call_stats(commands);
+	std::sort(all_stats.begin(), all_stats.end(), [](const Call_Stats &a, const Call_Stats &b)
+		{ return a.call_count > b.call_count; });
+
+	std::cout << "Command statistics (most called first). Use 'stats reset' to start over:\n";
+	for (const auto &stats : all_stats)
+	{
+		std::cout << " - " << to_string(stats) << '\n';
+	}
+
+	std::vector<Memo_Stats> memo_stats = collect_memo_stats();
+	if (!memo_stats.empty())
+	{
+		std::cout << "Memoized commands. Use 'stats forget' to drop their cached results:\n";
+		for (const auto &stats : memo_stats)
+		{
+			std::cout << " - " << to_string(stats) << '\n';
+		}
+	}
+}
+
+void run_trace_command(std::string_view line)
+{
+	if (line.size() <= TRACE_COMMAND.size() + 1)
+	{
+		std::cout << "Type 'trace <file>' to save the recent command calls as a Chrome trace\n";
+		return;
+	}
+
+	std::string path(line.begin() + TRACE_COMMAND.size() + 1, line.end());
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		std::cout << std::format("Could not open \"{}\" for writing\n", path);
+		return;
+	}
+
+	write_chrome_trace(file);
+	std::cout << std::format("Saved trace to \"{}\". Open it in chrome://tracing or "
+		"https://ui.perfetto.dev\n", path);
+}
+
+void run_script_command(std::string_view line, Function_Map &commands)
+{
+	if (line.size() <= SCRIPT_COMMAND.size() + 1)
+	{
+		std::cout << "Type 'script <file>' to run a file of commands, in parallel where their "
+			"'@read:<resource>' and '@write:<resource>' annotations allow it\n";
+		return;
+	}
+
+	std::string path(line.begin() + SCRIPT_COMMAND.size() + 1, line.end());
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cout << std::format("Could not open \"{}\"\n", path);
+		return;
+	}
+	std::string text{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+	Script_Scheduler scheduler(commands);
+	std::vector<Script_Command> script;
+	if (!scheduler.parse(text, script))
+	{
+		return;
+	}
+
+	Script_Report report = scheduler.run(script);
+	for (size_t i = 0; i < script.size(); i++)
+	{
+		const Call_Result &result = report.results[i].result;
+		if (result.status != Call_Result_Status::SUCCESS)
+		{
+			std::cout << std::format("Line {}: {}\n", script[i].line, result.error_message);
+		}
+	}
+	std::cout << to_string(report) << '\n';
+}
+
+void run_journal_command(std::string_view line)
+{
+	if (line == JOURNAL_COMMAND + " stop")
+	{
+		uint64_t size = stop_command_journal();
+		std::cout << std::format("Stopped recording. The journal is {} bytes\n", size);
+		return;
+	}
+
+	if (line.size() <= JOURNAL_COMMAND.size() + 1)
+	{
+		std::cout << "Type 'journal <file>' to record the commands you call, 'journal stop' to stop, "
+			"and 'replay <file>' to run them again\n";
+		return;
+	}
+
+	std::string path(line.begin() + JOURNAL_COMMAND.size() + 1, line.end());
+	if (start_command_journal(path))
+	{
+		std::cout << std::format("Recording commands to \"{}\"\n", path);
+	}
+}
+
+void run_replay_command(std::string_view line, Function_Map &commands)
+{
+	if (line.size() <= REPLAY_COMMAND.size() + 1)
+	{
+		std::cout << "Type 'replay <file>' to run the commands recorded with 'journal <file>' again\n";
+		return;
+	}
+
+	// Replayed calls would be recorded again.
+	if (is_command_journal_recording())
+	{
+		std::cout << "Stop recording with 'journal stop' before replaying\n";
+		return;
+	}
+
+	std::string path(line.begin() + REPLAY_COMMAND.size() + 1, line.end());
+	Journal_Replay_Stats stats;
+	if (replay_command_journal(path, commands, stats))
+	{
+		std::cout << to_string(stats) << '\n';
+	}
+}
+
+void run_pipeline_command(std::string_view line, Function_Map &commands)
+{
+	// Checks that the commands exist and fit together before running any of them.
+	std::vector<Pipeline_Stage> pipeline;
+	if (!parse_pipeline(line, commands, pipeline))
+	{
+		return;
+	}
+
+	Call_Result result = run_pipeline(pipeline);
+	if (result.status != Call_Result_Status::SUCCESS)
+	{
+		std::cout << result.error_message << '\n';
+		return;
+	}
+	print_call_result(result);
+}
+
 void run_help_command(std::string_view line, Function_Map &commands)
 {
 	if (line == HELP_COMMAND)
@@ -92,6 +322,13 @@ void run_help_command(std::string_view line, Function_Map &commands)
 
 		std::cout << "You can get more details about a command with 'help <command>' or "
 			" 'where <command>'\n";
+		std::cout << "Type 'stats' to see how often each command has been called and how long "
+			"it took, or 'trace <file>' to save a timeline of the recent calls\n";
+		std::cout << "Type 'script <file>' to run a file of commands\n";
+		std::cout << "Type 'journal <file>' to record the commands you call, and 'replay <file>' to "
+			"run them again\n";
+		std::cout << "Chain commands with '|', like 'add 1 2 | multiply', to pass a result on as the "
+			"first argument of the next command\n";
 		return;
 	}
 
@@ -153,7 +390,8 @@ void run_help_command(std::string_view line, Function_Map &commands)
 	}
 }
 
-void run_custom_command(std::string_view line, Function_Map &commands)
+void run_custom_command(std::string_view line, Function_Map &commands,
+	std::vector<std::pair<std::string, Call_Task>> &inout_running_commands)
 {
 	std::vector<std::string> args;
 	bool success = convert_string_to_arg_list(line.data(), args);
@@ -185,12 +423,19 @@ void run_custom_command(std::string_view line, Function_Map &commands)
 		}
 
 		std::cout << "NO ERRORS! We're proceding to actually call!\n";
-		Call_Result result = commands[function_name].function(args, true);
-		if (result.value.type != Value_Type::VOID)
+
+		// Asynchronous commands run in the background, so the console stays usable.
+		if (commands[function_name].async_function)
 		{
-			std::cout << to_string(result.value);
-			std::cout << "\n";
+			inout_running_commands.emplace_back(function_name,
+				commands[function_name].async_function(args, true));
+			std::cout << std::format("Started \"{}\" in the background. Its result is printed once "
+				"it's done.\n", function_name);
+			return;
 		}
+
+		Call_Result result = commands[function_name].function(args, true);
+		print_call_result(result);
 	}
 	else
 	{
@@ -198,6 +443,36 @@ void run_custom_command(std::string_view line, Function_Map &commands)
 	}
 }
 
+void print_finished_commands(std::vector<std::pair<std::string, Call_Task>> &inout_running_commands)
+{
+	for (auto it = inout_running_commands.begin(); it != inout_running_commands.end();)
+	{
+		if (!it->second.is_ready())
+		{
+			++it;
+			continue;
+		}
+
+		std::cout << std::format("\"{}\" finished:\n", it->first);
+		print_call_result(it->second.wait());
+		it = inout_running_commands.erase(it);
+	}
+}
+
+void print_call_result(const Call_Result &result)
+{
+	if (result.value.type == Value_Type::STRING)
+	{
+		// The full result, value.data.string_value might be truncated.
+		std::cout << std::format("\"{}\"\n", result.string_value);
+	}
+	else if (result.value.type != Value_Type::VOID)
+	{
+		std::cout << to_string(result.value);
+		std::cout << "\n";
+	}
+}
+
 bool convert_string_to_arg_list(std::string_view source, std::vector<std::string> &out_args)
 {
 	size_t max_length = source.size();
@@ -233,6 +508,42 @@ void print_unknown_command(std::string_view command_name)
 
 // COMMANDS
 
+// Resumes the awaiting coroutine on a new thread after a delay. Stands in for whatever a real
+// program waits for, like a loading screen or a job system.
+struct Resume_After
+{
+	std::chrono::milliseconds delay;
+
+	bool await_ready() const { return delay.count() <= 0; }
+
+	void await_suspend(std::coroutine_handle<> handle) const
+	{
+		std::thread([handle, delay = delay]()
+			{
+				std::this_thread::sleep_for(delay);
+				handle.resume();
+			}).detach();
+	}
+
+	void await_resume() const {}
+};
+
+CONSOLE_COMMAND // Counts to a number in the background, a tenth of a second per step. Try other commands meanwhile.
+Command_Task<int> count_slowly(int to)
+{
+	for (int i = 0; i < to; i++)
+	{
+		co_await Resume_After{ std::chrono::milliseconds(100) };
+	}
+	co_return to;
+}
+
+CONSOLE_COMMAND // Computes the nth Fibonacci number the slow way. Calling it again with the same n is instant.
+MEMOIZED int fibonacci(int n)
+{
+	return n < 2 ? n : fibonacci(n - 1) + fibonacci(n - 2);
+}
+
 
 CONSOLE_COMMAND/* Hello there. This function adds two numbers. a, and b.
 int
@@ -249,6 +560,40 @@ float add_f(float a, float b)
 	return a + b;
 }
 
+CONSOLE_COMMAND // Sums a list of numbers, like 'sum 1,2,3.5' or 'sum [1,2,3]'.
+float sum(std::vector<float> values)
+{
+	float result = 0;
+	for (float value : values)
+	{
+		result += value;
+	}
+	return result;
+}
+
+CONSOLE_COMMAND // Dot product of two lists of numbers of the same length.
+double dot(std::span<const double> a, std::span<const double> b)
+{
+	double result = 0;
+	for (size_t i = 0; i < a.size() && i < b.size(); i++)
+	{
+		result += a[i] * b[i];
+	}
+	return result;
+}
+
+CONSOLE_COMMAND // Middle value of a list of whole numbers, like 'median 5,1,3'. Reorders the list in place.
+int median(std::span<int> values)
+{
+	if (values.empty())
+	{
+		return 0;
+	}
+	auto middle = values.begin() + values.size() / 2;
+	std::nth_element(values.begin(), middle, values.end());
+	return *middle;
+}
+
 CONSOLE_COMMAND // String-appends a string 'a' with the float 'b'. Just a tester lmao
 std::string append(std::string a, float b)
 {
@@ -257,6 +602,18 @@ std::string append(std::string a, float b)
 	return result;
 }
 
+CONSOLE_COMMAND // Repeats a text. Results longer than 127 characters are returned in full.
+std::string repeat(std::string text, int count)
+{
+	std::string result;
+	result.reserve(text.size() * std::max(count, 0));
+	for (int i = 0; i < count; i++)
+	{
+		result += text;
+	}
+	return result;
+}
+
 CONSOLE_COMMAND // Does some fkin nonsense
 void complex(std::string base, int num_prints, bool capitalize = false, 
 	std::string to_print = "cringe", int indents = 4)
@@ -292,6 +649,12 @@ int multiply(int a, double b = 2.1 /*    B defaults to 2.1             */)
 	return b * b;
 }
 
+CONSOLE_COMMAND // Scales a number, then shifts it. Defaults to doubling it.
+double scale(double value, double factor = 2.0, float offset = 0.0f)
+{
+	return value * factor + offset;
+}
+
 int my_function(int a)
 {
 	std::cout << "Pee pee\n";
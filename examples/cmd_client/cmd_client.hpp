@@ -6,6 +6,9 @@
 #define CONSOLE_COMMAND
 #define CONSOLE_COMMAND_2
 
+// Commands that also have this tag cache their results, see '--memoize-tag'
+#define MEMOIZED
+
 // This command WILL be included in the search, because we're asking for everything in the 
 // examples/cmd_client directory,
 CONSOLE_COMMAND // Hello
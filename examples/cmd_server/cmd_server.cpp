@@ -0,0 +1,691 @@
+// Serves commands to other programs over a Unix domain socket. Linux only.
+//
+// Clients send one command per line, like they'd type it into a console, and get one response line
+// per command: 'OK' followed by the result, or 'ERROR' followed by the error message. Responses
+// come back in the order the commands were sent, so clients may send many commands without waiting
+// for the responses in between (pipelining). Try it with 'nc -U /tmp/function_finder.sock', or
+// measure it with cmd_server_load.
+//
+// One thread runs an epoll loop that accepts connections, reads requests and writes responses. The
+// commands run on a pool of worker threads: all complete lines read from a connection at once go to
+// a worker as one batch, and a connection has at most one batch running, which keeps its responses
+// in order. The more a client pipelines, the bigger its batches get, so the per-request overhead
+// of handing work between threads shrinks under load.
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "function_finder/function_finder.hpp"
+#include "function_finder/pipeline.hpp"
+
+// The search term for the served commands
+#define SERVER_COMMAND
+
+#include "server_commands_out.hpp"
+
+// Most requests a worker runs for a connection in one go. Limits how long one busy connection
+// keeps a worker from the others.
+constexpr size_t MAX_BATCH_SIZE = 256;
+
+// A connection stops being read while this much input or output is waiting, so clients that send
+// faster than they read their responses can't make the server buffer without bounds.
+constexpr size_t MAX_BUFFERED_BYTES = 1 << 20;
+
+// epoll ids of the listening socket and the worker wakeup. Connections count up from here.
+constexpr uint64_t LISTENER_ID = 0;
+constexpr uint64_t WAKEUP_ID = 1;
+
+struct Connection
+{
+	int fd = -1;
+
+	// Received bytes that haven't been handed to a worker yet.
+	std::string input;
+
+	// Responses that haven't been sent yet, from output_sent on.
+	std::string output;
+	size_t output_sent = 0;
+
+	// The epoll events the connection is registered for.
+	uint32_t events = 0;
+
+	bool batch_running = false;
+
+	// The client is done sending. The connection is closed once its requests are answered.
+	bool input_closed = false;
+
+	// The connection was closed while a batch was running. Dropped once the batch is done.
+	bool closed = false;
+};
+
+// Requests of one connection, run together by one worker.
+struct Batch
+{
+	uint64_t connection_id = 0;
+	std::string requests;
+	std::string responses;
+};
+
+// Runs batches on a fixed number of threads, and hands them back to the event loop.
+class Worker_Pool
+{
+private:
+	const Function_Map &commands;
+	int wakeup_fd;
+
+	std::mutex mutex;
+	std::condition_variable work_available;
+	std::deque<std::unique_ptr<Batch>> pending;
+	std::vector<std::unique_ptr<Batch>> done;
+	bool stopping = false;
+
+	std::vector<std::jthread> threads;
+
+public:
+	Worker_Pool(const Function_Map &commands, int wakeup_fd, size_t thread_count)
+		: commands(commands), wakeup_fd(wakeup_fd)
+	{
+		for (size_t i = 0; i < thread_count; i++)
+		{
+			threads.emplace_back([this]() { run_worker(); });
+		}
+	}
+
+	~Worker_Pool()
+	{
+		{
+			std::lock_guard lock(mutex);
+			stopping = true;
+		}
+		work_available.notify_all();
+		threads.clear();
+	}
+
+	void submit(std::unique_ptr<Batch> batch)
+	{
+		{
+			std::lock_guard lock(mutex);
+			pending.push_back(std::move(batch));
+		}
+		work_available.notify_one();
+	}
+
+	// Returns the batches that finished since the last call.
+	std::vector<std::unique_ptr<Batch>> take_done()
+	{
+		std::lock_guard lock(mutex);
+		return std::move(done);
+	}
+
+private:
+	void run_worker()
+	{
+		while (true)
+		{
+			std::unique_ptr<Batch> batch;
+			{
+				std::unique_lock lock(mutex);
+				work_available.wait(lock, [this]() { return stopping || !pending.empty(); });
+				if (stopping)
+				{
+					return;
+				}
+				batch = std::move(pending.front());
+				pending.pop_front();
+			}
+
+			run_batch(*batch);
+
+			bool was_empty;
+			{
+				std::lock_guard lock(mutex);
+				was_empty = done.empty();
+				done.push_back(std::move(batch));
+			}
+
+			// One wakeup is enough for any number of finished batches.
+			if (was_empty)
+			{
+				uint64_t one = 1;
+				(void)write(wakeup_fd, &one, sizeof(one));
+			}
+		}
+	}
+
+	void run_batch(Batch &batch)
+	{
+		std::string_view requests = batch.requests;
+		while (!requests.empty())
+		{
+			size_t end = requests.find('\n');
+			std::string_view line = requests.substr(0, end);
+			if (line.ends_with('\r'))
+			{
+				line.remove_suffix(1);
+			}
+			run_request(line, batch.responses);
+			requests.remove_prefix(end + 1);
+		}
+	}
+
+	void run_request(std::string_view line, std::string &out_responses)
+	{
+		std::vector<std::string> words;
+		if (!split_command_words(line, words))
+		{
+			out_responses += "ERROR The request is missing a closing quote\n";
+			return;
+		}
+		if (words.empty())
+		{
+			out_responses += "ERROR The request is empty\n";
+			return;
+		}
+
+		auto found = commands.find(words[0]);
+		if (found == commands.end())
+		{
+			out_responses += std::format("ERROR Unknown command \"{}\"\n", words[0]);
+			return;
+		}
+
+		words.erase(words.begin());
+		Call_Result result = found->second.function(words, true);
+
+		size_t start = out_responses.size();
+		if (result.status != Call_Result_Status::SUCCESS)
+		{
+			out_responses += "ERROR ";
+			out_responses += result.error_message;
+		}
+		else if (result.value.type == Value_Type::STRING)
+		{
+			out_responses += "OK ";
+			out_responses += result.string_value;
+		}
+		else if (result.value.type == Value_Type::VOID)
+		{
+			out_responses += "OK";
+		}
+		else
+		{
+			out_responses += "OK ";
+			out_responses += to_string(result.value);
+		}
+
+		// Responses are one line each.
+		std::replace(out_responses.begin() + start, out_responses.end(), '\n', ' ');
+		out_responses += '\n';
+	}
+};
+
+class Command_Server
+{
+private:
+	int epoll_fd;
+	int listen_fd;
+	int wakeup_fd;
+	Worker_Pool &workers;
+
+	std::unordered_map<uint64_t, Connection> connections;
+	uint64_t next_connection_id = WAKEUP_ID + 1;
+
+	uint64_t accepted_connections = 0;
+	uint64_t batch_count = 0;
+	uint64_t request_count = 0;
+
+public:
+	Command_Server(int epoll_fd, int listen_fd, int wakeup_fd, Worker_Pool &workers)
+		: epoll_fd(epoll_fd), listen_fd(listen_fd), wakeup_fd(wakeup_fd), workers(workers)
+	{
+	}
+
+	~Command_Server()
+	{
+		for (auto &[id, connection] : connections)
+		{
+			if (!connection.closed)
+			{
+				close(connection.fd);
+			}
+		}
+	}
+
+	// Handles events until stop is set.
+	void run(const std::atomic<bool> &stop)
+	{
+		epoll_event events[64];
+		while (!stop.load())
+		{
+			int count = epoll_wait(epoll_fd, events, 64, -1);
+			if (count < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				std::cerr << std::format("[ERROR] epoll_wait failed: {}\n", std::strerror(errno));
+				return;
+			}
+
+			for (int i = 0; i < count; i++)
+			{
+				uint64_t id = events[i].data.u64;
+				if (id == LISTENER_ID)
+				{
+					accept_connections();
+				}
+				else if (id == WAKEUP_ID)
+				{
+					uint64_t value;
+					(void)read(wakeup_fd, &value, sizeof(value));
+					complete_batches();
+				}
+				else
+				{
+					handle_connection(id, events[i].events);
+				}
+			}
+		}
+	}
+
+	void print_summary() const
+	{
+		std::cout << std::format("Served {} requests in {} batches ({:.1f} requests per batch) on {} "
+			"connections\n", request_count, batch_count,
+			batch_count ? (double)request_count / (double)batch_count : 0.0, accepted_connections);
+	}
+
+private:
+	void accept_connections()
+	{
+		while (true)
+		{
+			int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+			if (fd < 0)
+			{
+				if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				{
+					std::cerr << std::format("[ERROR] accept failed: {}\n", std::strerror(errno));
+				}
+				return;
+			}
+
+			uint64_t id = next_connection_id++;
+			Connection &connection = connections[id];
+			connection.fd = fd;
+			connection.events = EPOLLIN;
+			epoll_event event{ EPOLLIN, { .u64 = id } };
+			epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+			accepted_connections++;
+		}
+	}
+
+	void handle_connection(uint64_t id, uint32_t events)
+	{
+		auto found = connections.find(id);
+		if (found == connections.end() || found->second.closed)
+		{
+			return;
+		}
+		Connection &connection = found->second;
+
+		if (events & EPOLLIN)
+		{
+			char buffer[16 * 1024];
+			ssize_t size = read(connection.fd, buffer, sizeof(buffer));
+			if (size < 0 && errno != EAGAIN && errno != EINTR)
+			{
+				close_connection(id);
+				return;
+			}
+			if (size > 0)
+			{
+				connection.input.append(buffer, size);
+			}
+			else if (size == 0)
+			{
+				// The last request doesn't need a line break.
+				connection.input_closed = true;
+				if (!connection.input.empty() && !connection.input.ends_with('\n'))
+				{
+					connection.input += '\n';
+				}
+			}
+		}
+		else if (events & (EPOLLHUP | EPOLLERR))
+		{
+			close_connection(id);
+			return;
+		}
+
+		if ((events & EPOLLOUT) && !send_output(id))
+		{
+			return;
+		}
+
+		update_connection(id);
+	}
+
+	// Starts the next batch, and closes connections that have nothing left to do.
+	void update_connection(uint64_t id)
+	{
+		dispatch_batch(id);
+
+		// Sending an error may have closed the connection.
+		auto found = connections.find(id);
+		if (found == connections.end() || found->second.closed)
+		{
+			return;
+		}
+		Connection &connection = found->second;
+		if (connection.input_closed && !connection.batch_running && connection.output.empty())
+		{
+			close_connection(id);
+			return;
+		}
+		update_events(id);
+	}
+
+	// Hands the complete lines read so far to a worker, unless a batch is already running.
+	void dispatch_batch(uint64_t id)
+	{
+		Connection &connection = connections[id];
+		if (connection.batch_running || connection.output.size() - connection.output_sent >= MAX_BUFFERED_BYTES)
+		{
+			return;
+		}
+
+		size_t end = 0;
+		size_t lines = 0;
+		while (lines < MAX_BATCH_SIZE)
+		{
+			size_t newline = connection.input.find('\n', end);
+			if (newline == std::string::npos)
+			{
+				break;
+			}
+			end = newline + 1;
+			lines++;
+		}
+
+		if (lines == 0)
+		{
+			// A line that doesn't fit in the buffer is never going to end. Stop reading, and close
+			// the connection once the responses so far are sent.
+			if (connection.input.size() >= MAX_BUFFERED_BYTES)
+			{
+				connection.output += "ERROR The request is too long\n";
+				connection.input.clear();
+				connection.input_closed = true;
+				send_output(id);
+			}
+			return;
+		}
+
+		auto batch = std::make_unique<Batch>();
+		batch->connection_id = id;
+		batch->requests = connection.input.substr(0, end);
+		connection.input.erase(0, end);
+		connection.batch_running = true;
+		batch_count++;
+		request_count += lines;
+		workers.submit(std::move(batch));
+	}
+
+	void complete_batches()
+	{
+		for (auto &batch : workers.take_done())
+		{
+			uint64_t id = batch->connection_id;
+			Connection &connection = connections[id];
+			connection.batch_running = false;
+			if (connection.closed)
+			{
+				connections.erase(id);
+				continue;
+			}
+
+			connection.output += batch->responses;
+			if (!send_output(id))
+			{
+				continue;
+			}
+
+			// More requests may have arrived in the meantime.
+			update_connection(id);
+		}
+	}
+
+	// Sends as much of the output as the socket takes.
+	// Returns false if the connection was closed.
+	bool send_output(uint64_t id)
+	{
+		Connection &connection = connections[id];
+		while (connection.output_sent < connection.output.size())
+		{
+			ssize_t size = send(connection.fd, connection.output.data() + connection.output_sent,
+				connection.output.size() - connection.output_sent, MSG_NOSIGNAL);
+			if (size < 0)
+			{
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+				{
+					break;
+				}
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				close_connection(id);
+				return false;
+			}
+			connection.output_sent += size;
+		}
+
+		if (connection.output_sent == connection.output.size())
+		{
+			connection.output.clear();
+			connection.output_sent = 0;
+		}
+		return true;
+	}
+
+	// Reads while there's room for more input, and waits to write while there's output left.
+	void update_events(uint64_t id)
+	{
+		auto found = connections.find(id);
+		if (found == connections.end() || found->second.closed)
+		{
+			return;
+		}
+		Connection &connection = found->second;
+
+		uint32_t events = 0;
+		if (!connection.input_closed && connection.input.size() < MAX_BUFFERED_BYTES)
+		{
+			events |= EPOLLIN;
+		}
+		if (connection.output_sent < connection.output.size())
+		{
+			events |= EPOLLOUT;
+		}
+
+		if (events != connection.events)
+		{
+			epoll_event event{ events, { .u64 = id } };
+			epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection.fd, &event);
+			connection.events = events;
+		}
+	}
+
+	void close_connection(uint64_t id)
+	{
+		Connection &connection = connections[id];
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection.fd, nullptr);
+		close(connection.fd);
+
+		// The running batch still refers to the connection.
+		if (connection.batch_running)
+		{
+			connection.closed = true;
+			return;
+		}
+		connections.erase(id);
+	}
+};
+
+// Set from the signal handler, which also wakes the event loop.
+std::atomic<bool> stop_requested = false;
+int signal_wakeup_fd = -1;
+
+void handle_stop_signal(int)
+{
+	stop_requested.store(true);
+	uint64_t one = 1;
+	(void)write(signal_wakeup_fd, &one, sizeof(one));
+}
+
+void print_usage()
+{
+	std::cout << "Usage: cmd_server [socket_path] [--threads=N]\n"
+		"    socket_path defaults to /tmp/function_finder.sock. --threads defaults to one worker per "
+		"hardware thread.\n";
+}
+
+int main(int arg_count, const char **args)
+{
+	std::string socket_path = "/tmp/function_finder.sock";
+	size_t thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (int i = 1; i < arg_count; i++)
+	{
+		std::string_view arg = args[i];
+		int count = 0;
+		if (arg.starts_with("--threads=") && get_int(arg.substr(sizeof("--threads=") - 1), count) &&
+			count > 0)
+		{
+			thread_count = (size_t)count;
+		}
+		else if (!arg.starts_with("--"))
+		{
+			socket_path = arg;
+		}
+		else
+		{
+			print_usage();
+			return 1;
+		}
+	}
+
+	Function_Map commands;
+	init_server_commands(commands);
+
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(address.sun_path))
+	{
+		std::cerr << std::format("[ERROR] Socket path \"{}\" is too long\n", socket_path);
+		return 1;
+	}
+	std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+	int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	unlink(socket_path.c_str());
+	if (listen_fd < 0 || bind(listen_fd, (sockaddr *)&address, sizeof(address)) < 0 ||
+		listen(listen_fd, SOMAXCONN) < 0)
+	{
+		std::cerr << std::format("[ERROR] Could not listen on \"{}\": {}\n", socket_path,
+			std::strerror(errno));
+		return 1;
+	}
+
+	int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	int wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	epoll_event listen_event{ EPOLLIN, { .u64 = LISTENER_ID } };
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &listen_event);
+	epoll_event wakeup_event{ EPOLLIN, { .u64 = WAKEUP_ID } };
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &wakeup_event);
+
+	signal_wakeup_fd = wakeup_fd;
+	std::signal(SIGINT, handle_stop_signal);
+	std::signal(SIGTERM, handle_stop_signal);
+
+	std::cout << std::format("Serving {} commands on \"{}\" with {} worker threads. Stop with Ctrl+C\n",
+		commands.size(), socket_path, thread_count);
+
+	{
+		Worker_Pool workers(commands, wakeup_fd, thread_count);
+		Command_Server server(epoll_fd, listen_fd, wakeup_fd, workers);
+		server.run(stop_requested);
+		server.print_summary();
+	}
+
+	close(wakeup_fd);
+	close(epoll_fd);
+	close(listen_fd);
+	unlink(socket_path.c_str());
+	return 0;
+}
+
+// COMMANDS
+
+SERVER_COMMAND // Adds two numbers.
+int add(int a, int b)
+{
+	return a + b;
+}
+
+SERVER_COMMAND // Sums a list of numbers, like 'sum 1,2,3.5'.
+double sum(std::vector<double> values)
+{
+	double result = 0;
+	for (double value : values)
+	{
+		result += value;
+	}
+	return result;
+}
+
+SERVER_COMMAND // Repeats a text.
+std::string repeat(std::string text, int count)
+{
+	std::string result;
+	for (int i = 0; i < count; i++)
+	{
+		result += text;
+	}
+	return result;
+}
+
+SERVER_COMMAND // Returns the text it's given. Handy for measuring the server itself.
+std::string echo(std::string text = "")
+{
+	return text;
+}
+
+SERVER_COMMAND // Blocks its worker for a number of microseconds, like a command doing real work.
+int work(int microseconds)
+{
+	std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+	return microseconds;
+}
@@ -0,0 +1,243 @@
+// Load generator for cmd_server. Linux only.
+//
+// Opens a number of connections to the server, each on its own thread, and keeps a fixed number of
+// requests in flight on each of them: a new request is sent as soon as a response comes back. Then
+// reports the throughput and the latency distribution, measured from sending a request to reading
+// its response.
+//
+//     cmd_server_load /tmp/function_finder.sock --connections=4 --depth=32 --command="add 1 2"
+//
+// A depth of 1 measures the round trip of a single request. Higher depths pipeline requests, so
+// the server gets to batch them.
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <format>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "function_finder/function_finder.hpp"
+
+struct Load_Settings
+{
+	std::string socket_path = "/tmp/function_finder.sock";
+	size_t connections = 4;
+	size_t requests = 100000;
+	size_t depth = 16;
+	std::string command = "add 1 2";
+};
+
+// What one connection measured.
+struct Connection_Results
+{
+	// Nanoseconds from sending each request to reading its response.
+	std::vector<int64_t> latencies;
+	size_t errors = 0;
+	bool failed = false;
+};
+
+void run_connection(const Load_Settings &settings, size_t request_count, Connection_Results &out_results);
+bool parse_settings(int arg_count, const char **args, Load_Settings &out_settings);
+
+int main(int arg_count, const char **args)
+{
+	Load_Settings settings;
+	if (!parse_settings(arg_count, args, settings))
+	{
+		std::cout << "Usage: cmd_server_load [socket_path] [--connections=N] [--requests=N] [--depth=N] "
+			"[--command=<command line>]\n"
+			"    --requests is the total over all connections, --depth the requests each connection keeps "
+			"in flight.\n";
+		return 1;
+	}
+
+	std::vector<Connection_Results> results(settings.connections);
+	auto start = std::chrono::steady_clock::now();
+	{
+		std::vector<std::jthread> threads;
+		for (size_t i = 0; i < settings.connections; i++)
+		{
+			// Spread the requests evenly, the first connections take the remainder.
+			size_t count = settings.requests / settings.connections +
+				(i < settings.requests % settings.connections ? 1 : 0);
+			threads.emplace_back(run_connection, std::cref(settings), count, std::ref(results[i]));
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<int64_t> latencies;
+	size_t errors = 0;
+	for (const auto &result : results)
+	{
+		if (result.failed)
+		{
+			return 1;
+		}
+		latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+		errors += result.errors;
+	}
+	if (latencies.empty())
+	{
+		std::cout << "No requests were sent\n";
+		return 0;
+	}
+	std::sort(latencies.begin(), latencies.end());
+
+	auto percentile = [&latencies](double fraction)
+	{
+		size_t index = std::min((size_t)(fraction * (double)latencies.size()), latencies.size() - 1);
+		return (double)latencies[index] / 1e3;
+	};
+
+	std::cout << std::format("Sent {} requests of \"{}\" on {} connections, {} in flight each\n",
+		latencies.size(), settings.command, settings.connections, settings.depth);
+	std::cout << std::format("Throughput: {:.0f} requests/s over {:.3f} s, {} error responses\n",
+		(double)latencies.size() / seconds, seconds, errors);
+	std::cout << std::format("Latency (us): p50 {:.1f}, p90 {:.1f}, p99 {:.1f}, p99.9 {:.1f}, max {:.1f}\n",
+		percentile(0.5), percentile(0.9), percentile(0.99), percentile(0.999),
+		(double)latencies.back() / 1e3);
+	return 0;
+}
+
+void run_connection(const Load_Settings &settings, size_t request_count, Connection_Results &out_results)
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, settings.socket_path.c_str(),
+		std::min(settings.socket_path.size() + 1, sizeof(address.sun_path) - 1));
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0 || connect(fd, (sockaddr *)&address, sizeof(address)) < 0)
+	{
+		std::cerr << std::format("[ERROR] Could not connect to \"{}\": {}\n", settings.socket_path,
+			std::strerror(errno));
+		out_results.failed = true;
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+		return;
+	}
+
+	std::string request = settings.command + '\n';
+	std::deque<std::chrono::steady_clock::time_point> send_times;
+	out_results.latencies.reserve(request_count);
+
+	size_t sent = 0;
+	std::string output;
+	std::string input;
+	char buffer[64 * 1024];
+
+	while (out_results.latencies.size() < request_count)
+	{
+		// Top up the requests in flight, and send them all in one go.
+		output.clear();
+		auto now = std::chrono::steady_clock::now();
+		while (sent < request_count && send_times.size() < settings.depth)
+		{
+			output += request;
+			send_times.push_back(now);
+			sent++;
+		}
+		for (size_t written = 0; written < output.size();)
+		{
+			ssize_t size = send(fd, output.data() + written, output.size() - written, MSG_NOSIGNAL);
+			if (size < 0)
+			{
+				std::cerr << std::format("[ERROR] Sending failed: {}\n", std::strerror(errno));
+				out_results.failed = true;
+				close(fd);
+				return;
+			}
+			written += size;
+		}
+
+		ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+		if (size <= 0)
+		{
+			std::cerr << "[ERROR] The server closed the connection\n";
+			out_results.failed = true;
+			close(fd);
+			return;
+		}
+		now = std::chrono::steady_clock::now();
+		input.append(buffer, size);
+
+		// Responses come back in order, so every complete line answers the oldest request.
+		size_t start = 0;
+		for (size_t end = input.find('\n'); end != std::string::npos; end = input.find('\n', start))
+		{
+			if (!std::string_view(input).substr(start).starts_with("OK"))
+			{
+				out_results.errors++;
+			}
+			out_results.latencies.push_back(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(now - send_times.front()).count());
+			send_times.pop_front();
+			start = end + 1;
+		}
+		input.erase(0, start);
+	}
+
+	close(fd);
+}
+
+bool parse_settings(int arg_count, const char **args, Load_Settings &out_settings)
+{
+	for (int i = 1; i < arg_count; i++)
+	{
+		std::string_view arg = args[i];
+		auto get_count = [&arg](std::string_view option, size_t &out_count)
+		{
+			int count = 0;
+			if (!get_int(arg.substr(option.size()), count) || count < 1)
+			{
+				return false;
+			}
+			out_count = (size_t)count;
+			return true;
+		};
+
+		bool success = true;
+		if (arg.starts_with("--connections="))
+		{
+			success = get_count("--connections=", out_settings.connections);
+		}
+		else if (arg.starts_with("--requests="))
+		{
+			success = get_count("--requests=", out_settings.requests);
+		}
+		else if (arg.starts_with("--depth="))
+		{
+			success = get_count("--depth=", out_settings.depth);
+		}
+		else if (arg.starts_with("--command="))
+		{
+			out_settings.command = arg.substr(sizeof("--command=") - 1);
+			success = !out_settings.command.empty();
+		}
+		else if (!arg.starts_with("--"))
+		{
+			out_settings.socket_path = arg;
+		}
+		else
+		{
+			success = false;
+		}
+
+		if (!success)
+		{
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,146 @@
+// Runs commands from a shared library, and reloads the library whenever it's rebuilt, without
+// restarting.
+//
+//     hot_reload_host [library_path]
+//
+// Type commands like 'add 1 2'. Before each command the host checks whether the library changed,
+// and if so loads the new version and prints how long that took. Edit reloadable_commands.cpp,
+// rebuild the Hot_Reload_Commands target in another terminal, and run the command again.
+// 'reload' loads the library again even if it didn't change, 'help' lists the commands and 'quit'
+// exits.
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "function_finder/function_finder.hpp"
+#include "function_finder/hot_reload.hpp"
+#include "function_finder/pipeline.hpp"
+
+void print_loaded(const Command_Library &library, std::chrono::steady_clock::time_point start);
+void print_commands(const Command_Library &library);
+void print_call_result(const Call_Result &result);
+
+int main(int arg_count, const char **args)
+{
+	std::filesystem::path library_path = arg_count > 1 ? args[1] : HOT_RELOAD_LIBRARY_PATH;
+
+	Command_Library library(library_path);
+	auto start = std::chrono::steady_clock::now();
+	if (!library.load())
+	{
+		return 1;
+	}
+	print_loaded(library, start);
+	std::cout << "Type 'help' for the commands, 'reload' to reload them and 'quit' to exit\n";
+
+	std::string line;
+	std::vector<std::string> words;
+	while (true)
+	{
+		std::cout << "> " << std::flush;
+		if (!std::getline(std::cin, line))
+		{
+			break;
+		}
+
+		start = std::chrono::steady_clock::now();
+		if (library.reload_if_changed())
+		{
+			print_loaded(library, start);
+		}
+
+		words.clear();
+		if (!split_command_words(line, words))
+		{
+			std::cout << "A quote isn't closed\n";
+			continue;
+		}
+		if (words.empty())
+		{
+			continue;
+		}
+
+		if (words[0] == "quit")
+		{
+			break;
+		}
+		if (words[0] == "help")
+		{
+			print_commands(library);
+			continue;
+		}
+		if (words[0] == "reload")
+		{
+			if (library.load())
+			{
+				print_loaded(library, start);
+			}
+			continue;
+		}
+
+		std::string name = std::move(words[0]);
+		words.erase(words.begin());
+		Call_Result result;
+		if (!library.call(name, words, result))
+		{
+			std::cout << std::format("Unknown command \"{}\"\n", name);
+			continue;
+		}
+		print_call_result(result);
+	}
+	return 0;
+}
+
+void print_loaded(const Command_Library &library, std::chrono::steady_clock::time_point start)
+{
+	double milliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+	auto commands = library.get_commands();
+	std::cout << std::format("Loaded version {} of \"{}\", {} commands, in {:.2f} ms\n",
+		commands->generation, library.get_path().generic_string(), commands->functions.size(),
+		milliseconds);
+}
+
+void print_commands(const Command_Library &library)
+{
+	// Sorted, the map's order changes between versions.
+	auto commands = library.get_commands();
+	std::vector<const Function_Decl *> functions;
+	for (const auto &[name, function] : commands->functions)
+	{
+		functions.push_back(&function);
+	}
+	std::sort(functions.begin(), functions.end(),
+		[](const Function_Decl *a, const Function_Decl *b) { return a->name < b->name; });
+
+	for (const Function_Decl *function : functions)
+	{
+		std::string arguments;
+		for (const auto &argument : function->arguments)
+		{
+			arguments += std::format(" <{}>", argument.name);
+		}
+		std::cout << std::format("  {}{}: {}\n", function->name, arguments, function->note);
+	}
+}
+
+void print_call_result(const Call_Result &result)
+{
+	if (result.status != Call_Result_Status::SUCCESS)
+	{
+		std::cout << std::format("[ERROR] {}\n", result.error_message);
+	}
+	else if (result.value.type == Value_Type::STRING)
+	{
+		std::cout << result.string_value << '\n';
+	}
+	else if (result.value.type != Value_Type::VOID)
+	{
+		std::cout << to_string(result.value) << '\n';
+	}
+}
@@ -0,0 +1,42 @@
+// Commands built into a shared library, which hot_reload_host loads at runtime. Change one while
+// the host is running, rebuild the Hot_Reload_Commands target, and the host's next command runs
+// the new version.
+
+#include <string>
+#include <vector>
+
+// The search term for the reloadable commands
+#define RELOADABLE_COMMAND
+
+// Defines init_reloadable_commands and the exported function_finder_register_commands, which the
+// host calls after loading the library.
+#include "reloadable_commands_out.hpp"
+
+// COMMANDS
+
+RELOADABLE_COMMAND // Adds two numbers.
+int add(int a, int b)
+{
+	return a + b;
+}
+
+RELOADABLE_COMMAND // Greets someone. Try changing the greeting while the host is running.
+std::string greet(std::string name = "world")
+{
+	return "Hello, " + name + "!";
+}
+
+RELOADABLE_COMMAND // Averages a list of numbers, like 'average 1,2,3.5'.
+double average(std::vector<double> values)
+{
+	if (values.empty())
+	{
+		return 0;
+	}
+	double sum = 0;
+	for (double value : values)
+	{
+		sum += value;
+	}
+	return sum / (double)values.size();
+}